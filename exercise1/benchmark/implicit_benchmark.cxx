@@ -0,0 +1,522 @@
+/** headless contouring benchmark and batch converter. Each scene file (.isd or .isb) is
+    loaded into the scene without gui or render context and extracted at all combinations of
+    the given resolutions and thread counts. Timings are written as json and meshes and
+    volumes can be saved for batch conversion.
+
+    usage: task1_benchmark [options] scene files
+      --res=32,64,128        resolutions of the sampling grid
+      --threads=1,0          thread counts, where 0 selects the hardware concurrency
+      --contouring=mc|dc|sn  marching cubes, dual contouring or surface nets
+      --smoothing=n          relaxation iterations of surface nets
+      --decimate=n[,e]       decimate to n triangles with a maximum error of e relative to the
+                             cell size, where zero disables either bound
+      --grid=double|float32|float16|int16|int8[,sparse]
+                             storage of the samples, where sparse stores bricks far from the
+                             surface as a single value
+      --iso=a,b,c            extract the level sets at the given isovalues as shells from one
+                             sampling pass instead of the zero level set
+      --keys=file            keyframes of node parameters in the format of scene_animation
+      --frames=n             extract n frames evenly spaced over the keyframes, where each frame
+                             after the first only samples the blocks again that the animated
+                             nodes can influence
+      --repeat=n             extract n times per configuration and report the fastest run
+      --out=dir              write <scene>_<res>.<format> to dir, or <scene>_<res>_<shell>.<format>
+                             for several isovalues, where frames append _<frame> to <res>
+      --format=obj|ply|stl|ims
+                             mesh file format of the out dir, where ply and stl are binary and ims
+                             writes all frames to one mesh sequence cache <scene>_<res>.ims
+      --vox[=zero,one]       additionally write <scene>_<res>.vox and .hd to the out dir, where the
+                             values mapped to 0 and 255 default to those of the volume node, 1 and -1,
+                             and the function is sampled exactly instead of with the narrow band
+      --compare-base         additionally contour each shell with the streaming marching cubes or
+                             dual contouring of the framework, which the drawable offers as base
+                             contouring, and report its timing, mesh size and the distances of
+                             the vertices of either mesh to the nearest vertex of the other
+      --json=file            write the timings to file instead of task1_benchmark.json, which
+                             is not std::cout as the factory registration logs to it */
+
+#include "scene.h"
+#include "surface_extractor.h"
+#include "mesh_sequence_writer.h"
+#include "parallel.h"
+#include <cgv/utils/file.h>
+#include <cgv/media/mesh/marching_cubes.h>
+#include <cgv/media/mesh/dual_contouring.h>
+#include <unordered_map>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <iostream>
+#include <cstdlib>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+/// return the peak resident set size of the process in bytes
+static unsigned long long get_peak_rss()
+{
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS pmc;
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc)))
+		return pmc.PeakWorkingSetSize;
+	return 0;
+#else
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0)
+		return 0;
+#ifdef __APPLE__
+	return (unsigned long long)usage.ru_maxrss;
+#else
+	return 1024ull*usage.ru_maxrss;
+#endif
+#endif
+}
+
+/// parse a comma separated list of unsigned integers
+static bool parse_list(const std::string& s, std::vector<unsigned>& values)
+{
+	values.clear();
+	std::istringstream is(s);
+	std::string item;
+	while (std::getline(is, item, ',')) {
+		char* end;
+		unsigned long v = std::strtoul(item.c_str(), &end, 10);
+		if (item.empty() || *end != 0)
+			return false;
+		values.push_back(unsigned(v));
+	}
+	return !values.empty();
+}
+
+/// parse a comma separated list of numbers
+static bool parse_list(const std::string& s, std::vector<double>& values)
+{
+	values.clear();
+	std::istringstream is(s);
+	std::string item;
+	while (std::getline(is, item, ',')) {
+		char* end;
+		double v = std::strtod(item.c_str(), &end);
+		if (item.empty() || *end != 0)
+			return false;
+		values.push_back(v);
+	}
+	return !values.empty();
+}
+
+/// escape quotes and backslashes for a json string
+static std::string escape_json(const std::string& s)
+{
+	std::string r;
+	for (size_t i = 0; i < s.size(); ++i) {
+		if (s[i] == '"' || s[i] == '\\')
+			r += '\\';
+		r += s[i];
+	}
+	return r;
+}
+
+/// collects the vertices and polygons streamed by the contouring of the framework into an extracted mesh
+struct streamed_mesh_collector : public cgv::media::mesh::streaming_mesh_callback_handler
+{
+	/// streaming mesh that announces its vertices, which is the contouring object
+	const cgv::media::mesh::streaming_mesh<double>* source;
+	/// collected mesh
+	extracted_mesh mesh;
+	/// index in the collected mesh per streamed vertex index
+	std::unordered_map<unsigned, unsigned> vertex_indices;
+	streamed_mesh_collector() : source(0) {}
+	void new_vertex(unsigned int vi)
+	{
+		vertex_indices[vi] = unsigned(mesh.positions.size());
+		mesh.positions.push_back(source->vertex_location(vi));
+		mesh.normals.push_back(source->vertex_normal(vi));
+	}
+	void new_triangle(unsigned int vi, unsigned int vj, unsigned int vk)
+	{
+		std::vector<unsigned int> vis(1, vi);
+		vis.push_back(vj);
+		vis.push_back(vk);
+		new_polygon(vis);
+	}
+	void new_quad(unsigned int vi, unsigned int vj, unsigned int vk, unsigned int vl)
+	{
+		std::vector<unsigned int> vis(1, vi);
+		vis.push_back(vj);
+		vis.push_back(vk);
+		vis.push_back(vl);
+		new_polygon(vis);
+	}
+	void new_polygon(const std::vector<unsigned int>& vis)
+	{
+		for (size_t i = 0; i < vis.size(); ++i)
+			mesh.corner_vertices.push_back(vertex_indices[vis[i]]);
+		mesh.face_sizes.push_back(unsigned(vis.size()));
+	}
+};
+
+/// distances of the vertices of one mesh to the nearest vertex of another one relative to the cell size
+struct vertex_deviation
+{
+	/// largest and mean distance, where distances beyond one cell are counted as one cell
+	double max_distance, mean_distance;
+	/// number of vertices without a vertex of the other mesh closer than one cell
+	size_t nr_far_vertices;
+	vertex_deviation() : max_distance(0), mean_distance(0), nr_far_vertices(0) {}
+};
+
+/// measure the distances of the vertices of mesh to the nearest vertex of reference with a hash grid of cell_size
+static vertex_deviation measure_deviation(const extracted_mesh& mesh, const extracted_mesh& reference, double cell_size)
+{
+	vertex_deviation dev;
+	if (mesh.positions.empty())
+		return dev;
+	auto cell_key = [](int i, int j, int k) {
+		return (long long)(i & 0x1fffff) | ((long long)(j & 0x1fffff) << 21) | ((long long)(k & 0x1fffff) << 42);
+	};
+	std::unordered_map<long long, std::vector<unsigned> > cells;
+	for (unsigned vi = 0; vi < reference.positions.size(); ++vi) {
+		const extracted_mesh::pnt_type& p = reference.positions[vi];
+		cells[cell_key(int(std::floor(p(0) / cell_size)), int(std::floor(p(1) / cell_size)), int(std::floor(p(2) / cell_size)))].push_back(vi);
+	}
+	double sum = 0;
+	for (size_t vi = 0; vi < mesh.positions.size(); ++vi) {
+		const extracted_mesh::pnt_type& p = mesh.positions[vi];
+		int i = int(std::floor(p(0) / cell_size)), j = int(std::floor(p(1) / cell_size)), k = int(std::floor(p(2) / cell_size));
+		// all vertices closer than one cell lie in the neighboring hash cells
+		double min_sqr_dist = cell_size*cell_size;
+		for (int dk = -1; dk <= 1; ++dk)
+			for (int dj = -1; dj <= 1; ++dj)
+				for (int di = -1; di <= 1; ++di) {
+					auto iter = cells.find(cell_key(i + di, j + dj, k + dk));
+					if (iter == cells.end())
+						continue;
+					for (size_t ri = 0; ri < iter->second.size(); ++ri)
+						min_sqr_dist = std::min(min_sqr_dist, (reference.positions[iter->second[ri]] - p).sqr_length());
+				}
+		double dist = std::sqrt(min_sqr_dist) / cell_size;
+		if (dist >= 1)
+			++dev.nr_far_vertices;
+		dev.max_distance = std::max(dev.max_distance, dist);
+		sum += dist;
+	}
+	dev.mean_distance = sum / mesh.positions.size();
+	return dev;
+}
+
+static void show_usage()
+{
+	std::cerr << "usage: task1_benchmark [--res=32,64,128] [--threads=1,0] [--contouring=mc|dc|sn] [--smoothing=n]\n"
+	             "                       [--decimate=n[,e]] [--grid=double|float32|float16|int16|int8[,sparse]]\n"
+	             "                       [--iso=a,b,c] [--keys=file] [--frames=n] [--repeat=n] [--out=dir]\n"
+	             "                       [--format=obj|ply|stl|ims] [--vox[=zero,one]] [--compare-base] [--json=file]\n"
+	             "                       scene files (.isd or .isb)" << std::endl;
+}
+
+/// short names of the contouring methods used in arguments and json
+static const char* contouring_names[] = { "mc", "dc", "sn" };
+/// names of the sample encodings used in arguments and json
+static const char* encoding_names[] = { "double", "float32", "float16", "int16", "int8" };
+
+int main(int argc, char** argv)
+{
+	std::vector<unsigned> resolutions(1, 64), thread_counts(1, 0);
+	std::vector<double> isovalues(1, 0.0);
+	std::vector<std::string> file_names;
+	std::string out_dir, format = "obj", json_file_name = "task1_benchmark.json", keys_file_name;
+	unsigned nr_repetitions = 1, nr_frames = 0;
+	bool write_vox = false, compare_base = false;
+	std::vector<double> vox_range(1, 1.0);
+	vox_range.push_back(-1.0);
+	surface_extractor extractor;
+	for (int ai = 1; ai < argc; ++ai) {
+		std::string arg = argv[ai];
+		std::string value = arg.find('=') == std::string::npos ? std::string() : arg.substr(arg.find('=') + 1);
+		bool ok = true;
+		if (arg.compare(0, 6, "--res=") == 0)
+			ok = parse_list(value, resolutions);
+		else if (arg.compare(0, 10, "--threads=") == 0)
+			ok = parse_list(value, thread_counts);
+		else if (arg.compare(0, 13, "--contouring=") == 0) {
+			ok = value == "mc" || value == "dc" || value == "sn";
+			extractor.contouring = value == "dc" ? surface_extractor::DUAL_CONTOURING :
+				(value == "sn" ? surface_extractor::SURFACE_NETS : surface_extractor::MARCHING_CUBES);
+		}
+		else if (arg.compare(0, 12, "--smoothing=") == 0)
+			extractor.nr_smoothing_iters = std::atoi(value.c_str());
+		else if (arg.compare(0, 11, "--decimate=") == 0) {
+			char* end;
+			extractor.decimate = true;
+			extractor.target_nr_triangles = unsigned(std::strtoul(value.c_str(), &end, 10));
+			extractor.max_decimation_error = *end == ',' ? std::strtod(end + 1, &end) : 0;
+			ok = !value.empty() && *end == 0;
+		}
+		else if (arg.compare(0, 7, "--grid=") == 0) {
+			std::string name = value.substr(0, value.find(','));
+			extractor.sparse_grid = name != value;
+			ok = !extractor.sparse_grid || value.substr(name.size()) == ",sparse";
+			unsigned ei = 0;
+			while (ei < 5 && name != encoding_names[ei])
+				++ei;
+			ok = ok && ei < 5;
+			extractor.grid_encoding = sample_grid::sample_encoding(ok ? ei : 0);
+		}
+		else if (arg.compare(0, 6, "--iso=") == 0)
+			ok = parse_list(value, isovalues);
+		else if (arg.compare(0, 7, "--keys=") == 0)
+			keys_file_name = value;
+		else if (arg.compare(0, 9, "--frames=") == 0)
+			ok = (nr_frames = std::atoi(value.c_str())) > 0;
+		else if (arg.compare(0, 9, "--repeat=") == 0)
+			ok = (nr_repetitions = std::atoi(value.c_str())) > 0;
+		else if (arg.compare(0, 6, "--out=") == 0)
+			out_dir = value;
+		else if (arg.compare(0, 9, "--format=") == 0) {
+			format = value;
+			ok = format == "obj" || format == "ply" || format == "stl" || format == "ims";
+		}
+		else if (arg == "--vox")
+			write_vox = true;
+		else if (arg.compare(0, 6, "--vox=") == 0) {
+			write_vox = true;
+			ok = parse_list(value, vox_range) && vox_range.size() == 2 && vox_range[0] != vox_range[1];
+		}
+		else if (arg == "--compare-base")
+			compare_base = true;
+		else if (arg.compare(0, 7, "--json=") == 0)
+			json_file_name = value;
+		else if (arg.compare(0, 2, "--") == 0)
+			ok = false;
+		else
+			file_names.push_back(arg);
+		if (!ok) {
+			std::cerr << "invalid argument " << arg << std::endl;
+			show_usage();
+			return 1;
+		}
+	}
+	if (file_names.empty()) {
+		show_usage();
+		return 1;
+	}
+	if (write_vox && out_dir.empty()) {
+		std::cerr << "--vox needs an output directory given by --out" << std::endl;
+		return 1;
+	}
+	// the dumped samples have to be exact beyond the narrow band as well
+	if (write_vox)
+		extractor.bounded_sampling = false;
+	if (format == "ims" && nr_frames == 0)
+		nr_frames = 1;
+	if (compare_base && (extractor.contouring == surface_extractor::SURFACE_NETS || nr_frames > 0)) {
+		std::cerr << "--compare-base needs marching cubes or dual contouring without frames" << std::endl;
+		return 1;
+	}
+	scene_ptr s = ref_scene();
+	if (!keys_file_name.empty() && !s->ref_animation().read(keys_file_name)) {
+		std::cerr << "could not read keyframes from " << keys_file_name << std::endl;
+		return 1;
+	}
+	double start_time = 0, end_time = 0;
+	s->get_animation_range(start_time, end_time);
+
+	std::ostringstream json;
+	json << "{ \"runs\": [";
+	bool first_run = true, success = true;
+	for (size_t fi = 0; fi < file_names.size(); ++fi) {
+		if (!s->load_description(file_names[fi]) || !s->func_base_ptr) {
+			std::cerr << "could not load scene " << file_names[fi] << std::endl;
+			success = false;
+			continue;
+		}
+		std::string scene_name = cgv::utils::file::drop_extension(cgv::utils::file::get_file_name(file_names[fi]));
+		for (size_t ri = 0; ri < resolutions.size(); ++ri) {
+			extractor.res = resolutions[ri];
+			for (size_t ti = 0; ti < thread_counts.size(); ++ti) {
+				extractor.nr_threads = thread_counts[ti];
+				std::vector<extracted_mesh> meshes;
+				extraction_statistics stats, best_stats;
+				// totals over the frames of the fastest repetition of a sequence
+				double sequence_ms = 0;
+				unsigned long long sequence_evaluations = 0, sequence_reused_samples = 0;
+				std::string base_name = out_dir + "/" + scene_name + "_" + std::to_string(extractor.res);
+				for (unsigned rep = 0; rep < nr_repetitions; ++rep) {
+					if (nr_frames == 0) {
+						s->begin_evaluation();
+						extractor.extract_shells(*s, s->get_domain(), isovalues, meshes, stats);
+						s->end_evaluation();
+						if (rep == 0 || stats.total_ms < best_stats.total_ms)
+							best_stats = stats;
+						continue;
+					}
+					// the frames are written during the first repetition only
+					bool write_frames = rep == 0 && ti == 0 && !out_dir.empty();
+					mesh_sequence_writer writer;
+					if (write_frames && format == "ims" && !writer.open(base_name + ".ims", unsigned(isovalues.size()))) {
+						std::cerr << "could not write " << base_name << ".ims" << std::endl;
+						success = false;
+					}
+					double total_ms = 0;
+					unsigned long long nr_evaluations = 0, nr_reused_samples = 0;
+					for (unsigned frame = 0; frame < nr_frames; ++frame) {
+						double t = nr_frames > 1 ? start_time + (end_time - start_time)*frame / (nr_frames - 1) : start_time;
+						s->set_animation_time(t);
+						s->begin_evaluation();
+						if (frame == 0)
+							extractor.extract_shells(*s, s->get_domain(), isovalues, meshes, stats);
+						else
+							extractor.update_shells(*s, s->get_domain(), isovalues,
+								[&](const surface_extractor::box_type& block) { return s->may_differ_from_last_extraction(block); },
+								meshes, stats);
+						s->after_surface_extraction();
+						s->end_evaluation();
+						total_ms += stats.total_ms;
+						nr_evaluations += stats.nr_evaluations;
+						nr_reused_samples += stats.nr_reused_samples;
+						if (!write_frames)
+							continue;
+						if (format == "ims") {
+							success = writer.append_frame(t, meshes) && success;
+							continue;
+						}
+						std::ostringstream frame_name;
+						frame_name << base_name << "_" << std::setw(4) << std::setfill('0') << frame;
+						for (size_t si = 0; si < meshes.size(); ++si) {
+							std::string mesh_file_name = frame_name.str() + (meshes.size() > 1 ? "_" + std::to_string(si) : std::string()) + "." + format;
+							if (!meshes[si].write(mesh_file_name, extractor.nr_threads)) {
+								std::cerr << "could not write " << mesh_file_name << std::endl;
+								success = false;
+							}
+						}
+					}
+					if (write_frames && format == "ims" && !writer.close()) {
+						std::cerr << "could not write " << base_name << ".ims" << std::endl;
+						success = false;
+					}
+					if (rep == 0 || total_ms < sequence_ms) {
+						sequence_ms = total_ms;
+						sequence_evaluations = nr_evaluations;
+						sequence_reused_samples = nr_reused_samples;
+						best_stats = stats;
+					}
+				}
+				size_t nr_vertices = 0, nr_faces = 0, nr_triangles = 0;
+				for (size_t si = 0; si < meshes.size(); ++si) {
+					nr_vertices += meshes[si].positions.size();
+					nr_faces += meshes[si].face_sizes.size();
+					nr_triangles += meshes[si].get_nr_triangles();
+				}
+				double seconds = 0.001*best_stats.total_ms;
+				json << (first_run ? "\n" : ",\n") << "  { \"scene\": \"" << escape_json(file_names[fi])
+				     << "\", \"res\": " << extractor.res
+				     << ", \"threads\": " << get_nr_worker_threads(extractor.nr_threads)
+				     << ", \"contouring\": \"" << contouring_names[extractor.contouring]
+				     << "\", \"grid\": \"" << encoding_names[extractor.grid_encoding] << (extractor.sparse_grid ? ",sparse" : "")
+				     << "\", \"isovalues\": [";
+				for (size_t si = 0; si < isovalues.size(); ++si)
+					json << (si > 0 ? ", " : "") << isovalues[si];
+				json << "], \"vertices\": " << nr_vertices
+				     << ", \"faces\": " << nr_faces
+				     << ", \"triangles\": " << nr_triangles
+				     << ", \"evaluations_per_second\": " << (seconds > 0 ? best_stats.nr_evaluations / seconds : 0)
+				     << ", \"triangles_per_second\": " << (seconds > 0 ? nr_triangles / seconds : 0)
+				     << ", \"peak_rss\": " << get_peak_rss();
+				if (nr_frames > 0)
+					json << ", \"frames\": " << nr_frames
+					     << ", \"sequence_ms\": " << sequence_ms
+					     << ", \"sequence_evaluations\": " << sequence_evaluations
+					     << ", \"sequence_reused_samples\": " << sequence_reused_samples;
+				json << ", \"statistics\": ";
+				best_stats.write_json(json);
+				if (compare_base) {
+					// the framework contours the level sets of the same function on the same grid single threaded
+					const surface_extractor::box_type& domain = s->get_domain();
+					surface_extractor::vec_type extent = domain.get_extent();
+					double cell_size = std::max(extent(0), std::max(extent(1), extent(2))) / (extractor.res - 1);
+					double base_ms = 0;
+					size_t nr_base_vertices = 0, nr_base_faces = 0;
+					vertex_deviation deviation, base_deviation;
+					for (size_t si = 0; si < meshes.size(); ++si) {
+						std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+						s->begin_evaluation();
+						// the contouring object streams to the collector, which reads the vertices back from it
+						streamed_mesh_collector collector;
+						if (extractor.contouring == surface_extractor::MARCHING_CUBES) {
+							cgv::media::mesh::marching_cubes<double, double> mc(&*s, &collector, extractor.grid_epsilon, extractor.epsilon);
+							collector.source = &mc;
+							mc.extract(isovalues[si], domain, extractor.res, extractor.res, extractor.res);
+						}
+						else {
+							cgv::media::mesh::dual_contouring<double, double> dc(&*s, &collector, extractor.consistency_threshold, extractor.max_nr_iters, extractor.epsilon);
+							collector.source = &dc;
+							dc.extract(isovalues[si], domain, extractor.res, extractor.res, extractor.res);
+						}
+						s->end_evaluation();
+						base_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+						const extracted_mesh& base_mesh = collector.mesh;
+						nr_base_vertices += base_mesh.positions.size();
+						nr_base_faces += base_mesh.face_sizes.size();
+						// vertices split for face normals are compared like the others
+						vertex_deviation d = measure_deviation(meshes[si], base_mesh, cell_size), bd = measure_deviation(base_mesh, meshes[si], cell_size);
+						deviation.max_distance = std::max(deviation.max_distance, d.max_distance);
+						deviation.mean_distance += d.mean_distance / meshes.size();
+						deviation.nr_far_vertices += d.nr_far_vertices;
+						base_deviation.max_distance = std::max(base_deviation.max_distance, bd.max_distance);
+						base_deviation.mean_distance += bd.mean_distance / meshes.size();
+						base_deviation.nr_far_vertices += bd.nr_far_vertices;
+					}
+					json << ", \"base\": { \"total_ms\": " << base_ms
+					     << ", \"vertices\": " << nr_base_vertices
+					     << ", \"faces\": " << nr_base_faces
+					     << ", \"max_deviation\": " << deviation.max_distance
+					     << ", \"mean_deviation\": " << deviation.mean_distance
+					     << ", \"far_vertices\": " << deviation.nr_far_vertices
+					     << ", \"max_base_deviation\": " << base_deviation.max_distance
+					     << ", \"mean_base_deviation\": " << base_deviation.mean_distance
+					     << ", \"far_base_vertices\": " << base_deviation.nr_far_vertices << " }";
+					std::cerr << scene_name << " res=" << extractor.res << " base: " << base_ms << "ms, " << nr_base_vertices << " vertices, "
+					          << nr_base_faces << " faces, vertex deviation max " << std::max(deviation.max_distance, base_deviation.max_distance)
+					          << " mean " << deviation.mean_distance << "/" << base_deviation.mean_distance << " cells, "
+					          << deviation.nr_far_vertices + base_deviation.nr_far_vertices << " vertices beyond one cell" << std::endl;
+				}
+				json << " }";
+				first_run = false;
+				std::cerr << scene_name << " res=" << extractor.res << " threads=" << get_nr_worker_threads(extractor.nr_threads)
+				          << ": " << best_stats.total_ms << "ms, " << nr_triangles << " triangles";
+				if (nr_frames > 0)
+					std::cerr << ", " << nr_frames << " frames in " << sequence_ms << "ms with " << sequence_reused_samples << " reused samples";
+				std::cerr << std::endl;
+				// outputs only depend on the resolution, where the frames of sequences have been written already
+				if (ti > 0 || out_dir.empty())
+					continue;
+				for (size_t si = 0; si < meshes.size() && nr_frames == 0; ++si) {
+					std::string mesh_file_name = base_name + (meshes.size() > 1 ? "_" + std::to_string(si) : std::string()) + "." + format;
+					if (!meshes[si].write(mesh_file_name, extractor.nr_threads)) {
+						std::cerr << "could not write " << mesh_file_name << std::endl;
+						success = false;
+					}
+				}
+				if (write_vox && !extractor.write_volume(base_name + ".vox", vox_range[0], vox_range[1])) {
+					std::cerr << "could not write " << base_name << ".vox" << std::endl;
+					success = false;
+				}
+			}
+		}
+	}
+	json << "\n] }\n";
+
+	std::ofstream os(json_file_name.c_str());
+	os << json.str();
+	if (os.fail()) {
+		std::cerr << "could not write " << json_file_name << std::endl;
+		return 1;
+	}
+	return success ? 0 : 1;
+}
@@ -1,6 +1,6 @@
 ﻿#include <limits>
 #include <cgv/math/fvec.h>
-#include "implicit_group.h"
+#include "csg_node.h"
 
 // ======================================================================================
 //  Task 1.1b: GENERAL HINTS
@@ -15,7 +15,7 @@
 // ======================================================================================
 
 template <typename T>
-class union_node : public implicit_group<T>
+class union_node : public csg_node<T>
 {
 public:
 	typedef typename implicit_base<T>::vec_type vec_type;
@@ -54,7 +54,7 @@ public:
 };
 
 template <typename T>
-class intersection_node : public implicit_group<T>
+class intersection_node : public csg_node<T>
 {
 public:
 	typedef typename implicit_base<T>::vec_type vec_type;
@@ -93,7 +93,7 @@ public:
 };
 
 template <typename T>
-class difference_node : public implicit_group<T>
+class difference_node : public csg_node<T>
 {
 public:
 	typedef typename implicit_base<T>::vec_type vec_type;
@@ -0,0 +1,224 @@
+#pragma once
+
+#include <limits>
+#include <atomic>
+#include <deque>
+#include <algorithm>
+#include <thread>
+#include <functional>
+#include <cstdint>
+#include "implicit_group.h"
+
+/// statistics gathered for one child of a csg node during evaluation
+struct csg_child_statistics
+{
+	/// number of sampled evaluations of the child
+	std::atomic<unsigned> nr_evaluations;
+	/// number of sampled evaluations in which the child determined the result
+	std::atomic<unsigned> nr_selections;
+	/// construct with zero counts
+	csg_child_statistics() : nr_evaluations(0), nr_selections(0) {}
+};
+
+/// return whether the current evaluation is counted in the statistics. One in 32 evaluations is
+/// drawn at random per thread, such that the counters shared by all threads are touched rarely.
+inline bool sample_csg_statistics()
+{
+	static thread_local uint32_t state = uint32_t(std::hash<std::thread::id>()(std::this_thread::get_id())) | 1;
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+	return (state & 31) == 0;
+}
+
+/** common base of the csg operators. An operator whose value is first_sign times the maximum over
+    its children multiplied with first_sign for the first and other_sign for the other children
+    declares the signs by overloading get_child_signs. Bounded evaluations of such an operator
+    evaluate the children in an order that prefers cheap children that often determine the
+    result, pass the band on to them and, with short_circuit enabled, stop as soon as the maximum
+    reaches the upper end of the band, as the remaining children can only increase it further.
+    Operators that do not declare their signs are always evaluated with their own evaluate. */
+template <typename T>
+class csg_node : public implicit_group<T>
+{
+public:
+	typedef typename implicit_base<T>::vec_type vec_type;
+	typedef typename implicit_base<T>::pnt_type pnt_type;
+
+protected:
+	/// whether bounded evaluations pass the band on to the children and skip the remaining children once
+	/// the maximum is decided beyond it, where otherwise all children are evaluated exactly
+	bool short_circuit;
+	/// whether to reorder the children based on the gathered statistics
+	bool adapt_order;
+	/// order in which the children are evaluated
+	std::vector<unsigned> eval_order;
+	/// per child statistics, kept in a deque as atomics cannot be relocated
+	mutable std::deque<csg_child_statistics> statistics;
+
+	/// return index of the k-th child in evaluation order
+	unsigned get_ordered_child_index(unsigned k) const
+	{
+		return eval_order.size() == group::get_nr_children() ? eval_order[k] : k;
+	}
+	/// compute the maximum over the child values multiplied with first_sign for child 0 and other_sign for
+	/// all other children, which only needs to be exact inside [lo,hi] in the sense of evaluate_bounded,
+	/// and report the index of the maximizing child. With short_circuit enabled, children below the current
+	/// maximum need not be exact, such that the lower end of the band passed on to them rises with the maximum.
+	T evaluate_max(const pnt_type& p, unsigned int& selected_i, T first_sign, T other_sign, T lo, T hi) const
+	{
+		unsigned n = group::get_nr_children();
+		T value = -std::numeric_limits<T>::infinity();
+		selected_i = 0;
+		unsigned k = 0;
+		while (k < n) {
+			unsigned i = get_ordered_child_index(k++);
+			T sign = i == 0 ? first_sign : other_sign;
+			T child_lo = short_circuit ? std::max(lo, value) : lo;
+			T v = sign > 0 ?
+				implicit_group<T>::get_implicit_child(i)->evaluate_bounded(p, child_lo, hi) :
+				-implicit_group<T>::get_implicit_child(i)->evaluate_bounded(p, -hi, -child_lo);
+			if (v > value) {
+				value = v;
+				selected_i = i;
+			}
+			if (short_circuit && value >= hi)
+				break;
+		}
+		if (adapt_order && statistics.size() == n && sample_csg_statistics()) {
+			for (unsigned j = 0; j < k; ++j)
+				statistics[get_ordered_child_index(j)].nr_evaluations.fetch_add(1, std::memory_order_relaxed);
+			statistics[selected_i].nr_selections.fetch_add(1, std::memory_order_relaxed);
+		}
+		return value;
+	}
+
+public:
+	/// construct with short circuiting and adaptive child order enabled
+	csg_node() : short_circuit(true), adapt_order(true) {}
+	/// keep statistics and evaluation order in sync with the children
+	unsigned int append_child(base_ptr child)
+	{
+		unsigned i = implicit_group<T>::append_child(child);
+		statistics.emplace_back();
+		eval_order.push_back(i);
+		return i;
+	}
+	/// clear statistics and evaluation order together with the children
+	void remove_all_children()
+	{
+		implicit_group<T>::remove_all_children();
+		statistics.clear();
+		eval_order.clear();
+	}
+	/// descend into the child that determines the maximum if the signs are declared
+	implicit_base<T>* find_determining_leaf(const pnt_type& p)
+	{
+		T first_sign, other_sign;
+		if (group::get_nr_children() == 0 || !get_child_signs(first_sign, other_sign))
+			return implicit_group<T>::find_determining_leaf(p);
+		unsigned int i;
+		T inf = std::numeric_limits<T>::infinity();
+		evaluate_max(p, i, first_sign, other_sign, -inf, inf);
+		return implicit_group<T>::get_implicit_child(i)->find_determining_leaf(p);
+	}
+	/// operators that take the maximum over their signed children overload this to declare the signs
+	bool get_child_signs(T& first_sign, T& other_sign) const
+	{
+		return false;
+	}
+	/// evaluate the maximum over the signed children with the band mapped by the sign of the result
+	T evaluate_bounded(const pnt_type& p, T lo, T hi) const
+	{
+		T first_sign, other_sign;
+		if (group::get_nr_children() == 0 || !get_child_signs(first_sign, other_sign))
+			return this->evaluate(p);
+		// without short circuiting the children are evaluated exactly
+		if (!short_circuit) {
+			lo = -std::numeric_limits<T>::infinity();
+			hi = std::numeric_limits<T>::infinity();
+		}
+		unsigned int i;
+		return first_sign > 0 ?
+			evaluate_max(p, i, first_sign, other_sign, lo, hi) :
+			-evaluate_max(p, i, first_sign, other_sign, -hi, -lo);
+	}
+protected:
+	/// sort children by the rate of selections per evaluation cost in the statistics of a copy of either
+	/// precision and reset them there
+	template <typename S>
+	bool adapt_order_to(const implicit_base<S>& copy)
+	{
+		const csg_node<S>* src = dynamic_cast<const csg_node<S>*>(&copy);
+		unsigned n = group::get_nr_children();
+		if (!adapt_order || !src || src->statistics.size() != n || eval_order.size() != n)
+			return false;
+		std::vector<double> score(n);
+		for (unsigned i = 0; i < n; ++i) {
+			double nr_evals = src->statistics[i].nr_evaluations.exchange(0);
+			double nr_sels = src->statistics[i].nr_selections.exchange(0);
+			score[i] = (nr_sels + 1) / ((nr_evals + 2) * implicit_group<T>::get_implicit_child(i)->estimate_cost());
+		}
+		std::vector<unsigned> order = eval_order;
+		std::stable_sort(order.begin(), order.end(),
+			[&score](unsigned i, unsigned j) { return score[i] > score[j]; });
+		if (order == eval_order)
+			return false;
+		eval_order.swap(order);
+		return true;
+	}
+	/// take over the evaluation order of a node of either precision with the same children
+	template <typename S>
+	void copy_order(const implicit_base<S>& source)
+	{
+		const csg_node<S>* src = dynamic_cast<const csg_node<S>*>(&source);
+		if (src && src->eval_order.size() == eval_order.size())
+			eval_order = src->eval_order;
+	}
+	template <typename S>
+	friend class csg_node;
+public:
+	/// adapt the evaluation order to the statistics of a copy
+	bool adapt_to_statistics(const implicit_base<T>& copy)
+	{
+		return adapt_order_to(copy);
+	}
+	/// adapt the evaluation order to the statistics of a single precision copy
+	bool adapt_to_single_statistics(const implicit_base<float>& copy)
+	{
+		return adapt_order_to(copy);
+	}
+	/// a snapshot copy evaluates its children in the adapted order of the node it was copied from
+	void share_evaluation_data(const implicit_base<T>& source)
+	{
+		copy_order(source);
+	}
+	/// a single precision copy takes over the adapted order in the same way
+	void share_double_evaluation_data(const implicit_base<double>& source)
+	{
+		copy_order(source);
+	}
+	/// reflect members to expose them to serialization
+	bool self_reflect(cgv::reflect::reflection_handler& rh)
+	{
+		return
+			rh.reflect_member("short_circuit", short_circuit) &&
+			rh.reflect_member("adapt_order", adapt_order) &&
+			implicit_group<T>::self_reflect(rh);
+	}
+	/// restore the declaration order when adaption is switched off
+	void on_set(void* member_ptr)
+	{
+		if (member_ptr == &adapt_order && !adapt_order) {
+			for (unsigned i = 0; i < eval_order.size(); ++i)
+				eval_order[i] = i;
+		}
+		implicit_group<T>::on_set(member_ptr);
+	}
+	void create_gui()
+	{
+		provider::add_member_control(this, "short_circuit", short_circuit, "check");
+		provider::add_member_control(this, "adapt_order", adapt_order, "check");
+		implicit_group<T>::create_gui();
+	}
+};
@@ -1,6 +1,8 @@
 ﻿
 #include <cgv/math/fvec.h>
 #include "distance_surface.h"
+#include "parallel.h"
+#include <functional>
 
 // ======================================================================================
 //  Task 1.2: GENERAL HINTS
@@ -55,14 +57,55 @@ typename distance_surface<T>::vec_type distance_surface<T>::evaluate_gradient(co
 	return grad_f_p;
 }
 
+/// evaluation cost grows linearly with the number of skeleton edges
+template <typename T>
+double distance_surface<T>::estimate_cost() const
+{
+	return 1.0 + (skeleton<T>::edges).size();
+}
+
 /// update helper variables for edge i
 template <typename T>
 void distance_surface<T>::update_edge_precomputations(size_t ei)
 {
-	edge_vector[ei] =
-		  (knot_vector<T>::points)[(skeleton<T>::edges)[ei].second]
-		- (knot_vector<T>::points)[(skeleton<T>::edges)[ei].first];
-	edge_vector_inv_length[ei] = (T(1)/ edge_vector[ei].sqr_length()) * edge_vector[ei];
+	update_edge_range_precomputations(ei, ei + 1);
+}
+
+/// update helper variables of the edges in [begin,end) in a single pass over the edge arrays
+template <typename T>
+void distance_surface<T>::update_edge_range_precomputations(size_t begin, size_t end)
+{
+	const size_t block_size = 4096;
+	end = std::min(end, (skeleton<T>::edges).size());
+	if (begin >= end)
+		return;
+	// work on raw arrays such that the inner loop is free of bounds checks and aliasing
+	const pnt_type* points = (knot_vector<T>::points).empty() ? 0 : &(knot_vector<T>::points).front();
+	const typename skeleton<T>::edge_type* edges = &(skeleton<T>::edges).front();
+	vec_type* ev = &edge_vector.front();
+	vec_type* ev_inv = &edge_vector_inv_length.front();
+	size_t n = (knot_vector<T>::points).size();
+	auto update_block = [&](size_t block_begin, size_t block_end) {
+		for (size_t ei = block_begin; ei < block_end; ++ei) {
+			// points can be replaced before the edges that fit to them
+			if ((size_t)edges[ei].first >= n || (size_t)edges[ei].second >= n) {
+				ev[ei] = ev_inv[ei] = vec_type(0, 0, 0);
+				continue;
+			}
+			ev[ei] = points[edges[ei].second] - points[edges[ei].first];
+			T sqr_length = ev[ei].sqr_length();
+			ev_inv[ei] = sqr_length > 0 ? (T(1) / sqr_length) * ev[ei] : vec_type(0, 0, 0);
+		}
+	};
+	// edits from the gui update single edges, which are not worth handing to threads
+	if (end - begin <= block_size) {
+		update_block(begin, end);
+		return;
+	}
+	size_t nr_blocks = (end - begin + block_size - 1) / block_size;
+	parallel_for(nr_blocks, [&](size_t bi) {
+		update_block(begin + bi*block_size, std::min(end, begin + (bi + 1)*block_size));
+	});
 }
 
 /// construct distance surface
@@ -71,6 +114,8 @@ distance_surface<T>::distance_surface()
 {
 	r=0.5;
 	gui_title_added = false;
+	edge_precomputations_outdated = false;
+	nr_precomputed_points = 0;
 }
 /// reflect members to expose them to serialization
 template <typename T>
@@ -82,11 +127,11 @@ bool distance_surface<T>::self_reflect(cgv::reflect::reflection_handler& rh)
 }
 
 template <typename T>
-void distance_surface<T>::append_edge_callback(size_t ei)
+void distance_surface<T>::edges_appended_callback(size_t first)
 {
-	edge_vector.push_back(vec_type(0,0,0));
-	edge_vector_inv_length.push_back(vec_type(0,0,0));
-	update_edge_precomputations(ei);
+	edge_vector.resize((skeleton<T>::edges).size());
+	edge_vector_inv_length.resize((skeleton<T>::edges).size());
+	update_edge_range_precomputations(first, (skeleton<T>::edges).size());
 }
 template <typename T>
 void distance_surface<T>::edge_changed_callback(size_t ei)
@@ -101,6 +146,46 @@ void distance_surface<T>::position_changed_callback(size_t pi)
 			update_edge_precomputations(ei);
 }
 
+template <typename T>
+void distance_surface<T>::points_replaced_callback()
+{
+	edges_replaced_callback();
+}
+template <typename T>
+void distance_surface<T>::edges_replaced_callback()
+{
+	edge_vector.resize((skeleton<T>::edges).size());
+	edge_vector_inv_length.resize((skeleton<T>::edges).size());
+	update_edge_range_precomputations(0, (skeleton<T>::edges).size());
+	edge_precomputations_outdated = false;
+	nr_precomputed_points = (knot_vector<T>::points).size();
+}
+
+/// point coordinates set through reflection outdate the edges, as only the point selected in the gui is reported
+template <typename T>
+void distance_surface<T>::on_set(void* member_ptr)
+{
+	const std::vector<pnt_type>& points = knot_vector<T>::points;
+	if (!points.empty()) {
+		const char* mp = static_cast<const char*>(member_ptr);
+		const char* pb = reinterpret_cast<const char*>(&points.front());
+		std::less<const char*> less;
+		if (!less(mp, pb) && less(mp, pb + points.size()*sizeof(pnt_type)))
+			edge_precomputations_outdated = true;
+	}
+	skeleton<T>::on_set(member_ptr);
+}
+
+/// points appended or removed and edges removed through reflection are not reported by callbacks either
+template <typename T>
+void distance_surface<T>::prepare_node_evaluation()
+{
+	if (edge_precomputations_outdated || nr_precomputed_points != (knot_vector<T>::points).size() ||
+		edge_vector.size() != (skeleton<T>::edges).size())
+		edges_replaced_callback();
+	skeleton<T>::prepare_node_evaluation();
+}
+
 template <typename T>
 void distance_surface<T>::create_gui()
 {
@@ -15,6 +15,10 @@ protected:
 
 	/// precomputed edge properties
 	std::vector<vec_type> edge_vector, edge_vector_inv_length;
+	/// whether points changed without a callback, such that all edge properties are recomputed before the next evaluation
+	bool edge_precomputations_outdated;
+	/// number of points when all edge properties were computed the last time
+	size_t nr_precomputed_points;
 
 	/// compute vector from closest point on skeleton edge i to point p
 	vec_type get_edge_distance_vector(size_t i, const pnt_type &p) const;
@@ -24,6 +28,9 @@ protected:
 
 	/// update helper variables for edge i
 	virtual void update_edge_precomputations(size_t i);
+	/// update helper variables of the edges in [begin,end) in a single pass over the edge arrays, which is
+	/// split over several threads for large ranges only
+	virtual void update_edge_range_precomputations(size_t begin, size_t end);
 
 public:
 	/// construct distance surface
@@ -35,14 +42,23 @@ public:
 	bool self_reflect(cgv::reflect::reflection_handler& rh);
 
 	// various callbacks from parent interfaces skeleton and knot_vector
-	void append_edge_callback(size_t ei);
+	void edges_appended_callback(size_t first);
 	void edge_changed_callback(size_t ei);
 	void position_changed_callback(size_t pi);
+	void points_replaced_callback();
+	void edges_replaced_callback();
 
+	/// mark the edge helper variables as outdated if point coordinates are set through reflection, which
+	/// only reports the point selected in the gui to the position changed callback
+	void on_set(void* member_ptr);
+	/// recompute all edge helper variables once if the skeleton changed without callbacks
+	void prepare_node_evaluation();
 	/// evaluate the distance surface function at p
 	T evaluate(const pnt_type& p) const;
 	/// evaluate the gradient of the distance surface function at p
 	vec_type evaluate_gradient(const pnt_type& p) const;
+	/// evaluation cost grows linearly with the number of skeleton edges
+	double estimate_cost() const;
 
 protected:
 	/// allow derived classes to add the title of the gui
@@ -0,0 +1,146 @@
+#include "evaluation_profiler.h"
+
+/// add the counts of c
+void evaluation_profiler::counters::add(const counters& c)
+{
+	nr_evaluations += c.nr_evaluations;
+	nr_gradient_evaluations += c.nr_gradient_evaluations;
+	inclusive_time += c.inclusive_time;
+	exclusive_time += c.exclusive_time;
+}
+
+/// merge counters of the current session into the totals and zero them
+void evaluation_profiler::thread_table::merge()
+{
+	std::shared_ptr<shared_state> s = state.lock();
+	if (!s)
+		return;
+	std::lock_guard<std::mutex> lock(s->mutex);
+	if (session == s->session && node_counters.size() <= s->nodes.size())
+		for (size_t i = 0; i < node_counters.size(); ++i)
+			s->nodes[i].totals.add(node_counters[i]);
+	node_counters.assign(node_counters.size(), counters());
+}
+
+/// merge the remaining counters into the totals when the thread ends
+evaluation_profiler::thread_table::~thread_table()
+{
+	merge();
+}
+
+/// return the table of the calling thread prepared for the current session
+evaluation_profiler::thread_table& evaluation_profiler::get_thread_table()
+{
+	static thread_local thread_table table;
+	unsigned session = state->session;
+	if (table.state_ptr != state.get() || table.session != session) {
+		// counters of another profiler are handed over before the table is reused
+		if (table.state_ptr != state.get())
+			table.merge();
+		table.state = state;
+		table.state_ptr = state.get();
+		table.session = session;
+		table.node_counters.clear();
+	}
+	return table;
+}
+
+/// construct an empty profiler
+evaluation_profiler::evaluation_profiler() : state(new shared_state())
+{
+}
+
+/// start a new session without registered nodes
+void evaluation_profiler::clear()
+{
+	std::lock_guard<std::mutex> lock(state->mutex);
+	state->nodes.clear();
+	++state->session;
+}
+
+/// register a node and return its index
+unsigned evaluation_profiler::register_node(const std::string& name, const std::string& type_name, int parent)
+{
+	std::lock_guard<std::mutex> lock(state->mutex);
+	node_profile np;
+	np.name = name;
+	np.type_name = type_name;
+	np.parent = parent;
+	state->nodes.push_back(np);
+	return unsigned(state->nodes.size() - 1);
+}
+
+/// zero the totals of all registered nodes
+void evaluation_profiler::reset_counters()
+{
+	get_thread_table().merge();
+	std::lock_guard<std::mutex> lock(state->mutex);
+	for (size_t i = 0; i < state->nodes.size(); ++i)
+		state->nodes[i].totals = counters();
+}
+
+/// merge the counters of the calling thread and return the totals of all nodes
+std::vector<evaluation_profiler::node_profile> evaluation_profiler::collect()
+{
+	get_thread_table().merge();
+	std::lock_guard<std::mutex> lock(state->mutex);
+	return state->nodes;
+}
+
+/// escape quotes and backslashes for a json string
+static std::string escape_json(const std::string& s)
+{
+	std::string r;
+	for (size_t i = 0; i < s.size(); ++i) {
+		if (s[i] == '"' || s[i] == '\\')
+			r += '\\';
+		r += s[i];
+	}
+	return r;
+}
+
+/// write the totals of all nodes as json array
+void evaluation_profiler::write_json(std::ostream& os, const std::vector<node_profile>& nodes)
+{
+	os << "[\n";
+	for (size_t i = 0; i < nodes.size(); ++i) {
+		const node_profile& np = nodes[i];
+		os << "  { \"index\": " << i << ", \"parent\": " << np.parent
+		   << ", \"name\": \"" << escape_json(np.name) << "\", \"type\": \"" << escape_json(np.type_name)
+		   << "\", \"evaluations\": " << np.totals.nr_evaluations
+		   << ", \"gradient_evaluations\": " << np.totals.nr_gradient_evaluations
+		   << ", \"inclusive_ms\": " << 1e-6 * np.totals.inclusive_time
+		   << ", \"exclusive_ms\": " << 1e-6 * np.totals.exclusive_time << " }"
+		   << (i + 1 < nodes.size() ? ",\n" : "\n");
+	}
+	os << "]\n";
+}
+
+/// start measuring a function or gradient evaluation of the node with the given index
+evaluation_profiler::scope::scope(evaluation_profiler& profiler, unsigned _index, bool _gradient)
+	: table(profiler.get_thread_table()), index(_index), gradient(_gradient),
+	  parent_child_time(table.child_time), child_time(0)
+{
+	table.child_time = &child_time;
+	start = std::chrono::steady_clock::now();
+}
+
+/// stop measuring and account the time to the node and its parent
+evaluation_profiler::scope::~scope()
+{
+	unsigned long long t = (unsigned long long)std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now() - start).count();
+	table.child_time = parent_child_time;
+	if (parent_child_time)
+		*parent_child_time += t;
+	// nested scopes can grow the table, so the counters are looked up at the end
+	if (table.node_counters.size() <= index)
+		table.node_counters.resize(index + 1);
+	counters& node_counters = table.node_counters[index];
+	if (gradient)
+		++node_counters.nr_gradient_evaluations;
+	else
+		++node_counters.nr_evaluations;
+	node_counters.inclusive_time += t;
+	node_counters.exclusive_time += t > child_time ? t - child_time : 0;
+}
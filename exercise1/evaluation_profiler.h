@@ -0,0 +1,110 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <ostream>
+
+/** collects call counts and inclusive and exclusive evaluation times per scene node. Nodes
+    are registered once per profiling session and measured by profiled_node wrappers that
+    are only inserted into evaluation snapshots while profiling is enabled, such that the
+    unprofiled evaluation has no overhead. Measurements are counted in tables local to the
+    evaluating thread, which are merged into the totals when a thread ends and, for the
+    calling thread, in collect. */
+class evaluation_profiler
+{
+public:
+	/// accumulated measurements of one node
+	struct counters
+	{
+		/// number of function evaluations
+		unsigned long long nr_evaluations;
+		/// number of gradient evaluations
+		unsigned long long nr_gradient_evaluations;
+		/// time in nanoseconds including the time spent in profiled children
+		unsigned long long inclusive_time;
+		/// time in nanoseconds excluding the time spent in profiled children
+		unsigned long long exclusive_time;
+		/// construct with zero counts
+		counters() : nr_evaluations(0), nr_gradient_evaluations(0), inclusive_time(0), exclusive_time(0) {}
+		/// add the counts of c
+		void add(const counters& c);
+	};
+	/// registered node together with its totals
+	struct node_profile
+	{
+		/// node name
+		std::string name;
+		/// type name of the node
+		std::string type_name;
+		/// index of the parent node or -1 for the root
+		int parent;
+		/// measurements merged so far
+		counters totals;
+	};
+protected:
+	/// state shared with the thread tables, which can outlive the profiler
+	struct shared_state
+	{
+		std::mutex mutex;
+		/// incremented by clear to invalidate the thread tables of the previous session
+		std::atomic<unsigned> session;
+		std::vector<node_profile> nodes;
+		shared_state() : session(0) {}
+	};
+	/// per thread counters of the current session
+	struct thread_table
+	{
+		/// state of the profiler the counters belong to
+		std::weak_ptr<shared_state> state;
+		/// raw pointer to the state used to detect a change of the profiler without locking
+		const shared_state* state_ptr;
+		/// session of the counters
+		unsigned session;
+		/// counters indexed by node
+		std::vector<counters> node_counters;
+		/// accumulator of the child time of the innermost active measurement or 0
+		unsigned long long* child_time;
+		thread_table() : state_ptr(0), session(0), child_time(0) {}
+		/// merge the remaining counters into the totals when the thread ends
+		~thread_table();
+		/// merge counters of the current session into the totals and zero them
+		void merge();
+	};
+	/// return the table of the calling thread prepared for the current session
+	thread_table& get_thread_table();
+	/// registered nodes and totals
+	std::shared_ptr<shared_state> state;
+public:
+	/// construct an empty profiler
+	evaluation_profiler();
+	/// start a new session without registered nodes
+	void clear();
+	/// register a node and return its index
+	unsigned register_node(const std::string& name, const std::string& type_name, int parent);
+	/// zero the totals of all registered nodes
+	void reset_counters();
+	/// merge the counters of the calling thread and return the totals of all nodes
+	std::vector<node_profile> collect();
+	/// write the totals of all nodes as json array
+	static void write_json(std::ostream& os, const std::vector<node_profile>& nodes);
+
+	/// measures one evaluation of a node from construction to destruction
+	class scope
+	{
+		thread_table& table;
+		unsigned index;
+		bool gradient;
+		unsigned long long* parent_child_time;
+		unsigned long long child_time;
+		std::chrono::steady_clock::time_point start;
+	public:
+		/// start measuring a function or gradient evaluation of the node with the given index
+		scope(evaluation_profiler& profiler, unsigned index, bool gradient);
+		/// stop measuring and account the time to the node and its parent
+		~scope();
+	};
+};
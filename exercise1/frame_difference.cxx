@@ -0,0 +1,191 @@
+#include "frame_difference.h"
+#include <cgv/base/group.h>
+#include <cgv/base/named.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace cgv::base;
+
+/// skip the profiling wrappers above a snapshot node
+template <typename T>
+static implicit_base<T>* skip_wrappers(implicit_base<T>* fp)
+{
+	while (fp->get_base()->get_type_name() == "profiled_node") {
+		base* bp = fp->get_base();
+		group* g = bp->get_interface<group>();
+		if (!g || g->get_nr_children() != 1)
+			break;
+		fp = g->get_child(0)->template get_interface<implicit_base<T> >();
+	}
+	return fp;
+}
+
+/// compute the interval of sign times the values of f inside block. The value at the center converted to T
+/// is widened by the Lipschitz bound over a cube around it, whose half extent covers the distance from the
+/// converted center to all points of the block, and by a few ulps against rounding.
+template <typename T>
+static void get_signed_interval(implicit_base<T>* f, double sign, const cgv::media::axis_aligned_box<double, 3>& block, double& lo, double& hi)
+{
+	typedef typename implicit_base<T>::pnt_type pnt_type;
+	typedef typename implicit_base<T>::box_type box_type;
+	const double eps = std::numeric_limits<T>::epsilon();
+	cgv::math::fvec<double, 3> center = block.get_center();
+	pnt_type c(T(center(0)), T(center(1)), T(center(2)));
+	double radius = 0.5*block.get_extent().length(), magnitude = 0;
+	for (unsigned i = 0; i < 3; ++i) {
+		radius += std::abs(center(i) - double(c(i)));
+		magnitude = std::max(magnitude, std::abs(center(i)));
+	}
+	T half = T(radius*(1 + 4 * eps) + 4 * eps*magnitude);
+	box_type domain(c - pnt_type(half, half, half), c + pnt_type(half, half, half));
+	double v = sign*double(f->evaluate(c));
+	double w = double(f->lipschitz_bound(domain))*double(half);
+	if (std::isnan(v) || std::isnan(w)) {
+		lo = -std::numeric_limits<double>::infinity();
+		hi = std::numeric_limits<double>::infinity();
+		return;
+	}
+	double margin = 8 * eps*(std::abs(v) + w);
+	lo = v - w - margin;
+	hi = v + w + margin;
+}
+
+/// pair the nodes of the earlier and the later snapshot
+template <typename T>
+frame_difference<T>::frame_difference(implicit_type* before, implicit_type* after, const std::set<std::string>& changed_names)
+{
+	valid = before && after && pair_nodes(root, before, after, changed_names);
+}
+
+/// pair the subtrees of before and after and return false if their structure differs
+template <typename T>
+bool frame_difference<T>::pair_nodes(node_pair& np, implicit_type* before, implicit_type* after, const std::set<std::string>& changed_names)
+{
+	np.before = skip_wrappers(before);
+	np.after = skip_wrappers(after);
+	// copies of unchanged subtrees are shared between snapshots
+	if (np.before == np.after) {
+		np.changed = np.dirty = false;
+		np.first_sign = np.other_sign = 0;
+		return true;
+	}
+	base* bp = np.before->get_base();
+	base* ap = np.after->get_base();
+	std::string type_name = ap->get_type_name();
+	if (bp->get_type_name() != type_name)
+		return false;
+	const named* n = ap->get_named();
+	np.changed = n && changed_names.find(n->get_name()) != changed_names.end();
+	np.dirty = np.changed;
+	// operators that take the maximum over their signed children declare the signs
+	T first_sign, other_sign;
+	np.first_sign = np.other_sign = 0;
+	if (np.after->get_child_signs(first_sign, other_sign)) {
+		np.first_sign = first_sign;
+		np.other_sign = other_sign;
+	}
+	group* bg = bp->get_interface<group>();
+	group* ag = ap->get_interface<group>();
+	if (!bg || !ag)
+		return !bg && !ag;
+	if (bg->get_nr_children() != ag->get_nr_children())
+		return false;
+	np.children.resize(ag->get_nr_children());
+	for (unsigned i = 0; i < ag->get_nr_children(); ++i) {
+		if (!pair_nodes(np.children[i], bg->get_child(i)->template get_interface<implicit_type>(),
+			ag->get_child(i)->template get_interface<implicit_type>(), changed_names))
+			return false;
+		np.dirty = np.dirty || np.children[i].dirty;
+	}
+	return true;
+}
+
+/// return whether the functions can differ inside block
+template <typename T>
+bool frame_difference<T>::may_differ(const box_type& block) const
+{
+	return !valid || may_differ(root, block);
+}
+
+/// bound the points inside block mapped into the frame of the only child of f
+template <typename T>
+bool frame_difference<T>::get_child_block(const implicit_type* f, const box_type& block, box_type& child_block)
+{
+	typedef typename implicit_type::pnt_type pnt_type;
+	typedef typename implicit_type::box_type child_box_type;
+	// rounding to T is monotonic, such that the converted box contains all converted points of the block
+	const cgv::math::fvec<double, 3>& lo = block.get_min_pnt();
+	const cgv::math::fvec<double, 3>& hi = block.get_max_pnt();
+	child_box_type domain(pnt_type(T(lo(0)), T(lo(1)), T(lo(2))), pnt_type(T(hi(0)), T(hi(1)), T(hi(2)))), child_domain;
+	if (!f->get_child_domain(domain, child_domain))
+		return false;
+	// widen by a few ulps against the rounding of the mapped points
+	double magnitude = 0;
+	cgv::math::fvec<double, 3> child_lo, child_hi;
+	for (unsigned i = 0; i < 3; ++i) {
+		child_lo(i) = double(child_domain.get_min_pnt()(i));
+		child_hi(i) = double(child_domain.get_max_pnt()(i));
+		magnitude = std::max(magnitude, std::max(std::max(std::abs(lo(i)), std::abs(hi(i))), std::max(std::abs(child_lo(i)), std::abs(child_hi(i)))));
+	}
+	double margin = 16 * std::numeric_limits<T>::epsilon()*magnitude;
+	if (!(margin < std::numeric_limits<double>::infinity()))
+		return false;
+	for (unsigned i = 0; i < 3; ++i) {
+		// an empty or undefined mapped box gives no bound
+		if (!(child_lo(i) <= child_hi(i)))
+			return false;
+		child_lo(i) -= margin;
+		child_hi(i) += margin;
+	}
+	child_block = box_type(child_lo, child_hi);
+	return true;
+}
+
+/// return whether the subtree of np can differ inside block
+template <typename T>
+bool frame_difference<T>::may_differ(const node_pair& np, const box_type& block) const
+{
+	if (!np.dirty)
+		return false;
+	if (np.changed)
+		return true;
+	if (np.first_sign == 0) {
+		// an unchanged transformation evaluates its child at the same mapped points at both times
+		box_type child_block;
+		if (np.children.size() == 1 && get_child_block(np.after, block, child_block))
+			return may_differ(np.children[0], child_block);
+		return true;
+	}
+	// intervals of the signed children at both times, where unchanged children are evaluated once
+	size_t n = np.children.size();
+	std::vector<double> lo[2], hi[2];
+	double max_lo[2] = { -std::numeric_limits<double>::infinity(), -std::numeric_limits<double>::infinity() };
+	for (unsigned t = 0; t < 2; ++t) {
+		lo[t].resize(n);
+		hi[t].resize(n);
+		for (size_t i = 0; i < n; ++i) {
+			double sign = i == 0 ? np.first_sign : np.other_sign;
+			const node_pair& child = np.children[i];
+			if (t == 1 && !child.dirty) {
+				lo[1][i] = lo[0][i];
+				hi[1][i] = hi[0][i];
+			}
+			else
+				get_signed_interval(t == 0 ? child.before : child.after, sign, block, lo[t][i], hi[t][i]);
+			max_lo[t] = std::max(max_lo[t], lo[t][i]);
+		}
+	}
+	// a child that stays below the maximum at both times does not contribute, and the others only
+	// make a difference if they differ themselves
+	for (size_t i = 0; i < n; ++i) {
+		if (!np.children[i].dirty || (hi[0][i] < max_lo[0] && hi[1][i] < max_lo[1]))
+			continue;
+		if (may_differ(np.children[i], block))
+			return true;
+	}
+	return false;
+}
+
+template class frame_difference<double>;
+template class frame_difference<float>;
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <set>
+#include <string>
+#include <vector>
+#include "implicit_base.h"
+
+/** bounds the region in which the functions of two snapshots of the same node tree can
+    differ if only the parameters of the nodes with the given names differ between them, as
+    between two frames of a keyframed animation. Outside of the subtrees of changed nodes both
+    functions agree. An operator whose own parameters are unchanged and which declares with
+    get_child_signs that it takes the maximum over its signed children, as csg operators can,
+    is not influenced by a child inside a block if at both times the value interval of the
+    child over the block, i.e. its value at the block center widened by its Lipschitz bound
+    times the half diagonal, stays below the largest lower bound of the signed children. Only
+    the changed children that can influence the value are followed further. A transformation
+    whose own parameters are unchanged evaluates its child at the same mapped points at both
+    times, such that it is followed with the block mapped into the frame of the child. Nodes
+    shared by both snapshots agree everywhere. Profiling wrappers are skipped. */
+template <typename T>
+class frame_difference
+{
+public:
+	typedef implicit_base<T> implicit_type;
+	typedef cgv::media::axis_aligned_box<double, 3> box_type;
+protected:
+	/// corresponding nodes of both snapshots
+	struct node_pair
+	{
+		/// node of the earlier and of the later snapshot
+		implicit_type* before;
+		implicit_type* after;
+		/// whether the parameters of the node itself differ
+		bool changed;
+		/// whether the node or a node of its subtree differs
+		bool dirty;
+		/// sign of the first and of the other children for operators that declare them and zero for all other nodes
+		double first_sign, other_sign;
+		/// pairs of the children
+		std::vector<node_pair> children;
+	};
+	/// pair of the roots
+	node_pair root;
+	/// whether both node trees have the same structure
+	bool valid;
+	/// pair the subtrees of before and after and return false if their structure differs
+	bool pair_nodes(node_pair& np, implicit_type* before, implicit_type* after, const std::set<std::string>& changed_names);
+	/// return whether the subtree of np can differ inside block
+	bool may_differ(const node_pair& np, const box_type& block) const;
+	/// bound the points inside block mapped into the frame of the only child of f by f in child_block and
+	/// return false if f does not evaluate its child at mapped points
+	static bool get_child_block(const implicit_type* f, const box_type& block, box_type& child_block);
+public:
+	/// pair the nodes of the earlier and the later snapshot, where changed_names holds the names of all
+	/// nodes whose parameters differ
+	frame_difference(implicit_type* before, implicit_type* after, const std::set<std::string>& changed_names);
+	/// return whether the snapshots have the same structure, which is needed to exclude any block
+	bool is_valid() const { return valid; }
+	/// return whether the functions can differ inside block, where false guarantees equal values.
+	/// This only evaluates the snapshots and can be called from several threads.
+	bool may_differ(const box_type& block) const;
+};
@@ -5,8 +5,16 @@
 #include <cgv/gui/file_dialog.h>
 #include <cgv/base/register.h>
 #include <cgv/utils/file.h>
-#include <cgv/utils/stopwatch.h>
+#include <cgv/utils/scan.h>
+#include <cgv_gl/gl/gl.h>
+#include "mesh_buffer.h"
+#include "mesh_sequence_writer.h"
+#include "scene.h"
+#include <algorithm>
 #include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <chrono>
 
 using namespace cgv::gui;
 using namespace cgv::math;
@@ -15,6 +23,12 @@ using namespace cgv::signal;
 using namespace cgv::render::gl;
 using namespace cgv::media;
 
+/// colors given to the shells in the order of their isovalues
+static const float shell_palette[][3] = {
+	{ .25f, .45f, .85f }, { .85f, .35f, .25f }, { .35f, .75f, .35f },
+	{ .9f, .75f, .25f }, { .6f, .35f, .8f }, { .25f, .75f, .8f }
+};
+
 gl_implicit_surface_drawable::gl_implicit_surface_drawable() 
 {
 #ifdef _DEBUG
@@ -23,6 +37,24 @@ gl_implicit_surface_drawable::gl_implicit_surface_drawable()
 	res = 64;
 #endif
 	box_scale = 1.2f;
+	extraction_handler = 0;
+	nr_rebuild_requests = 0;
+	nr_executed_extractions = 0;
+	nr_smoothing_iters = 0;
+	use_base_contouring = false;
+	last_extraction_by_base = false;
+	quantize_mesh = false;
+	decimate_mesh = false;
+	target_nr_triangles = 0;
+	max_decimation_error = 0.1;
+	grid_encoding = sample_grid::DOUBLE_SAMPLES;
+	sparse_grid = false;
+	narrow_band_width = 4;
+	bounded_sampling = true;
+	nr_sequence_frames = 25;
+	samples_outdated = true;
+	meshes_outdated = true;
+	update_isovalues();
 
 	material.set_brdf_type((illum::BrdfType)(illum::BT_LAMBERTIAN | illum::BT_PHONG));
 	material.ref_diffuse_reflectance() = {.0625f, .25f, .45f};
@@ -36,6 +68,82 @@ gl_implicit_surface_drawable::gl_implicit_surface_drawable()
 	brs.material.ref_roughness() = .03125f;
 }
 
+/// set the function whose surface is extracted
+void gl_implicit_surface_drawable::set_extracted_function(F* f)
+{
+	set_function(f);
+}
+
+/// set the handler that is notified after each surface extraction
+void gl_implicit_surface_drawable::set_extraction_handler(surface_extraction_handler* eh)
+{
+	extraction_handler = eh;
+}
+
+/// request a surface extraction, which post_rebuild defers to the next frame
+void gl_implicit_surface_drawable::request_rebuild()
+{
+	samples_outdated = true;
+	request_contouring();
+}
+
+/// request an extraction after a change of the contouring parameters
+void gl_implicit_surface_drawable::request_contouring()
+{
+	meshes_outdated = true;
+	++nr_rebuild_requests;
+	update_member(&nr_rebuild_requests);
+	post_rebuild();
+}
+
+/// parse shell_isovalues into isovalues and give each shell a color
+void gl_implicit_surface_drawable::update_isovalues()
+{
+	std::string text = shell_isovalues;
+	std::replace(text.begin(), text.end(), ',', ' ');
+	std::istringstream is(text);
+	std::vector<double> values;
+	double v;
+	while (is >> v)
+		values.push_back(v);
+	if (!is.eof())
+		std::cerr << "invalid isovalues " << shell_isovalues << std::endl;
+	else
+		isovalues = values;
+	if (isovalues.empty())
+		isovalues.push_back(0);
+	// colors of existing shells are kept
+	size_t nr_palette_colors = sizeof(shell_palette) / sizeof(shell_palette[0]);
+	for (size_t si = shell_colors.size(); si < isovalues.size(); ++si) {
+		const float* c = shell_palette[si % nr_palette_colors];
+		shell_colors.push_back(shell_color_type(c[0], c[1], c[2]));
+	}
+	shell_colors.resize(isovalues.size());
+}
+
+/// append the vertices and faces of src to dst
+static void append_mesh(extracted_mesh& dst, const extracted_mesh& src)
+{
+	unsigned offset = unsigned(dst.positions.size());
+	dst.positions.insert(dst.positions.end(), src.positions.begin(), src.positions.end());
+	dst.normals.insert(dst.normals.end(), src.normals.begin(), src.normals.end());
+	for (size_t ci = 0; ci < src.corner_vertices.size(); ++ci)
+		dst.corner_vertices.push_back(src.corner_vertices[ci] + offset);
+	dst.face_sizes.insert(dst.face_sizes.end(), src.face_sizes.begin(), src.face_sizes.end());
+}
+
+/// write the meshes to a file, where several shells are written to files with the shell index appended to the name
+void gl_implicit_surface_drawable::write_meshes(const std::vector<extracted_mesh>& meshes, const std::string& file_name) const
+{
+	for (size_t si = 0; si < meshes.size(); ++si) {
+		std::string fn = file_name;
+		if (meshes.size() > 1)
+			fn = cgv::utils::file::drop_extension(file_name) + "_" + std::to_string(si) + "." + cgv::utils::file::get_extension(file_name);
+		if (!meshes[si].write(fn))
+			std::cerr << "could not write " << fn << std::endl;
+	}
+}
+
 std::string gl_implicit_surface_drawable::get_type_name() const
 {
 	return "implicit_surface";
@@ -58,6 +166,8 @@ void gl_implicit_surface_drawable::adjust_range()
 	// prepare progression
 	cgv::utils::progression prog;
 	prog.init("adjust range", res, 10);
+	if (extraction_handler)
+		extraction_handler->begin_evaluation();
 	
 	// iterate through all slices
 	bool set = false;
@@ -82,6 +192,8 @@ void gl_implicit_surface_drawable::adjust_range()
 			}
 		}
 	}
+	if (extraction_handler)
+		extraction_handler->end_evaluation();
 	update_member(&map_to_zero_value);
 	update_member(&map_to_one_value);
 }
@@ -100,6 +212,7 @@ void gl_implicit_surface_drawable::export_volume()
 	pnt_type scaling = box.get_extent(); // / pnt_type(res, res, res);
 
 	os << "Spacing:   " << scaling(0) << ", " << scaling(1) << ", " << scaling(2) << std::endl;
+	os << "Range:     " << map_to_zero_value << ", " << map_to_one_value << std::endl;
 	os.close();
 
 	std::vector<unsigned char> data;
@@ -111,6 +224,8 @@ void gl_implicit_surface_drawable::export_volume()
 	// prepare progression
 	cgv::utils::progression prog;
 	prog.init("export volume", res, 10);
+	if (extraction_handler)
+		extraction_handler->begin_evaluation();
 
 	// iterate through all slices
 	bool set = false;
@@ -141,33 +256,321 @@ void gl_implicit_surface_drawable::export_volume()
 			}
 		}
 	}
+	if (extraction_handler)
+		extraction_handler->end_evaluation();
 	cgv::utils::file::write(fn, (const char*)&data.front(), data.size());
 }
 
-/// callback used to save to obj file
+/// callback used to save the surface to a file in the format given by the extension
 void gl_implicit_surface_drawable::save_interactive()
 {
-	std::string fn = file_save_dialog("choose obj output file", "Obj Files (obj):*.obj|All Files:*.*");
+	std::string fn = file_save_dialog("choose mesh output file",
+		"Mesh Files (obj,ply,stl):*.obj;*.ply;*.stl|Obj Files (obj):*.obj|Ply Files (ply):*.ply|Stl Files (stl):*.stl|All Files:*.*");
 	if (fn.empty())
 		return;
-	std::ofstream os(fn.c_str());
-	if (os.fail())
-		return;
-	obj_out = &os;
-	normal_index = 0;
+	if (cgv::utils::file::get_extension(fn).empty())
+		fn += ".obj";
+	export_file_name = fn;
 	surface_extraction();
-	obj_out = 0;
+	export_file_name.clear();
 }
 
-void gl_implicit_surface_drawable::surface_extraction()
+/// configure the extractor and extract the meshes
+void gl_implicit_surface_drawable::extract_meshes(std::vector<extracted_mesh>& meshes)
+{
+	extractor.res = res;
+	// the contouring types of the base class are extended by surface nets
+	extractor.contouring = (surface_extractor::contouring_method)contouring_type;
+	extractor.nr_smoothing_iters = nr_smoothing_iters;
+	extractor.normals = (surface_extractor::normal_method)normal_computation_type;
+	extractor.normal_threshold = normal_threshold;
+	extractor.consistency_threshold = consistency_threshold;
+	extractor.max_nr_iters = max_nr_iters;
+	extractor.epsilon = epsilon;
+	extractor.grid_epsilon = grid_epsilon;
+	extractor.triangulate = triangulate;
+	extractor.decimate = decimate_mesh;
+	extractor.target_nr_triangles = target_nr_triangles;
+	extractor.max_decimation_error = max_decimation_error;
+	extractor.grid_encoding = grid_encoding;
+	extractor.sparse_grid = sparse_grid;
+	extractor.narrow_band_width = narrow_band_width;
+	extractor.bounded_sampling = bounded_sampling;
+
+	if (extraction_handler) {
+		extraction_handler->begin_evaluation();
+		if (samples_outdated && last_extraction_by_base)
+			extractor.extract_shells(*func_ptr, box, isovalues, meshes, extraction_stats);
+		else if (samples_outdated)
+			extractor.update_shells(*func_ptr, box, isovalues, [this](const surface_extractor::box_type& block) {
+				return extraction_handler->may_differ_from_last_extraction(block);
+			}, meshes, extraction_stats);
+		else
+			extractor.extract_shells(*func_ptr, box, isovalues, meshes, extraction_stats, true);
+	}
+	else
+		extractor.extract_shells(*func_ptr, box, isovalues, meshes, extraction_stats, !samples_outdated);
+	samples_outdated = meshes_outdated = last_extraction_by_base = false;
+	if (extraction_handler) {
+		extraction_handler->after_surface_extraction();
+		extraction_handler->end_evaluation();
+	}
+	++nr_executed_extractions;
+	update_member(&nr_executed_extractions);
+}
+
+/// contour the zero level set with the streaming marching cubes or dual contouring of the base class
+void gl_implicit_surface_drawable::base_surface_extraction()
 {
-	double time;
-	cgv::utils::stopwatch sw(&time);
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	if (extraction_handler)
+		extraction_handler->begin_evaluation();
 	gl_implicit_surface_drawable_base::surface_extraction();
-	time = sw.get_elapsed_time();
-	std::cout << "[CONTOURING] Surface extraction finished in " << time << "s." << std::endl;
+	if (extraction_handler) {
+		extraction_handler->after_surface_extraction();
+		extraction_handler->end_evaluation();
+	}
+	// the meshes of the extractor stay outdated, such that switching back extracts them anew, and their shells are not drawn
+	last_extraction_by_base = meshes_outdated = true;
+	extraction_stats = extraction_statistics();
+	extraction_stats.total_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	++nr_executed_extractions;
+	update_member(&nr_executed_extractions);
+	update_statistics_views();
+	std::cout << "[CONTOURING] Surface extraction of the base class finished in " << 0.001*extraction_stats.total_ms << "s." << std::endl;
+}
+
+void gl_implicit_surface_drawable::surface_extraction()
+{
+	if (!func_ptr)
+		return;
+	// mesh files are only written from the meshes of the surface extractor
+	if (use_base_contouring && (surface_extractor::contouring_method)contouring_type != surface_extractor::SURFACE_NETS && export_file_name.empty()) {
+		base_surface_extraction();
+		return;
+	}
+	// the uploaded shells stay valid until the meshes are outdated, whereas files are written from meshes extracted anew
+	bool to_file = !export_file_name.empty() || obj_out;
+	if (!meshes_outdated && !to_file)
+		return;
+	bool upload_outdated = meshes_outdated;
+	std::vector<extracted_mesh> meshes;
+	extract_meshes(meshes);
+	std::cout << "[CONTOURING] Surface extraction finished in " << 0.001*extraction_stats.total_ms << "s." << std::endl;
+	nr_faces = nr_vertices = 0;
+	for (size_t si = 0; si < meshes.size(); ++si) {
+		nr_faces += unsigned(meshes[si].face_sizes.size());
+		nr_vertices += unsigned(meshes[si].positions.size());
+	}
+	// extractions for export are not requested through request_rebuild
+	if (!export_file_name.empty())
+		write_meshes(meshes, export_file_name);
+	else if (obj_out) {
+		if (meshes.size() == 1)
+			meshes.front().write_obj(*obj_out);
+		else {
+			// the stream receives a single obj file, such that the shells are merged into one mesh
+			extracted_mesh merged;
+			for (size_t si = 0; si < meshes.size(); ++si)
+				append_mesh(merged, meshes[si]);
+			merged.write_obj(*obj_out);
+		}
+	}
+	else
+		upload_mesh(meshes);
+	// meshes written to a file are not uploaded, such that a pending upload is still done
+	if (to_file)
+		meshes_outdated = upload_outdated;
 	update_member(&nr_faces);
 	update_member(&nr_vertices);
+	update_statistics_views();
+}
+
+/// extract the frames of the animation of the function and write them to a mesh sequence cache or numbered mesh files
+bool gl_implicit_surface_drawable::extract_sequence(const std::string& file_name)
+{
+	double start, end;
+	if (!func_ptr || !extraction_handler || !extraction_handler->get_animation_range(start, end)) {
+		std::cerr << "the function has no keyframes" << std::endl;
+		return false;
+	}
+	bool to_cache = cgv::utils::to_lower(cgv::utils::file::get_extension(file_name)) == "ims";
+	mesh_sequence_writer writer;
+	if (to_cache && !writer.open(file_name, unsigned(isovalues.size()))) {
+		std::cerr << "could not write " << file_name << std::endl;
+		return false;
+	}
+	bool success = true;
+	std::vector<extracted_mesh> meshes;
+	unsigned nr_frames = std::max(1u, nr_sequence_frames);
+	for (unsigned fi = 0; fi < nr_frames; ++fi) {
+		double t = nr_frames > 1 ? start + (end - start)*fi / (nr_frames - 1) : start;
+		// consecutive frames only sample the blocks again that the animated nodes can influence
+		extraction_handler->set_animation_time(t);
+		samples_outdated = true;
+		extract_meshes(meshes);
+		std::cout << "[CONTOURING] Frame " << fi << " at time " << t << " extracted in " << 0.001*extraction_stats.total_ms
+		          << "s with " << extraction_stats.nr_reused_samples << " reused samples." << std::endl;
+		if (to_cache)
+			success = writer.append_frame(t, meshes) && success;
+		else {
+			std::ostringstream fn;
+			fn << cgv::utils::file::drop_extension(file_name) << "_" << std::setw(4) << std::setfill('0') << fi
+			   << "." << cgv::utils::file::get_extension(file_name);
+			write_meshes(meshes, fn.str());
+		}
+	}
+	if (to_cache && !writer.close()) {
+		std::cerr << "could not write " << file_name << std::endl;
+		success = false;
+	}
+	// the last frame is shown by contouring its samples again, as the meshes are not kept
+	meshes_outdated = true;
+	post_rebuild();
+	return success;
+}
+
+/// ask for a file name and extract the frames of the animation to it
+void gl_implicit_surface_drawable::extract_sequence_interactive()
+{
+	std::string fn = file_save_dialog("choose mesh sequence output file",
+		"Mesh Sequences (ims,obj,ply,stl):*.ims;*.obj;*.ply;*.stl|Mesh Sequence Cache (ims):*.ims|Obj Files (obj):*.obj|All Files:*.*");
+	if (fn.empty())
+		return;
+	if (cgv::utils::file::get_extension(fn).empty())
+		fn += ".ims";
+	extract_sequence(fn);
+}
+
+/// pack the meshes and send them to the buffers of the shells, such that GL holds them in packed form
+void gl_implicit_surface_drawable::upload_mesh(const std::vector<extracted_mesh>& meshes)
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	extraction_stats.packed_bytes = 0;
+	destruct_shells();
+	shells.resize(meshes.size());
+	mesh_buffer buffer;
+	for (size_t si = 0; si < meshes.size(); ++si) {
+		buffer.pack(meshes[si], box, quantize_mesh);
+		extraction_stats.packed_bytes += buffer.get_size();
+		shell_buffers& shell = shells[si];
+		shell.quantized = buffer.quantized;
+		shell.translation = buffer.translation;
+		shell.scale = buffer.scale;
+		shell.nr_vertices = unsigned(buffer.get_nr_vertices());
+		shell.nr_indices = unsigned(buffer.indices.size());
+		shell.face_sizes.swap(buffer.face_sizes);
+		glGenBuffers(1, &shell.vertex_buffer);
+		glGenBuffers(1, &shell.index_buffer);
+		if (shell.nr_indices == 0)
+			continue;
+		// positions are followed by the normals in the same buffer
+		size_t component_size = shell.quantized ? sizeof(short) : sizeof(float);
+		size_t array_size = 3 * component_size * shell.nr_vertices;
+		glBindBuffer(GL_ARRAY_BUFFER, shell.vertex_buffer);
+		glBufferData(GL_ARRAY_BUFFER, 2 * array_size, 0, GL_STATIC_DRAW);
+		glBufferSubData(GL_ARRAY_BUFFER, 0, array_size, shell.quantized ?
+			(const void*)&buffer.quantized_positions.front() : (const void*)&buffer.positions.front());
+		glBufferSubData(GL_ARRAY_BUFFER, array_size, array_size, shell.quantized ?
+			(const void*)&buffer.quantized_normals.front() : (const void*)&buffer.normals.front());
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, shell.index_buffer);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, shell.nr_indices * sizeof(unsigned), &buffer.indices.front(), GL_STATIC_DRAW);
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	extraction_stats.upload_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+/// delete the buffers of all shells
+void gl_implicit_surface_drawable::destruct_shells()
+{
+	for (size_t si = 0; si < shells.size(); ++si) {
+		glDeleteBuffers(1, &shells[si].vertex_buffer);
+		glDeleteBuffers(1, &shells[si].index_buffer);
+	}
+	shells.clear();
+}
+
+/// draw the shells from their buffers after the parts drawn by the base class
+void gl_implicit_surface_drawable::draw(cgv::render::context& ctx)
+{
+	gl_implicit_surface_drawable_base::draw(ctx);
+	if (last_extraction_by_base || shells.empty())
+		return;
+	ctx.ref_surface_shader_program().enable(ctx);
+	ctx.set_material(material);
+	glPushAttrib(GL_ENABLE_BIT | GL_POLYGON_BIT);
+	if (show_wireframe)
+		glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glEnableClientState(GL_NORMAL_ARRAY);
+	// several shells are told apart by their colors, which replace the diffuse reflectance of the material
+	if (shells.size() > 1) {
+		glEnable(GL_COLOR_MATERIAL);
+		glColorMaterial(GL_FRONT_AND_BACK, GL_AMBIENT_AND_DIFFUSE);
+	}
+	for (size_t si = 0; si < shells.size(); ++si) {
+		const shell_buffers& shell = shells[si];
+		if (shell.nr_indices == 0)
+			continue;
+		if (shells.size() > 1)
+			glColor3fv(&shell_colors[si][0]);
+		glBindBuffer(GL_ARRAY_BUFFER, shell.vertex_buffer);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, shell.index_buffer);
+		if (shell.quantized) {
+			glPushMatrix();
+			glTranslated(shell.translation(0), shell.translation(1), shell.translation(2));
+			glScaled(shell.scale(0), shell.scale(1), shell.scale(2));
+			glEnable(GL_NORMALIZE);
+			glVertexPointer(3, GL_SHORT, 0, 0);
+			glNormalPointer(GL_SHORT, 0, (const void*)(3 * sizeof(short) * size_t(shell.nr_vertices)));
+		}
+		else {
+			glVertexPointer(3, GL_FLOAT, 0, 0);
+			glNormalPointer(GL_FLOAT, 0, (const void*)(3 * sizeof(float) * size_t(shell.nr_vertices)));
+		}
+		if (shell.face_sizes.empty())
+			glDrawElements(GL_TRIANGLES, (int)shell.nr_indices, GL_UNSIGNED_INT, 0);
+		else {
+			for (size_t fi = 0, ci = 0; fi < shell.face_sizes.size(); ci += shell.face_sizes[fi], ++fi)
+				glDrawElements(GL_POLYGON, (int)shell.face_sizes[fi], GL_UNSIGNED_INT, (const void*)(ci * sizeof(unsigned)));
+		}
+		if (shell.quantized)
+			glPopMatrix();
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	glDisableClientState(GL_NORMAL_ARRAY);
+	glDisableClientState(GL_VERTEX_ARRAY);
+	glPopAttrib();
+	ctx.ref_surface_shader_program().disable(ctx);
+}
+
+/// delete the buffers of the shells together with the GL objects of the base class
+void gl_implicit_surface_drawable::clear(cgv::render::context& ctx)
+{
+	destruct_shells();
+	gl_implicit_surface_drawable_base::clear(ctx);
+}
+
+/// update the views of the extraction statistics
+void gl_implicit_surface_drawable::update_statistics_views()
+{
+	update_member(&extraction_stats.sampling_ms);
+	update_member(&extraction_stats.classification_ms);
+	update_member(&extraction_stats.vertex_ms);
+	update_member(&extraction_stats.decimation_ms);
+	update_member(&extraction_stats.normal_ms);
+	update_member(&extraction_stats.upload_ms);
+	update_member(&extraction_stats.packed_bytes);
+	update_member(&extraction_stats.total_ms);
+	update_member(&extraction_stats.nr_evaluations);
+	update_member(&extraction_stats.nr_refined_samples);
+	update_member(&extraction_stats.nr_gradient_evaluations);
+	update_member(&extraction_stats.nr_cells);
+	update_member(&extraction_stats.nr_active_cells);
+	update_member(&extraction_stats.nr_collapses);
+	update_member(&extraction_stats.peak_memory);
 }
 
 void gl_implicit_surface_drawable::build_display_list()
@@ -185,7 +588,7 @@ void gl_implicit_surface_drawable::resolution_change()
 		find_control(iy)->set("max",res-1);
 		find_control(iz)->set("max",res-1);
 	}
-	post_rebuild();
+	request_contouring();
 }
 
 /// you must overload this for gui creation
@@ -193,14 +596,44 @@ void gl_implicit_surface_drawable::create_gui()
 {
 	if (begin_tree_node("Tesselation", triangulate)) {
 		align("\a");
-		connect_copy(add_button("save to obj")->click, rebind(this, &gl_implicit_surface_drawable::save_interactive));
+		connect_copy(add_button("save mesh")->click, rebind(this, &gl_implicit_surface_drawable::save_interactive));
 		add_member_control(this, "triangulate", triangulate, "check");
+		add_member_control(this, "quantize", quantize_mesh, "check");
+		add_member_control(this, "decimate", decimate_mesh, "check");
+		add_member_control(this, "target_triangles", target_nr_triangles, "value_slider", "min=0;max=1000000;log=true;ticks=true");
+		add_member_control(this, "max_error", max_decimation_error, "value_slider", "min=0;max=1;log=true;ticks=true");
 		add_view("nr_vertices", nr_vertices);
 		add_view("nr_faces", nr_faces);
+		add_view("sampling ms", extraction_stats.sampling_ms);
+		add_view("classification ms", extraction_stats.classification_ms);
+		add_view("vertex ms", extraction_stats.vertex_ms);
+		add_view("decimation ms", extraction_stats.decimation_ms);
+		add_view("normal ms", extraction_stats.normal_ms);
+		add_view("upload ms", extraction_stats.upload_ms);
+		add_view("packed bytes", extraction_stats.packed_bytes);
+		add_view("total ms", extraction_stats.total_ms);
+		add_view("evaluations", extraction_stats.nr_evaluations);
+		add_view("refined samples", extraction_stats.nr_refined_samples);
+		add_view("reused samples", extraction_stats.nr_reused_samples);
+		add_view("gradients", extraction_stats.nr_gradient_evaluations);
+		add_view("cells", extraction_stats.nr_cells);
+		add_view("active cells", extraction_stats.nr_active_cells);
+		add_view("collapses", extraction_stats.nr_collapses);
+		add_view("peak memory", extraction_stats.peak_memory);
+		add_view("rebuild_requests", nr_rebuild_requests);
+		add_view("extractions", nr_executed_extractions);
 		end_tree_node(triangulate);
 		align("\b");
 	}
 
+	if (begin_tree_node("Sequence Export", nr_sequence_frames)) {
+		align("\a");
+		add_member_control(this, "frames", nr_sequence_frames, "value_slider", "min=1;max=1000;log=true;ticks=true");
+		connect_copy(add_button("extract sequence")->click, rebind(this, &gl_implicit_surface_drawable::extract_sequence_interactive));
+		end_tree_node(nr_sequence_frames);
+		align("\b");
+	}
+
 	if (begin_tree_node("Volume Export", map_to_zero_value)) {
 		align("\a");
 		connect_copy(add_button("toggle range")->click, rebind(this, &gl_implicit_surface_drawable::toggle_range));
@@ -218,12 +651,21 @@ void gl_implicit_surface_drawable::create_gui()
 		add_member_control(this, "gradient normals", show_gradient_normals, "check");
 		add_member_control(this, "mesh normals", show_mesh_normals, "check");
 		add_member_control(this, "threshold", normal_threshold, "value_slider", "min=-1;max=1;ticks=true");
-		add_member_control(this, "contouring", contouring_type, "dropdown", "enums='marching cubes,dual contouring'");
+		add_member_control(this, "contouring", contouring_type, "dropdown", "enums='marching cubes,dual contouring,surface nets'");
+		add_member_control(this, "base contouring", use_base_contouring, "check");
+		add_member_control(this, "smoothing_iters", nr_smoothing_iters, "value_slider", "min=0;max=10;ticks=true");
 		add_member_control(this, "consistency_threshold", consistency_threshold, "value_slider", "min=0.00001;max=1;log=true;ticks=true");
 		add_member_control(this, "max_nr_iters", max_nr_iters, "value_slider", "min=1;max=20;ticks=true");
 		add_member_control(this, "res", res, "value_slider", "min=4;max=100;log=true;ticks=true");
 		add_member_control(this, "epsilon", epsilon, "value_slider", "min=0;max=0.001;log=true;ticks=true");
 		add_member_control(this, "grid_epsilon", grid_epsilon, "value_slider", "min=0;max=0.5;log=true;ticks=true");
+		add_member_control(this, "grid storage", grid_encoding, "dropdown", "enums='double,float32,float16,int16 band,int8 band'");
+		add_member_control(this, "sparse grid", sparse_grid, "check");
+		add_member_control(this, "band width", narrow_band_width, "value_slider", "min=1;max=64;log=true;ticks=true");
+		add_member_control(this, "bounded sampling", bounded_sampling, "check");
+		add_member_control(this, "isovalues", shell_isovalues);
+		for (size_t si = 0; si < shell_colors.size() && isovalues.size() > 1; ++si)
+			add_member_control(this, "shell " + std::to_string(si) + " color", shell_colors[si]);
 		end_tree_node(contouring_type);
 		align("\b");
 	}
@@ -268,6 +710,16 @@ bool gl_implicit_surface_drawable::self_reflect(cgv::reflect::reflection_handler
 		rh.reflect_member("normal_threshold", normal_threshold) &&
 		rh.reflect_member("consistency_threshold", consistency_threshold) &&
 		rh.reflect_member("max_nr_iters", max_nr_iters) &&
+		rh.reflect_member("nr_smoothing_iters", nr_smoothing_iters) &&
+		rh.reflect_member("use_base_contouring", use_base_contouring) &&
+		rh.reflect_member("quantize_mesh", quantize_mesh) &&
+		rh.reflect_member("decimate_mesh", decimate_mesh) &&
+		rh.reflect_member("target_nr_triangles", target_nr_triangles) &&
+		rh.reflect_member("max_decimation_error", max_decimation_error) &&
+		rh.reflect_member("sparse_grid", sparse_grid) &&
+		rh.reflect_member("narrow_band_width", narrow_band_width) &&
+		rh.reflect_member("bounded_sampling", bounded_sampling) &&
+		rh.reflect_member("shell_isovalues", shell_isovalues) &&
 //		rh.reflect_member("normal_computation_type", normal_computation_type) &&
 		rh.reflect_member("ix", ix) &&
 		rh.reflect_member("iy", iy) &&
@@ -281,6 +733,7 @@ bool gl_implicit_surface_drawable::self_reflect(cgv::reflect::reflection_handler
 		rh.reflect_member("show_mesh_normals", show_mesh_normals) &&
 		rh.reflect_member("epsilon", epsilon) &&
 		rh.reflect_member("grid_epsilon", grid_epsilon) &&
+		rh.reflect_member("nr_sequence_frames", nr_sequence_frames) &&
 		rh.reflect_member("material_roughness", material.ref_roughness());
 }
 
@@ -303,10 +756,25 @@ void gl_implicit_surface_drawable::on_set(void* p)
 	}
 	if (p == &res)
 		resolution_change();
+	else if (p == &shell_isovalues) {
+		size_t nr_shells = isovalues.size();
+		update_isovalues();
+		if (isovalues.size() != nr_shells)
+			post_recreate_gui();
+		request_contouring();
+	}
 	else if (p == &contouring_type || p == &res || p == &normal_threshold || p == &consistency_threshold || 
-		 p == &max_nr_iters || p == &normal_computation_type || p == &epsilon ||
-		 p == &grid_epsilon || (p >= &box && p < &box+1) )
-		   post_rebuild();
+		 p == &max_nr_iters || p == &nr_smoothing_iters || p == &normal_computation_type || p == &epsilon ||
+		 p == &grid_epsilon || p == &decimate_mesh || p == &target_nr_triangles || p == &max_decimation_error ||
+		 p == &grid_encoding || p == &sparse_grid || p == &narrow_band_width || p == &bounded_sampling ||
+		 p == &use_base_contouring ||
+		 (p >= &box && p < &box+1) )
+		   request_contouring();
+	// the packed form is uploaded from meshes contoured again, whereas colors are applied when drawing
+	else if (p == &quantize_mesh)
+		request_contouring();
+	else if (!shell_colors.empty() && p >= &shell_colors.front() && p < &shell_colors.front() + shell_colors.size())
+		post_redraw();
 	else if (p == &ix || p == &iy || p == &iz || p == &show_wireframe || p == &show_sampling_grid ||
 	    p == &show_sampling_locations || p == &show_box || p == &show_mini_box || 
 		 p == &show_gradient_normals || p == &show_mesh_normals)
@@ -316,3 +784,11 @@ void gl_implicit_surface_drawable::on_set(void* p)
 
 	update_member(p);
 }
+
+/// attach a drawable to the scene when the plugin is loaded, such that headless builds of the scene do not depend on GL
+struct gl_implicit_surface_drawable_registration
+{
+	gl_implicit_surface_drawable_registration() { ref_scene()->set_extraction_driver(new gl_implicit_surface_drawable()); }
+};
+
+gl_implicit_surface_drawable_registration gl_implicit_surface_drawable_reg;
@@ -3,33 +3,154 @@
 #include <cgv_gl/gl/gl_implicit_surface_drawable_base.h>
 #include <cgv/base/base.h>
 #include <cgv/gui/provider.h>
+#include <cgv/media/color.h>
+#include "surface_extractor.h"
+#include "surface_extraction_handler.h"
 
-/** drawable that visualizes implicit surfaces by contouring them with marching cubes or
-    dual contouring. */
+/** drawable that visualizes implicit surfaces by contouring them with marching cubes,
+    dual contouring or surface nets, for which contouring_type takes the value
+    surface_extractor::SURFACE_NETS beyond the types of the base class. Extractions are performed in phases by a surface_extractor, whose
+    timings and counters are shown next to the mesh size. If a list of isovalues is given, the level
+    set of each isovalue is extracted as a shell of its own color from one sampling pass. Changes
+    of the contouring parameters contour the samples of the last extraction again, which are only
+    taken anew after the function changed or the grid parameters differ. If the extraction handler
+    bounds where the function changed, as for the frames of an animation, only the blocks of samples
+    inside these bounds are taken anew. The frames of an animated function can be extracted into
+    numbered mesh files or a mesh sequence cache. The streaming marching cubes and dual contouring
+    of the base class remain selectable as reference for the zero level set. */
 class gl_implicit_surface_drawable : 
 	public cgv::base::base, 
 	public cgv::gui::provider,
-	public cgv::render::gl::gl_implicit_surface_drawable_base
+	public cgv::render::gl::gl_implicit_surface_drawable_base,
+	public surface_extraction_driver
 {
 public:
 	typedef cgv::math::fvec<double, 3> vec_type;
 	typedef cgv::math::fvec<double, 3> pnt_type;
+	/// type of the shell colors
+	typedef cgv::media::color<float, cgv::media::RGB> shell_color_type;
 private:
 	float box_scale;
 protected:
+	/// handler notified after each surface extraction
+	surface_extraction_handler* extraction_handler;
+	/// number of rebuilds requested and number of extractions executed for them, which is
+	/// smaller if several requests have been merged into one extraction
+	unsigned nr_rebuild_requests, nr_executed_extractions;
+	/// number of relaxation iterations of surface nets
+	unsigned nr_smoothing_iters;
+	/// whether marching cubes and dual contouring are done by the base class instead of the surface extractor,
+	/// which only extracts the zero level set without decimation and is kept as reference
+	bool use_base_contouring;
+	/// whether the last extraction was done by the base class, such that the changes bounded by the extraction
+	/// handler do not refer to the function sampled by the extractor
+	bool last_extraction_by_base;
+	/// whether positions and normals are sent to GL as quantized 16 bit integers instead of floats
+	bool quantize_mesh;
+	/// whether the extracted mesh is decimated by quadric error edge collapses
+	bool decimate_mesh;
+	/// number of triangles the decimation stops at, where zero only applies the error bound
+	unsigned target_nr_triangles;
+	/// maximum decimation error relative to the cell size, where zero only applies the target triangle count
+	double max_decimation_error;
+	/// encoding of the samples held during an extraction
+	sample_grid::sample_encoding grid_encoding;
+	/// whether bricks of samples far from the surface are stored as a single value
+	bool sparse_grid;
+	/// half width of the band quantized by the integer encodings relative to the cell size
+	double narrow_band_width;
+	/// whether the scene is sampled with the narrow band, such that csg nodes skip children beyond it
+	bool bounded_sampling;
+	/// comma or space separated isovalues of the extracted shells, where an empty list extracts the zero level set
+	std::string shell_isovalues;
+	/// isovalues parsed from shell_isovalues
+	std::vector<double> isovalues;
+	/// color per shell, which replaces the diffuse reflectance of the material if more than one shell is extracted
+	std::vector<shell_color_type> shell_colors;
+	/// extractor configured from the contouring parameters before each extraction
+	surface_extractor extractor;
+	/// GL buffers of a shell, which hold its packed positions followed by its packed normals and its face corners
+	struct shell_buffers
+	{
+		/// names of the vertex and index buffer
+		unsigned vertex_buffer, index_buffer;
+		/// whether positions and normals are quantized to 16 bit integers
+		bool quantized;
+		/// quantized positions q map to translation + scale*q
+		pnt_type translation;
+		vec_type scale;
+		/// number of vertices and of face corners
+		unsigned nr_vertices, nr_indices;
+		/// number of corners per face, which is empty if all faces are triangles
+		std::vector<unsigned> face_sizes;
+	};
+	/// buffers of the last extraction with one shell per isovalue, where the extracted meshes themselves
+	/// are only kept until they are uploaded or written to a file
+	std::vector<shell_buffers> shells;
+	/// whether the function changed since the last extraction, such that its samples cannot be contoured again
+	bool samples_outdated;
+	/// whether the meshes need to be extracted again, where otherwise a rebuild keeps the uploaded shells
+	bool meshes_outdated;
+	/// timings and counters of the last extraction
+	extraction_statistics extraction_stats;
+	/// file the next extraction is written to instead of GL, whose extension selects obj, ply or stl
+	std::string export_file_name;
+	/// number of frames of an extracted sequence, which are evenly spaced over the animation
+	unsigned nr_sequence_frames;
 	double map_to_zero_value;
 	double map_to_one_value;
 	void toggle_range();
 	void adjust_range();
 	void export_volume();
-
+	/// save the surface to a mesh file chosen in a dialog, whose extension selects obj, ply or stl
 	void save_interactive();
 	void resolution_change();
+	/// parse shell_isovalues into isovalues and give each shell a color
+	void update_isovalues();
+	/// request an extraction after a change of the contouring parameters, which contours the samples of the
+	/// last extraction again if they have been taken with the same grid parameters
+	void request_contouring();
+	/// write the meshes to a file, where several shells are written to files with the shell index appended to the name
+	void write_meshes(const std::vector<extracted_mesh>& meshes, const std::string& file_name) const;
+	/// configure the extractor and extract the meshes, where the samples of the last extraction are
+	/// contoured again or, after a change of the function, kept where the handler excludes a change
+	void extract_meshes(std::vector<extracted_mesh>& meshes);
+	/// contour the zero level set with the streaming marching cubes or dual contouring of the base class
+	void base_surface_extraction();
 	void surface_extraction();
+	/// ask for a file name and extract the frames of the animation to it
+	void extract_sequence_interactive();
+	/// pack the meshes and send them to the buffers of the shells, such that GL holds them in packed form
+	void upload_mesh(const std::vector<extracted_mesh>& meshes);
+	/// delete the buffers of all shells
+	void destruct_shells();
+	/// update the views of the extraction statistics
+	void update_statistics_views();
 	void build_display_list();
 public:
 	/// standard constructor does not initialize the function pointer so that nothing is drawn
 	gl_implicit_surface_drawable();
+	/// set the function whose surface is extracted
+	void set_extracted_function(F* f);
+	/// set the handler that is notified after each surface extraction
+	void set_extraction_handler(surface_extraction_handler* eh);
+	/// request a surface extraction after the function changed, which samples it anew, where all
+	/// requests until the next frame result in one extraction
+	void request_rebuild();
+	/// return the box in which the surface is extracted
+	const cgv::media::axis_aligned_box<double, 3>& get_domain() const { return box; }
+	/// return the timings and counters of the last extraction
+	const extraction_statistics& get_extraction_statistics() const { return extraction_stats; }
+	/// return the number of shells uploaded by the last extraction
+	size_t get_nr_shells() const { return shells.size(); }
+	/// extract nr_sequence_frames frames of the animation of the function and write them to one mesh
+	/// sequence cache if the extension of file_name is ims, or otherwise to one mesh file per frame with
+	/// the zero padded frame index appended to the name
+	bool extract_sequence(const std::string& file_name);
+	/// draw the shells from their buffers after the parts drawn by the base class
+	void draw(cgv::render::context& ctx);
+	/// delete the buffers of the shells together with the GL objects of the base class
+	void clear(cgv::render::context& ctx);
 	void on_set(void* member_ptr);
 	bool self_reflect(cgv::reflect::reflection_handler& rh);
 	std::string get_type_name() const;
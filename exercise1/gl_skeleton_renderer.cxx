@@ -0,0 +1,25 @@
+#include "skeleton.h"
+#include <cgv_gl/gl/gl.h>
+
+/// draw the skeleton edges with legacy GL lines
+static void gl_draw_skeleton_edges(cgv::render::context& ctx, const std::vector<cgv::math::fvec<double, 3> >& end_points, float width)
+{
+	// Fixme: legacy OpenGL. Not good.
+	glLineWidth(width);
+	glDisable(GL_LIGHTING);
+	glColor3d(0.25,0.25,0.25);
+	glBegin(GL_LINES);
+		for (size_t i=0; i<end_points.size(); i++)
+			glVertex3d(end_points[i](0), end_points[i](1), end_points[i](2));
+	glEnd();
+	glEnable(GL_LIGHTING);
+	glLineWidth(1);
+}
+
+/// install the GL edge renderer when the plugin is loaded
+struct gl_skeleton_renderer_registration
+{
+	gl_skeleton_renderer_registration() { ref_skeleton_edge_renderer() = &gl_draw_skeleton_edges; }
+};
+
+gl_skeleton_renderer_registration gl_skeleton_renderer_reg;
@@ -1,4 +1,8 @@
 #include "implicit_base.h"
+#include <atomic>
+
+/// last version given to a node
+static std::atomic<unsigned long long> last_node_version(0);
 
 /// set new scene update handler
 template <typename T>
@@ -8,20 +12,32 @@ void implicit_base<T>::set_update_handler(scene_update_handler* uh)
 }
 
 
+/// give the node a new version after a change of its function
+template <typename T>
+void implicit_base<T>::increase_version()
+{
+	version = ++last_node_version;
+}
+
 /// to be called if scene has changed due to gui interaction
 template <typename T>
 void implicit_base<T>::update_scene()
 {
-	if (update_handler)
+	increase_version();
+	if (update_handler) {
+		update_handler->node_changed(get_base());
 		update_handler->update_scene();
+	}
 }
 
 /// callback for functions that update the scene description without the implicit function
 template <typename T>
 void implicit_base<T>::update_description()
 {
-	if (update_handler)
+	if (update_handler) {
+		update_handler->node_changed(get_base());
 		update_handler->update_description();
+	}
 }
 
 
@@ -31,6 +47,7 @@ implicit_base<T>::implicit_base() : color(0.5f, 0.5f, 0.5f, 1.0f)
 {
 	gui_color = 0x888888;
 	update_handler = 0;
+	increase_version();
 }
 
 template <typename T>
@@ -58,6 +75,13 @@ typename implicit_base<T>::vec_type implicit_base<T>::evaluate_gradient(const pn
 	return g;
 }
 
+/// without skippable work the bounded value is the exact one
+template <typename T>
+typename implicit_base<T>::crd_type implicit_base<T>::evaluate_bounded(const pnt_type& p, crd_type lo, crd_type hi) const
+{
+	return evaluate(p);
+}
+
 /// return primitive color
 template <typename T>
 typename implicit_base<T>::clr_type implicit_base<T>::evaluate_color(const pnt_type& p) const
@@ -65,4 +89,99 @@ typename implicit_base<T>::clr_type implicit_base<T>::evaluate_color(const pnt_t
 	return color;
 }
 
-template class implicit_base<double>;
\ No newline at end of file
+/// a leaf determines its own value
+template <typename T>
+implicit_base<T>* implicit_base<T>::find_determining_leaf(const pnt_type& p)
+{
+	return this;
+}
+
+/// without further knowledge about the function no finite bound can be given
+template <typename T>
+typename implicit_base<T>::crd_type implicit_base<T>::lipschitz_bound(const box_type& domain) const
+{
+	return std::numeric_limits<T>::infinity();
+}
+
+/// in general the value of a node is not the value of a child at mapped points
+template <typename T>
+bool implicit_base<T>::get_child_domain(const box_type& domain, box_type& child_domain) const
+{
+	return false;
+}
+
+/// a node without children is its own subtree
+template <typename T>
+unsigned long long implicit_base<T>::get_subtree_version() const
+{
+	return version;
+}
+
+/// in general the value of a node is not a maximum over its signed children
+template <typename T>
+bool implicit_base<T>::get_child_signs(crd_type& first_sign, crd_type& other_sign) const
+{
+	return false;
+}
+
+/// one evaluation of a primitive is the unit of cost
+template <typename T>
+double implicit_base<T>::estimate_cost() const
+{
+	return 1;
+}
+
+/// nodes without statistics have nothing to adapt
+template <typename T>
+bool implicit_base<T>::adapt_to_statistics(const implicit_base<T>& copy)
+{
+	return false;
+}
+
+/// nodes without statistics have nothing to adapt
+template <typename T>
+bool implicit_base<T>::adapt_to_single_statistics(const implicit_base<float>& copy)
+{
+	return false;
+}
+
+/// a node without children only prepares itself
+template <typename T>
+void implicit_base<T>::prepare_evaluation()
+{
+	prepare_node_evaluation();
+}
+
+/// nodes without derived data have nothing to prepare
+template <typename T>
+void implicit_base<T>::prepare_node_evaluation()
+{
+}
+
+/// append the packed parameter arrays of this node, the default has none
+template <typename T>
+void implicit_base<T>::get_packed_arrays(std::vector<packed_array>& arrays) const
+{
+}
+
+/// replace the content of the named packed array, the default knows no arrays
+template <typename T>
+bool implicit_base<T>::set_packed_array(const std::string& name, const void* data, size_t element_size, size_t count)
+{
+	return false;
+}
+
+/// called on a copy made for an evaluation snapshot, the default shares nothing
+template <typename T>
+void implicit_base<T>::share_evaluation_data(const implicit_base<T>& source)
+{
+}
+
+/// called on a single precision copy, the default shares nothing
+template <typename T>
+void implicit_base<T>::share_double_evaluation_data(const implicit_base<double>& source)
+{
+}
+
+template class implicit_base<double>;
+template class implicit_base<float>;
\ No newline at end of file
@@ -2,6 +2,7 @@
 
 #include <cgv/base/base.h>
 #include <cgv/media/color.h>
+#include <cgv/media/axis_aligned_box.h>
 #include <cgv/gui/provider.h>
 #include <cgv/render/drawable.h>
 
@@ -19,9 +20,29 @@ struct scene_update_handler
 {
 	virtual void update_scene() = 0;
 	virtual void update_description() = 0;
+	/// called before update_scene or update_description with the node whose properties changed
+	virtual void node_changed(cgv::base::base* node_ptr) {}
 };
 
 
+/// parameter array of a node that the binary scene format stores in packed form instead of
+/// one property per element
+struct packed_array
+{
+	/// name of the array
+	std::string name;
+	/// pointer to the first element
+	const void* data;
+	/// size of one element in bytes
+	size_t element_size;
+	/// number of elements
+	size_t count;
+	/// name of the property that reflects the number of elements
+	std::string count_property;
+	/// semicolon separated prefixes of the element properties, which are followed by the element index
+	std::string element_property_prefixes;
+};
+
 /** base implementation for all group nodes*/
 template <typename T>
 class implicit_base : 
@@ -34,9 +55,11 @@ public:
 	/// type of primitive color
 	typedef cgv::media::color<float, cgv::media::RGB, cgv::media::OPACITY> clr_type;
 	/// type of 3d vector
-	typedef cgv::dvec3 vec_type;
+	typedef cgv::math::fvec<T, 3> vec_type;
 	/// type of 3d point
-	typedef cgv::dvec3 pnt_type;
+	typedef cgv::math::fvec<T, 3> pnt_type;
+	/// type of axis aligned box used to specify evaluation domains
+	typedef cgv::media::axis_aligned_box<T, 3> box_type;
 
 protected:
 	scene_update_handler * update_handler;
@@ -48,12 +71,21 @@ protected:
 	clr_type color;
 	/// gui color
 	int gui_color;
+	/// measurements of the last profiled extraction shown by the parent group, empty if not profiled
+	std::string profile_info;
+	/// version of the function of this node, which is drawn from a counter shared by all nodes whenever
+	/// the parameters or the children of the node change
+	unsigned long long version;
+	/// give the node a new version after a change of its function
+	void increase_version();
 	/// give group access to color and gui_color
 	friend class implicit_group<T>;
 
 public:
 	/// set new scene update handler
 	virtual void set_update_handler(scene_update_handler* uh);
+	/// return a reference to the measurements of the last profiled extraction
+	std::string& ref_profile_info() { return profile_info; }
 	/// constructor sets default gui color
 	implicit_base();
 	/// returns "implicit_primitive"
@@ -62,10 +94,51 @@ public:
 	virtual cgv::base::base* get_base() = 0;
 	/// interface for evaluation of implicit function
 	virtual crd_type evaluate(const pnt_type& p) const = 0;
+	/// evaluation that only needs to be exact inside the band [lo,hi]. The returned value v is exact, or
+	/// v >= hi and the exact value is at least v, or v <= lo and the exact value is at most v, such that
+	/// nodes can skip work that cannot move the value into the band. The default evaluates exactly.
+	virtual crd_type evaluate_bounded(const pnt_type& p, crd_type lo, crd_type hi) const;
 	/// interface for evaluation of the gradient with central differences based default implementation
 	virtual vec_type evaluate_gradient(const pnt_type& p) const;
 	/// interface for the evaluation of surface color
 	virtual clr_type evaluate_color(const pnt_type& p) const;
+	/// return the leaf node that determines the function value at p
+	virtual implicit_base<T>* find_determining_leaf(const pnt_type& p);
+	/// upper bound of the gradient length over the given domain, infinity if unknown
+	virtual crd_type lipschitz_bound(const box_type& domain) const;
+	/// if the value of the node is the value of its only child at points mapped by its parameters, as for
+	/// transformations, bound the mapped domain in child_domain and return true. The default returns false.
+	virtual bool get_child_domain(const box_type& domain, box_type& child_domain) const;
+	/// return the largest version in the subtree of this node, which changes whenever a node of the
+	/// subtree changes or the subtree is restructured
+	virtual unsigned long long get_subtree_version() const;
+	/// if the value of the node is first_sign times the maximum over its children multiplied with first_sign
+	/// for the first and other_sign for the other children, as for the csg operators, report the signs and
+	/// return true. The default returns false.
+	virtual bool get_child_signs(crd_type& first_sign, crd_type& other_sign) const;
+	/// estimate of the relative cost of one evaluation, used to order children of csg nodes
+	virtual double estimate_cost() const;
+	/// adapt the evaluation strategy of this node to the statistics that the given copy of it has
+	/// gathered since the last call and reset them there. Returns whether the strategy changed, such
+	/// that copies made before are outdated. Children are adapted by the caller.
+	virtual bool adapt_to_statistics(const implicit_base<T>& copy);
+	/// adapt in the same way to the statistics of a single precision copy
+	virtual bool adapt_to_single_statistics(const implicit_base<float>& copy);
+	/// recompute derived data of the node and its subtree after the scene changed and before it is evaluated
+	virtual void prepare_evaluation();
+	/// recompute derived data of this node only, where the children have been prepared already
+	virtual void prepare_node_evaluation();
+	/// append the packed parameter arrays of this node, the default has none
+	virtual void get_packed_arrays(std::vector<packed_array>& arrays) const;
+	/// replace the content of the named packed array by count elements of the given size.
+	/// Returns false if the array is unknown or the element size does not match.
+	virtual bool set_packed_array(const std::string& name, const void* data, size_t element_size, size_t count);
+	/// called on a copy made for an evaluation snapshot with the node it was copied from, such
+	/// that immutable evaluation data like acceleration structures can be shared instead of rebuilt
+	virtual void share_evaluation_data(const implicit_base<T>& source);
+	/// called on a single precision copy with the double precision node it was copied from, such
+	/// that precision independent evaluation data can be shared in the same way
+	virtual void share_double_evaluation_data(const implicit_base<double>& source);
 };
 
 
@@ -74,6 +147,19 @@ struct abst_scene_factory
 	std::string names;
 	virtual void init_counter() = 0;
 	virtual base_ptr create_function() = 0;
+	/// return the next generated node name, which create_function assigns to new nodes
+	virtual std::string create_name() = 0;
+	/// create a node of the same type with float instead of double precision for evaluation snapshots
+	virtual base_ptr create_single_precision_function() = 0;
+};
+
+/// node type N<float> of a node type N<double>
+template <typename N>
+struct single_precision_node;
+template <template <typename> class N, typename T>
+struct single_precision_node<N<T> >
+{
+	typedef N<float> type;
 };
 
 extern void register_scene_factory(abst_scene_factory* _scene_factory);
@@ -100,12 +186,17 @@ struct scene_factory : public abst_scene_factory
 	void init_counter() {
 		ref_counter() = 1;
 	}
+	std::string create_name() {
+		return ref_base_name() + "_" + cgv::utils::to_string(ref_counter()++);
+	}
 	base_ptr create_function() {
 		T* f = new T;
-		f->set_name(ref_base_name() + "_" + cgv::utils::to_string(ref_counter()));
-		++ref_counter();
+		f->set_name(create_name());
 		return f;
 	};
+	base_ptr create_single_precision_function() {
+		return new typename single_precision_node<T>::type;
+	}
 };
 
 /** use this registration struct to register a factory for your
@@ -1,5 +1,8 @@
 #include "implicit_group.h"
 #include "implicit_primitive.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
 
 /// passes on the update handler to the children
 template <typename T>
@@ -66,9 +69,18 @@ unsigned int implicit_group<T>::append_child(base_ptr child)
 {
 	unsigned i = group::append_child(child);
 	child_visible_in_gui.push_back(1);
+	implicit_base<T>::increase_version();
 	return i;
 }
 
+template <typename T>
+void implicit_group<T>::remove_all_children()
+{
+	group::remove_all_children();
+	child_visible_in_gui.clear();
+	implicit_base<T>::increase_version();
+}
+
 /// overload to compose the colors of the function children
 template <typename T>
 typename implicit_group<T>::clr_type implicit_group<T>::compose_color(const pnt_type& p) const
@@ -120,8 +132,11 @@ void implicit_group<T>::create_gui()
 		std::string& child_name = const_cast<std::string&>(child_ptr->get_base()->get_named()->get_name());
 		provider::add_member_control(child_ptr->get_base(), "name", child_name, "", "w=140;label=''", "");
 		provider::find_control(child_name)->set("color", child_ptr->gui_color);
-		// add gui for color of child
-		provider::add_member_control(child_ptr->get_base(), "color", child_ptr->color, "", "w=40;label=''");
+		// add gui for color of child followed by the measurements of the evaluation profiler
+		bool profiled = !child_ptr->profile_info.empty();
+		provider::add_member_control(child_ptr->get_base(), "color", child_ptr->color, "", "w=40;label=''", profiled ? " " : "\n");
+		if (profiled)
+			provider::add_view("", child_ptr->profile_info, "", "w=200;label=''");
 
 		if (node_visible) {
 			provider::inline_object_gui(get_child(i));
@@ -137,6 +152,64 @@ std::string implicit_group<T>::get_type_name() const
 	return "implicit_group";
 }
 
+/// descend into the child whose value is closest to the iso surface at p
+template <typename T>
+implicit_base<T>* implicit_group<T>::find_determining_leaf(const pnt_type& p)
+{
+	unsigned n = group::get_nr_children();
+	if (n == 0)
+		return this;
+	unsigned best_i = 0;
+	T best_value = std::numeric_limits<T>::infinity();
+	for (unsigned i = 0; n > 1 && i < n; ++i) {
+		T value = std::abs(get_implicit_child(i)->evaluate(p));
+		if (value < best_value) {
+			best_value = value;
+			best_i = i;
+		}
+	}
+	return get_implicit_child(best_i)->find_determining_leaf(p);
+}
+
+/// maximum of the children's bounds, which is valid for all min/max based operators
+template <typename T>
+T implicit_group<T>::lipschitz_bound(const box_type& domain) const
+{
+	T bound = 0;
+	for (unsigned i = 0; i < group::get_nr_children(); ++i)
+		bound = std::max(bound, get_implicit_child(i)->lipschitz_bound(domain));
+	return bound;
+}
+
+/// cost of the group itself plus the cost of all children
+template <typename T>
+double implicit_group<T>::estimate_cost() const
+{
+	double cost = 1;
+	for (unsigned i = 0; i < group::get_nr_children(); ++i)
+		cost += get_implicit_child(i)->estimate_cost();
+	return cost;
+}
+
+/// largest version of the group and its children's subtrees
+template <typename T>
+unsigned long long implicit_group<T>::get_subtree_version() const
+{
+	unsigned long long v = implicit_base<T>::version;
+	for (unsigned i = 0; i < group::get_nr_children(); ++i)
+		v = std::max(v, get_implicit_child(i)->get_subtree_version());
+	return v;
+}
+
+/// prepares the children before the group itself
+template <typename T>
+void implicit_group<T>::prepare_evaluation()
+{
+	for (unsigned i = 0; i < group::get_nr_children(); ++i)
+		get_implicit_child(i)->prepare_evaluation();
+	this->prepare_node_evaluation();
+}
+
 template <typename T>
 bool implicit_group<T>::init(context& ctx)
 {
@@ -148,3 +221,4 @@ bool implicit_group<T>::init(context& ctx)
 
 
 template class implicit_group<double>;
+template class implicit_group<float>;
@@ -22,6 +22,7 @@ public:
 	typedef typename implicit_base<T>::clr_type clr_type;
 	typedef typename implicit_base<T>::vec_type vec_type;
 	typedef typename implicit_base<T>::pnt_type pnt_type;
+	typedef typename implicit_base<T>::box_type box_type;
 protected:
 	/// access to implicit base interface of children
 	implicit_base<T>* get_implicit_child(unsigned i);
@@ -42,10 +43,22 @@ public:
 	void on_set(void* member_ptr);
 	/// append a new child and extract trivariate function
 	unsigned int append_child(base_ptr child);
+	/// remove all children together with their gui visibility flags
+	void remove_all_children();
 	/// returns "implicit_group"
 	std::string get_type_name() const;
 	/// evaluation of surface color based on color_mode
 	clr_type evaluate_color(const pnt_type& p) const;
+	/// descend into the child whose value is closest to the iso surface at p
+	implicit_base<T>* find_determining_leaf(const pnt_type& p);
+	/// maximum of the children's bounds, which is valid for all min/max based operators
+	T lipschitz_bound(const box_type& domain) const;
+	/// cost of the group itself plus the cost of all children
+	double estimate_cost() const;
+	/// largest version of the group and its children's subtrees
+	unsigned long long get_subtree_version() const;
+	/// prepares the children before the group itself
+	void prepare_evaluation();
 	/// passes on init to the children
 	bool init(context&);
 	/// passes on the update handler to the children
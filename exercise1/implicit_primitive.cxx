@@ -32,3 +32,4 @@ void implicit_primitive<T>::create_gui()
 }
 
 template class implicit_primitive<double>;
+template class implicit_primitive<float>;
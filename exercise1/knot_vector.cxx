@@ -1,18 +1,52 @@
 #include "knot_vector.h"
+#include <functional>
 #include <cgv/utils/scan.h>
-#include <cgv_gl/gl/gl.h>
 
 
 template <typename T> 
 void knot_vector<T>::append_point(const pnt_type& p)
 {
-	pnt_idx = int(points.size());
+	append_points(&p, 1);
+}
 
-	points.push_back(p);
+/// set the maximum of the point index control to the last point
+template <typename T>
+void knot_vector<T>::update_point_index_control()
+{
 	if (provider::find_control(pnt_idx))
-		provider::find_control(pnt_idx)->set("max", pnt_idx);
+		provider::find_control(pnt_idx)->set("max", (int)points.size() - 1);
+}
+
+template <typename T>
+void knot_vector<T>::points_appended_callback(size_t first)
+{
+	for (size_t pi = first; pi < points.size(); ++pi)
+		append_callback(pi);
+}
 
-	append_callback(pnt_idx);
+/// replace all points with callbacks and gui updates triggered once
+template <typename T>
+void knot_vector<T>::set_points(const pnt_type* begin, size_t n)
+{
+	points.assign(begin, begin + n);
+	pnt_idx = 0;
+	update_point_index_control();
+	points_replaced_callback();
+	if (!points.empty())
+		on_set(&pnt_idx);
+}
+
+/// append points with callbacks and gui updates triggered once
+template <typename T>
+void knot_vector<T>::append_points(const pnt_type* begin, size_t n)
+{
+	if (n == 0)
+		return;
+	size_t first = points.size();
+	points.insert(points.end(), begin, begin + n);
+	pnt_idx = unsigned(points.size() - 1);
+	update_point_index_control();
+	points_appended_callback(first);
 	on_set(&pnt_idx);
 }
 
@@ -36,10 +70,12 @@ bool knot_vector<T>::self_reflect(cgv::reflect::reflection_handler& rh)
 
 	// ensure dynamic allocation of points
 	if (rh.is_creative()) {
-		while (points.size() < (size_t)n)
-			append_point(pnt_type(0, 0, 0));
-		while (points.size() > (size_t)n)
-			points.pop_back();
+		if (points.size() < (size_t)n) {
+			std::vector<pnt_type> new_points(n - points.size(), pnt_type(0, 0, 0));
+			append_points(&new_points.front(), new_points.size());
+		}
+		else if (points.size() > (size_t)n)
+			points.resize(n);
 	}
 
 	// check whether to termine self reflection
@@ -75,13 +111,19 @@ void knot_vector<T>::on_set(void* member_ptr)
 			points[pnt_idx](c) = p(c);
 			position_changed_callback(pnt_idx);
 		}
-		for (size_t i = 0; i < points.size(); ++i) {
-			if (member_ptr == &points[i](c)) {
-				if (i == pnt_idx) {
-					p(c) = points[i](c);
-					provider::update_member(&p(c));
-					position_changed_callback(i);
-				}
+	}
+	// locate reflected point coordinates by their address instead of comparing against all points
+	if (!points.empty()) {
+		const char* mp = static_cast<const char*>(member_ptr);
+		const char* pb = reinterpret_cast<const char*>(&points.front());
+		std::less<const char*> less;
+		if (!less(mp, pb) && less(mp, pb + points.size()*sizeof(pnt_type))) {
+			size_t i = size_t(mp - pb) / sizeof(pnt_type);
+			unsigned c = unsigned((size_t(mp - pb) % sizeof(pnt_type)) / sizeof(p(0)));
+			if (i == pnt_idx) {
+				p(c) = points[i](c);
+				provider::update_member(&p(c));
+				position_changed_callback(i);
 			}
 		}
 	}
@@ -89,6 +131,34 @@ void knot_vector<T>::on_set(void* member_ptr)
 	implicit_base<T>::update_scene();
 }
 
+/// expose the points as packed array "points"
+template <typename T>
+void knot_vector<T>::get_packed_arrays(std::vector<packed_array>& arrays) const
+{
+	implicit_primitive<T>::get_packed_arrays(arrays);
+	packed_array pa;
+	pa.name = "points";
+	pa.data = points.empty() ? 0 : &points.front();
+	pa.element_size = sizeof(pnt_type);
+	pa.count = points.size();
+	pa.count_property = "n";
+	pa.element_property_prefixes = "x;y;z";
+	arrays.push_back(pa);
+}
+
+/// replace all points with a single allocation
+template <typename T>
+bool knot_vector<T>::set_packed_array(const std::string& name, const void* data, size_t element_size, size_t count)
+{
+	if (name != "points")
+		return implicit_primitive<T>::set_packed_array(name, data, element_size, count);
+	if (element_size != sizeof(pnt_type))
+		return false;
+	set_points(reinterpret_cast<const pnt_type*>(data), count);
+	implicit_base<T>::increase_version();
+	return true;
+}
+
 template <typename T>
 void knot_vector<T>::create_gui()
 {
@@ -108,3 +178,4 @@ void knot_vector<T>::create_gui()
 }
 
 template class knot_vector<double>;
+template class knot_vector<float>;
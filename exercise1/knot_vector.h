@@ -18,6 +18,8 @@ protected:
 
 	/// append a point to the knot vector and call the append callback
 	void append_point(const pnt_type& p);
+	/// set the maximum of the point index control to the last point
+	void update_point_index_control();
 
 	// virtual functions: can be overwritten by derived classes to process the data
 	/// triggers when a point is appended. Called by append_point
@@ -26,6 +28,11 @@ protected:
 	virtual void position_changed_callback(size_t pi) {}
 	/// triggers when the point selected in the gui for editing changed. Called by on_set
 	virtual void point_index_selection_callback() {}
+	/// triggers when all points have been replaced at once. Called by set_points
+	virtual void points_replaced_callback() {}
+	/// triggers once after the points starting at index first have been appended. Called by
+	/// append_points. The default implementation calls append_callback for each new point.
+	virtual void points_appended_callback(size_t first);
 
 	/// index of point that can currently be edited in user interface (selectable via slider control)
 	unsigned int pnt_idx;
@@ -39,10 +46,21 @@ public:
 	knot_vector();
 	/// overload to return the type name of this object
 	std::string get_type_name() const { return "knot_vector"; }
+	/// return the number of points
+	size_t get_nr_points() const { return points.size(); }
+	/// replace all points by the n points starting at begin with a single allocation, where
+	/// callbacks, gui updates and the scene update are triggered once instead of per point
+	void set_points(const pnt_type* begin, size_t n);
+	/// append the n points starting at begin with callbacks and gui updates triggered once
+	void append_points(const pnt_type* begin, size_t n);
 	/// reflect members to expose them to serialization
 	bool self_reflect(cgv::reflect::reflection_handler& rh);
 	/// implementation of updates needed after members changed
 	void on_set(void* member_ptr);
+	/// expose the points as packed array "points"
+	void get_packed_arrays(std::vector<packed_array>& arrays) const;
+	/// replace all points with a single allocation
+	bool set_packed_array(const std::string& name, const void* data, size_t element_size, size_t count);
 	/// create gui to edit the points in the knot vector and to allow appending a new point
 	void create_gui();
 };
@@ -0,0 +1,90 @@
+#include "mapped_file.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+/// construct without mapping
+mapped_file::mapped_file() : data(0), size(0)
+{
+#ifdef _WIN32
+	file_handle = INVALID_HANDLE_VALUE;
+	mapping_handle = 0;
+#else
+	file_descriptor = -1;
+#endif
+}
+
+/// unmap the file
+mapped_file::~mapped_file()
+{
+	close();
+}
+
+/// map the given file and return whether this succeeded
+bool mapped_file::open(const std::string& file_name)
+{
+	close();
+#ifdef _WIN32
+	file_handle = CreateFileA(file_name.c_str(), GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, 0);
+	if (file_handle == INVALID_HANDLE_VALUE)
+		return false;
+	LARGE_INTEGER file_size;
+	if (!GetFileSizeEx(file_handle, &file_size) || file_size.QuadPart == 0) {
+		close();
+		return false;
+	}
+	size = (size_t)file_size.QuadPart;
+	mapping_handle = CreateFileMappingA(file_handle, 0, PAGE_READONLY, 0, 0, 0);
+	if (!mapping_handle) {
+		close();
+		return false;
+	}
+	data = (const char*)MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0);
+#else
+	file_descriptor = ::open(file_name.c_str(), O_RDONLY);
+	if (file_descriptor == -1)
+		return false;
+	struct stat file_status;
+	if (fstat(file_descriptor, &file_status) != 0 || file_status.st_size == 0) {
+		close();
+		return false;
+	}
+	size = (size_t)file_status.st_size;
+	void* ptr = mmap(0, size, PROT_READ, MAP_PRIVATE, file_descriptor, 0);
+	data = ptr == MAP_FAILED ? 0 : (const char*)ptr;
+#endif
+	if (!data) {
+		close();
+		return false;
+	}
+	return true;
+}
+
+/// unmap the file if one is mapped
+void mapped_file::close()
+{
+#ifdef _WIN32
+	if (data)
+		UnmapViewOfFile(data);
+	if (mapping_handle)
+		CloseHandle(mapping_handle);
+	if (file_handle != INVALID_HANDLE_VALUE)
+		CloseHandle(file_handle);
+	mapping_handle = 0;
+	file_handle = INVALID_HANDLE_VALUE;
+#else
+	if (data)
+		munmap((void*)data, size);
+	if (file_descriptor != -1)
+		::close(file_descriptor);
+	file_descriptor = -1;
+#endif
+	data = 0;
+	size = 0;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <string>
+
+/** read only memory mapping of a complete file. Large binary inputs are accessed through
+    the mapping such that the operating system pages in only the parts that are read. */
+class mapped_file
+{
+protected:
+	/// first byte of the mapping or 0 if no file is mapped
+	const char* data;
+	/// size of the mapped file in bytes
+	size_t size;
+#ifdef _WIN32
+	void* file_handle;
+	void* mapping_handle;
+#else
+	int file_descriptor;
+#endif
+	mapped_file(const mapped_file&);
+	mapped_file& operator = (const mapped_file&);
+public:
+	/// construct without mapping
+	mapped_file();
+	/// unmap the file
+	~mapped_file();
+	/// map the given file and return whether this succeeded
+	bool open(const std::string& file_name);
+	/// unmap the file if one is mapped
+	void close();
+	/// check whether a file is mapped
+	bool is_open() const { return data != 0; }
+	/// return the first byte of the mapping
+	const char* get_data() const { return data; }
+	/// return the size of the mapping in bytes
+	size_t get_size() const { return size; }
+};
@@ -0,0 +1,74 @@
+#include "mesh_buffer.h"
+#include <cmath>
+
+using namespace cgv::math;
+
+/// largest magnitude of quantized coordinates
+static const double quantization_range = 32767;
+
+/// construct an empty buffer
+mesh_buffer::mesh_buffer() : quantized(false), translation(0, 0, 0), scale(1, 1, 1)
+{
+}
+
+/// fill the buffer from mesh, where quantized positions are relative to box
+void mesh_buffer::pack(const extracted_mesh& mesh, const box_type& box, bool quantize)
+{
+	quantized = quantize;
+	size_t nr_vertices = mesh.positions.size();
+	positions.clear();
+	normals.clear();
+	quantized_positions.clear();
+	quantized_normals.clear();
+	if (quantize) {
+		// quantized coordinates span the box, which contains all vertices
+		translation = box.get_center();
+		scale = box.get_extent() / (2*quantization_range);
+		vec_type inv_scale;
+		for (unsigned c = 0; c < 3; ++c)
+			inv_scale(c) = scale(c) > 0 ? 1 / scale(c) : 0;
+		quantized_positions.resize(3*nr_vertices);
+		quantized_normals.resize(3*nr_vertices);
+		for (size_t vi = 0; vi < nr_vertices; ++vi) {
+			// normals are transformed with the inverse scale and therefore stored prescaled
+			vec_type n = normalize(mesh.normals[vi] * scale);
+			for (unsigned c = 0; c < 3; ++c) {
+				double q = std::floor((mesh.positions[vi](c) - translation(c))*inv_scale(c) + 0.5);
+				quantized_positions[3*vi + c] = (short)std::max(-quantization_range, std::min(quantization_range, q));
+				quantized_normals[3*vi + c] = (short)std::floor(quantization_range*n(c) + 0.5);
+			}
+		}
+	}
+	else {
+		translation = pnt_type(0, 0, 0);
+		scale = vec_type(1, 1, 1);
+		positions.resize(3*nr_vertices);
+		normals.resize(3*nr_vertices);
+		for (size_t vi = 0; vi < nr_vertices; ++vi)
+			for (unsigned c = 0; c < 3; ++c) {
+				positions[3*vi + c] = float(mesh.positions[vi](c));
+				normals[3*vi + c] = float(mesh.normals[vi](c));
+			}
+	}
+	indices = mesh.corner_vertices;
+	face_sizes.clear();
+	for (size_t fi = 0; fi < mesh.face_sizes.size(); ++fi)
+		if (mesh.face_sizes[fi] != 3) {
+			face_sizes = mesh.face_sizes;
+			break;
+		}
+}
+
+/// return the number of vertices
+size_t mesh_buffer::get_nr_vertices() const
+{
+	return (quantized ? quantized_positions.size() : positions.size()) / 3;
+}
+
+/// return the number of bytes of all arrays
+size_t mesh_buffer::get_size() const
+{
+	return (positions.size() + normals.size())*sizeof(float) +
+		(quantized_positions.size() + quantized_normals.size())*sizeof(short) +
+		(indices.size() + face_sizes.size())*sizeof(unsigned);
+}
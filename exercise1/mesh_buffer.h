@@ -0,0 +1,35 @@
+#pragma once
+
+#include "surface_extractor.h"
+
+/** vertex and index arrays of an extracted mesh in the compact form in which it is sent to GL.
+    Positions and normals are stored either as packed float triples or quantized to signed 16 bit
+    integers, where quantized positions are relative to the extraction box and need to be mapped
+    back with the translation and scale of the buffer. */
+struct mesh_buffer
+{
+	typedef cgv::math::fvec<double, 3> pnt_type;
+	typedef cgv::math::fvec<double, 3> vec_type;
+	typedef cgv::media::axis_aligned_box<double, 3> box_type;
+	/// whether positions and normals are quantized
+	bool quantized;
+	/// three floats per vertex if not quantized
+	std::vector<float> positions, normals;
+	/// three shorts per vertex if quantized
+	std::vector<short> quantized_positions, quantized_normals;
+	/// quantized positions q map to translation + scale*q
+	pnt_type translation;
+	vec_type scale;
+	/// vertex indices of all face corners
+	std::vector<unsigned> indices;
+	/// number of corners per face, which is empty if all faces are triangles
+	std::vector<unsigned> face_sizes;
+	/// construct an empty buffer
+	mesh_buffer();
+	/// fill the buffer from mesh, where quantized positions are relative to box
+	void pack(const extracted_mesh& mesh, const box_type& box, bool quantize);
+	/// return the number of vertices
+	size_t get_nr_vertices() const;
+	/// return the number of bytes of all arrays
+	size_t get_size() const;
+};
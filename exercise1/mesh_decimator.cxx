@@ -0,0 +1,252 @@
+#include "mesh_decimator.h"
+#include "parallel.h"
+#include <algorithm>
+#include <iterator>
+
+using namespace cgv::math;
+
+/// number of half-edges or collapses processed by one task
+static const size_t decimation_block_size = 4096;
+/// singular values of the summed quadric below this fraction of the largest one are ignored
+static const double qem_singular_value_threshold = 1e-3;
+static const unsigned invalid_index = unsigned(-1);
+
+/// construct with default parameters
+mesh_decimator::mesh_decimator()
+	: target_nr_triangles(0), max_error(0), batch_fraction(0.25), nr_threads(0)
+{
+}
+
+/// rebuild the incident triangles, opposite half-edges and locked vertices from the remaining triangles
+void mesh_decimator::build_connectivity()
+{
+	size_t nr_vertices = positions.size(), nr_half_edges = triangles.size();
+	vertex_offsets.assign(nr_vertices + 1, 0);
+	for (size_t h = 0; h < nr_half_edges; ++h)
+		if (!removed[h / 3])
+			++vertex_offsets[triangles[h] + 1];
+	for (size_t v = 0; v < nr_vertices; ++v)
+		vertex_offsets[v + 1] += vertex_offsets[v];
+	vertex_triangles.resize(vertex_offsets[nr_vertices]);
+	std::vector<unsigned> fill(vertex_offsets.begin(), vertex_offsets.end() - 1);
+	for (size_t h = 0; h < nr_half_edges; ++h)
+		if (!removed[h / 3])
+			vertex_triangles[fill[triangles[h]]++] = unsigned(h / 3);
+
+	// sort the half-edges by their undirected edge, such that opposite half-edges become neighbors
+	std::vector<std::pair<unsigned long long, unsigned> > edges;
+	edges.reserve(vertex_triangles.size());
+	for (unsigned h = 0; h < nr_half_edges; ++h)
+		if (!removed[h / 3]) {
+			unsigned long long v0 = get_origin(h), v1 = get_target(h);
+			edges.push_back(std::make_pair(std::min(v0, v1) << 32 | std::max(v0, v1), h));
+		}
+	std::sort(edges.begin(), edges.end());
+	opposite.assign(nr_half_edges, invalid_index);
+	locked.assign(nr_vertices, 0);
+	for (size_t i = 0, j; i < edges.size(); i = j) {
+		for (j = i + 1; j < edges.size() && edges[j].first == edges[i].first; ++j)
+			;
+		unsigned h0 = edges[i].second;
+		// boundary edges, non-manifold edges and edges of inconsistently oriented triangles fix their end points
+		if (j - i == 2 && get_origin(h0) == get_target(edges[i + 1].second)) {
+			opposite[h0] = edges[i + 1].second;
+			opposite[edges[i + 1].second] = h0;
+		}
+		else
+			locked[get_origin(h0)] = locked[get_target(h0)] = 1;
+	}
+}
+
+/// store the vertices adjacent to v in sorted order without duplicates
+void mesh_decimator::collect_neighbors(unsigned v, std::vector<unsigned>& neighbors) const
+{
+	neighbors.clear();
+	for (unsigned i = vertex_offsets[v]; i < vertex_offsets[v + 1]; ++i)
+		for (unsigned j = 0; j < 3; ++j)
+			if (triangles[3 * vertex_triangles[i] + j] != v)
+				neighbors.push_back(triangles[3 * vertex_triangles[i] + j]);
+	std::sort(neighbors.begin(), neighbors.end());
+	neighbors.erase(std::unique(neighbors.begin(), neighbors.end()), neighbors.end());
+}
+
+/// compute target position and cost of collapsing the edge of half-edge h and return false if the collapse is not allowed
+bool mesh_decimator::evaluate_collapse(unsigned h, collapse& c) const
+{
+	c.keep = get_origin(h);
+	c.drop = get_target(h);
+	if (locked[c.keep] && locked[c.drop])
+		return false;
+	if (locked[c.drop])
+		std::swap(c.keep, c.drop);
+
+	// link condition: the end points may only share the two vertices opposite to the edge
+	std::vector<unsigned> keep_neighbors, drop_neighbors, shared;
+	collect_neighbors(c.keep, keep_neighbors);
+	collect_neighbors(c.drop, drop_neighbors);
+	std::set_intersection(keep_neighbors.begin(), keep_neighbors.end(), drop_neighbors.begin(), drop_neighbors.end(),
+		std::back_inserter(shared));
+	if (shared.size() != 2 || keep_neighbors.size() + drop_neighbors.size() <= 6)
+		return false;
+
+	// locked vertices stay in place, others move to the quadric minimum unless it lies far off the edge
+	qem<double> Q = quadrics[c.keep];
+	Q += quadrics[c.drop];
+	const pnt_type& p0 = positions[c.keep];
+	const pnt_type& p1 = positions[c.drop];
+	if (locked[c.keep])
+		c.target = p0;
+	else {
+		pnt_type center = 0.5*(p0 + p1);
+		vec<double> x = Q.compute_minimum(center.to_vec(), qem_singular_value_threshold);
+		c.target = pnt_type(x(0), x(1), x(2));
+		if (sqr_length(c.target - center) > sqr_length(p1 - p0))
+			c.target = center;
+	}
+	c.cost = std::max(0.0, Q.evaluate(c.target.to_vec()));
+
+	// reject collapses that flip or degenerate one of the remaining triangles
+	for (unsigned k = 0; k < 2; ++k) {
+		unsigned v = k == 0 ? c.keep : c.drop;
+		for (unsigned i = vertex_offsets[v]; i < vertex_offsets[v + 1]; ++i) {
+			const unsigned* t = &triangles[3 * vertex_triangles[i]];
+			if (std::find(t, t + 3, c.keep) != t + 3 && std::find(t, t + 3, c.drop) != t + 3)
+				continue;
+			pnt_type p[3], q[3];
+			for (unsigned j = 0; j < 3; ++j) {
+				p[j] = positions[t[j]];
+				q[j] = t[j] == v ? c.target : p[j];
+			}
+			vec_type n0 = cross(p[1] - p[0], p[2] - p[0]);
+			vec_type n1 = cross(q[1] - q[0], q[2] - q[0]);
+			if (!(dot(n0, n1) > 0))
+				return false;
+		}
+	}
+	return true;
+}
+
+/// move the kept vertex to the target and replace the dropped vertex by the kept one
+void mesh_decimator::apply_collapse(const collapse& c)
+{
+	for (unsigned i = vertex_offsets[c.drop]; i < vertex_offsets[c.drop + 1]; ++i) {
+		unsigned* t = &triangles[3 * vertex_triangles[i]];
+		if (std::find(t, t + 3, c.keep) != t + 3)
+			removed[vertex_triangles[i]] = 1;
+		else
+			*std::find(t, t + 3, c.drop) = c.keep;
+	}
+	positions[c.keep] = c.target;
+	quadrics[c.keep] += quadrics[c.drop];
+}
+
+/// decimate the mesh, whose faces are triangulated before, and remove its normals
+size_t mesh_decimator::decimate(extracted_mesh& mesh)
+{
+	if (target_nr_triangles == 0 && max_error <= 0)
+		return 0;
+
+	// fan triangulate all faces and initialize the vertex quadrics with the planes of their triangles
+	positions = mesh.positions;
+	triangles.clear();
+	triangles.reserve(3 * mesh.get_nr_triangles());
+	for (size_t fi = 0, ci = 0; fi < mesh.face_sizes.size(); ci += mesh.face_sizes[fi++])
+		for (unsigned j = 2; j < mesh.face_sizes[fi]; ++j) {
+			triangles.push_back(mesh.corner_vertices[ci]);
+			triangles.push_back(mesh.corner_vertices[ci + j - 1]);
+			triangles.push_back(mesh.corner_vertices[ci + j]);
+		}
+	size_t nr_triangles = triangles.size() / 3;
+	removed.assign(nr_triangles, 0);
+	quadrics.assign(positions.size(), qem<double>(pnt_type(0, 0, 0).to_vec(), vec_type(0, 0, 0).to_vec()));
+	for (size_t ti = 0; ti < nr_triangles; ++ti) {
+		const unsigned* t = &triangles[3 * ti];
+		vec_type n = cross(positions[t[1]] - positions[t[0]], positions[t[2]] - positions[t[0]]);
+		if (n.normalize() == 0)
+			continue;
+		qem<double> Q(positions[t[0]].to_vec(), n.to_vec());
+		for (unsigned j = 0; j < 3; ++j)
+			quadrics[t[j]] += Q;
+	}
+
+	size_t nr_remaining = nr_triangles, nr_collapses = 0;
+	double max_cost = max_error*max_error;
+	std::vector<collapse> edge_collapses(triangles.size()), candidates, selected;
+	std::vector<unsigned char> edge_allowed(triangles.size(), 0);
+	// all edges are evaluated in the first batch and afterwards only the ones touched by the last batch
+	std::vector<unsigned char> touched(positions.size(), 1);
+	// orders collapses such that the heap hands out the cheapest first
+	auto more_expensive = [](const collapse& c0, const collapse& c1) { return c0.cost > c1.cost; };
+	while (target_nr_triangles == 0 || nr_remaining > target_nr_triangles) {
+		build_connectivity();
+
+		// evaluate each interior edge once from the half-edge with the smaller origin
+		size_t nr_blocks = (triangles.size() + decimation_block_size - 1) / decimation_block_size;
+		parallel_for(nr_blocks, [&](size_t bi) {
+			size_t end = std::min(triangles.size(), (bi + 1)*decimation_block_size);
+			for (size_t h = bi*decimation_block_size; h < end; ++h) {
+				unsigned v0 = get_origin(unsigned(h)), v1 = get_target(unsigned(h));
+				if (removed[h / 3] || opposite[h] == invalid_index || v0 > v1)
+					edge_allowed[h] = 0;
+				else if (touched[v0] || touched[v1])
+					edge_allowed[h] = evaluate_collapse(unsigned(h), edge_collapses[h]) &&
+						(max_error <= 0 || edge_collapses[h].cost <= max_cost);
+			}
+		}, nr_threads);
+		candidates.clear();
+		for (size_t h = 0; h < triangles.size(); ++h)
+			if (edge_allowed[h])
+				candidates.push_back(edge_collapses[h]);
+
+		// hand out the cheapest collapses whose triangles are not touched by collapses selected before
+		size_t max_nr_selected = std::max(size_t(1), size_t(batch_fraction*candidates.size()));
+		std::make_heap(candidates.begin(), candidates.end(), more_expensive);
+		touched.assign(positions.size(), 0);
+		selected.clear();
+		while (!candidates.empty() && selected.size() < max_nr_selected &&
+			(target_nr_triangles == 0 || nr_remaining > target_nr_triangles)) {
+			std::pop_heap(candidates.begin(), candidates.end(), more_expensive);
+			collapse c = candidates.back();
+			candidates.pop_back();
+			if (touched[c.keep] || touched[c.drop])
+				continue;
+			for (unsigned k = 0; k < 2; ++k) {
+				unsigned v = k == 0 ? c.keep : c.drop;
+				for (unsigned i = vertex_offsets[v]; i < vertex_offsets[v + 1]; ++i)
+					for (unsigned j = 0; j < 3; ++j)
+						touched[triangles[3 * vertex_triangles[i] + j]] = 1;
+			}
+			selected.push_back(c);
+			nr_remaining -= 2;
+		}
+		if (selected.empty())
+			break;
+
+		// selected collapses modify disjoint triangles and can be applied concurrently
+		nr_blocks = (selected.size() + decimation_block_size - 1) / decimation_block_size;
+		parallel_for(nr_blocks, [&](size_t bi) {
+			size_t end = std::min(selected.size(), (bi + 1)*decimation_block_size);
+			for (size_t si = bi*decimation_block_size; si < end; ++si)
+				apply_collapse(selected[si]);
+		}, nr_threads);
+		nr_collapses += selected.size();
+	}
+
+	// compact the remaining triangles and their vertices
+	std::vector<unsigned> new_index(positions.size(), invalid_index);
+	mesh.clear();
+	for (size_t ti = 0; ti < nr_triangles; ++ti) {
+		if (removed[ti])
+			continue;
+		for (unsigned j = 0; j < 3; ++j) {
+			unsigned v = triangles[3 * ti + j];
+			if (new_index[v] == invalid_index) {
+				new_index[v] = unsigned(mesh.positions.size());
+				mesh.positions.push_back(positions[v]);
+			}
+			mesh.corner_vertices.push_back(new_index[v]);
+		}
+		mesh.face_sizes.push_back(3);
+	}
+	return nr_collapses;
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "surface_extractor.h"
+#include <cgv/math/qem.h>
+
+/** simplifies an extracted mesh by edge collapses in the order of their quadric error. Each
+    vertex accumulates the planes of its incident triangles in a quadric and a collapsed edge
+    is replaced by the minimum of the sum of the quadrics of its end points. Collapses are
+    performed in batches: the connectivity is rebuilt as half-edges, all candidate edges are
+    evaluated in parallel, a heap hands out the cheapest ones that form an independent set,
+    i.e. touch disjoint triangles, and these are collapsed in parallel. Collapses that change
+    the topology or flip triangles are rejected, and boundary and non-manifold vertices keep
+    their positions. */
+class mesh_decimator
+{
+public:
+	typedef extracted_mesh::pnt_type pnt_type;
+	typedef extracted_mesh::vec_type vec_type;
+
+	/// number of triangles at which decimation stops, where zero only applies the error bound
+	unsigned target_nr_triangles;
+	/// maximum distance of a collapsed vertex from the planes of its original triangles in the
+	/// sense of the quadric error, where zero only applies the target triangle count
+	double max_error;
+	/// maximum fraction of the candidate edges collapsed in one batch
+	double batch_fraction;
+	/// number of threads, where zero selects the hardware concurrency
+	unsigned nr_threads;
+
+	/// construct with default parameters
+	mesh_decimator();
+	/// decimate the mesh, whose faces are triangulated before, and remove its normals. Returns
+	/// the number of collapsed edges.
+	size_t decimate(extracted_mesh& mesh);
+
+protected:
+	/// candidate collapse of the edge of a half-edge, where vertex drop is merged into vertex keep
+	/// at the target position
+	struct collapse
+	{
+		unsigned keep, drop;
+		double cost;
+		pnt_type target;
+	};
+	/// vertex positions
+	std::vector<pnt_type> positions;
+	/// quadric per vertex
+	std::vector<cgv::math::qem<double> > quadrics;
+	/// three vertex indices per triangle
+	std::vector<unsigned> triangles;
+	/// per triangle whether it has been removed by a collapse
+	std::vector<unsigned char> removed;
+	/// opposite half-edge per half-edge or -1 for boundary and non-manifold edges, where half-edge
+	/// h leads from corner h%3 to the next corner of triangle h/3
+	std::vector<unsigned> opposite;
+	/// per vertex whether it lies on a boundary or non-manifold edge
+	std::vector<unsigned char> locked;
+	/// triangles incident to vertex v are vertex_triangles[vertex_offsets[v]] up to vertex_offsets[v+1]
+	std::vector<unsigned> vertex_offsets, vertex_triangles;
+
+	/// return the vertex a half-edge starts at
+	unsigned get_origin(unsigned h) const { return triangles[h]; }
+	/// return the vertex a half-edge points to
+	unsigned get_target(unsigned h) const { return triangles[h - h % 3 + (h % 3 + 1) % 3]; }
+	/// return the vertex opposite to a half-edge in its triangle
+	unsigned get_opposite_vertex(unsigned h) const { return triangles[h - h % 3 + (h % 3 + 2) % 3]; }
+	/// rebuild the incident triangles, opposite half-edges and locked vertices from the remaining triangles
+	void build_connectivity();
+	/// store the vertices adjacent to v in sorted order without duplicates
+	void collect_neighbors(unsigned v, std::vector<unsigned>& neighbors) const;
+	/// compute target position and cost of collapsing the edge of half-edge h and return false
+	/// if the collapse is not allowed
+	bool evaluate_collapse(unsigned h, collapse& c) const;
+	/// move the kept vertex to the target and replace the dropped vertex by the kept one
+	void apply_collapse(const collapse& c);
+};
@@ -0,0 +1,198 @@
+#include <cmath>
+#include <limits>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <algorithm>
+#include <memory>
+#include <cgv/math/fvec.h>
+#include "implicit_primitive.h"
+#include "triangle_bvh.h"
+
+/** signed distance field of a triangle mesh loaded from an obj file. The distance is
+    found by a closest point query in a bounding volume hierarchy over the triangles and
+    the sign by the generalized winding number, which is robust for meshes with holes
+    and self intersections. Both queries are logarithmic in the number of triangles. */
+template <typename T>
+struct mesh_sdf : public implicit_primitive<T>
+{
+	typedef typename implicit_base<T>::vec_type vec_type;
+	typedef typename implicit_base<T>::pnt_type pnt_type;
+	typedef typename implicit_base<T>::box_type box_type;
+
+	/// obj file containing the mesh
+	std::string file_name;
+	/// whether to fit the bounding box of the mesh into [-1,1]^3
+	bool normalize;
+	/// winding numbers above this threshold are classified as inside
+	double winding_threshold;
+	/// hierarchy over the loaded triangles, which is shared with the copies in evaluation snapshots
+	std::shared_ptr<const triangle_bvh> bvh;
+	/// whether file_name or normalize have been set since the last load
+	bool reload_requested;
+	/// file name of the currently loaded mesh
+	std::string loaded_file_name;
+	/// whether the loaded mesh has been normalized
+	bool loaded_normalize;
+	/// number of loaded triangles shown in the gui
+	unsigned nr_triangles;
+
+	mesh_sdf() : normalize(true), winding_threshold(0.5), bvh(new triangle_bvh()), reload_requested(false), loaded_normalize(true), nr_triangles(0)
+	{
+		implicit_base<T>::gui_color = 0x88CCFF;
+	}
+	std::string get_type_name() const { return "mesh_sdf"; }
+
+	/// read vertices and faces of an obj file, where polygons are triangulated as fans
+	static bool read_obj(const std::string& fn, std::vector<triangle_bvh::pnt_type>& positions, std::vector<unsigned>& indices)
+	{
+		std::ifstream is(fn.c_str());
+		if (is.fail())
+			return false;
+		std::string line;
+		std::vector<int> face;
+		while (std::getline(is, line)) {
+			if (line.size() < 2)
+				continue;
+			if (line[0] == 'v' && line[1] == ' ') {
+				triangle_bvh::pnt_type p(0, 0, 0);
+				std::istringstream ls(line.substr(2));
+				ls >> p(0) >> p(1) >> p(2);
+				positions.push_back(p);
+			}
+			else if (line[0] == 'f' && line[1] == ' ') {
+				// only the position index before the first slash is used
+				std::istringstream ls(line.substr(2));
+				std::string token;
+				face.clear();
+				while (ls >> token) {
+					int vi = atoi(token.c_str());
+					// negative indices are relative to the end of the vertex list
+					face.push_back(vi < 0 ? int(positions.size()) + vi : vi - 1);
+				}
+				for (size_t i = 2; i < face.size(); ++i) {
+					if (face[0] < 0 || face[i - 1] < 0 || face[i] < 0 ||
+						std::max(face[0], std::max(face[i - 1], face[i])) >= int(positions.size()))
+						continue;
+					indices.push_back(face[0]);
+					indices.push_back(face[i - 1]);
+					indices.push_back(face[i]);
+				}
+			}
+		}
+		return true;
+	}
+	/// load the mesh from file_name and build the hierarchy
+	void load_mesh()
+	{
+		loaded_file_name = file_name;
+		loaded_normalize = normalize;
+		std::vector<triangle_bvh::pnt_type> positions;
+		std::vector<unsigned> indices;
+		if (!file_name.empty() && !read_obj(file_name, positions, indices))
+			std::cerr << "mesh_sdf: could not read " << file_name << std::endl;
+		if (normalize && !positions.empty()) {
+			box_type box;
+			box.invalidate();
+			for (const auto& p : positions)
+				box.add_point(p);
+			vec_type e = box.get_extent();
+			double scale = 2 / std::max(e(0), std::max(e(1), e(2)));
+			pnt_type c = box.get_center();
+			for (auto& p : positions)
+				p = scale * (p - c);
+		}
+		std::shared_ptr<triangle_bvh> new_bvh(new triangle_bvh());
+		new_bvh->build(positions, indices);
+		bvh = new_bvh;
+		reload_requested = false;
+		nr_triangles = unsigned(bvh->get_nr_triangles());
+		provider::update_member(&nr_triangles);
+	}
+	/// reload the mesh when file name or normalization have been set
+	void prepare_node_evaluation()
+	{
+		if (reload_requested || file_name != loaded_file_name || normalize != loaded_normalize)
+			load_mesh();
+	}
+	/// loading is deferred to prepare_node_evaluation, which the scene update triggers
+	void on_set(void* member_ptr)
+	{
+		if (member_ptr == &file_name || member_ptr == &normalize)
+			reload_requested = true;
+		implicit_primitive<T>::on_set(member_ptr);
+	}
+	/// share the hierarchy with a node of either precision instead of reading the file again
+	template <typename S>
+	void share_hierarchy(const implicit_base<S>& source)
+	{
+		const mesh_sdf<S>* src = dynamic_cast<const mesh_sdf<S>*>(&source);
+		if (!src || src->file_name != file_name || src->normalize != normalize || src->reload_requested)
+			return;
+		bvh = src->bvh;
+		loaded_file_name = src->loaded_file_name;
+		loaded_normalize = src->loaded_normalize;
+		nr_triangles = src->nr_triangles;
+		reload_requested = false;
+	}
+	/// share the hierarchy with the node this one has been copied from instead of reading the file again
+	void share_evaluation_data(const implicit_base<T>& source)
+	{
+		share_hierarchy(source);
+	}
+	/// the hierarchy is built in double precision, such that single precision copies share it as well
+	void share_double_evaluation_data(const implicit_base<double>& source)
+	{
+		share_hierarchy(source);
+	}
+	bool self_reflect(cgv::reflect::reflection_handler& rh)
+	{
+		return
+			rh.reflect_member("file_name", file_name) &&
+			rh.reflect_member("normalize", normalize) &&
+			rh.reflect_member("winding_threshold", winding_threshold) &&
+			implicit_primitive<T>::self_reflect(rh);
+	}
+
+	/// distance to the closest point, negative where the winding number exceeds the threshold
+	T evaluate(const pnt_type& p) const
+	{
+		triangle_bvh::closest_point_info info;
+		if (!bvh->find_closest_point(p, info))
+			return 1;
+		T d = T(sqrt(info.sqr_distance));
+		return bvh->winding_number(p) > winding_threshold ? -d : d;
+	}
+
+	/// gradient points away from the closest point and flips its direction inside
+	vec_type evaluate_gradient(const pnt_type& p) const
+	{
+		triangle_bvh::closest_point_info info;
+		if (!bvh->find_closest_point(p, info) || info.sqr_distance == 0)
+			return vec_type(0, 0, 0);
+		vec_type g = (T(1) / T(sqrt(info.sqr_distance))) * (p - info.p);
+		return bvh->winding_number(p) > winding_threshold ? -g : g;
+	}
+
+	/// distance fields are 1-Lipschitz
+	T lipschitz_bound(const box_type& domain) const
+	{
+		return 1;
+	}
+	/// both queries descend the hierarchy
+	double estimate_cost() const
+	{
+		return 1 + std::log2(double(bvh->get_nr_triangles()) + 1);
+	}
+
+	void create_gui()
+	{
+		implicit_primitive<T>::create_gui();
+		provider::add_member_control(this, "file_name", file_name);
+		provider::add_member_control(this, "normalize", normalize, "check");
+		provider::add_member_control(this, "winding_threshold", winding_threshold, "value_slider", "min=0;max=1;ticks=true");
+		provider::add_view("nr_triangles", nr_triangles);
+	}
+};
+
+scene_factory_registration<mesh_sdf<double> > sfr_mesh_sdf("mesh_sdf");
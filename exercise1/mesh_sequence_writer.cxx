@@ -0,0 +1,85 @@
+#include "mesh_sequence_writer.h"
+
+static const char ims_magic[4] = { 'I', 'M', 'S', '1' };
+static const uint32_t ims_version = 1;
+/// offset of the frame count in the header, which is followed by the table offset
+static const std::streamoff ims_nr_frames_position = 12;
+
+template <typename V>
+static void write_binary(std::ostream& os, V value)
+{
+	os.write(reinterpret_cast<const char*>(&value), sizeof(V));
+}
+
+/// construct without output file
+mesh_sequence_writer::mesh_sequence_writer() : nr_shells(0)
+{
+}
+
+/// create the file and write its header
+bool mesh_sequence_writer::open(const std::string& file_name, unsigned _nr_shells)
+{
+	if (os.is_open())
+		os.close();
+	frames.clear();
+	nr_shells = _nr_shells;
+	os.open(file_name.c_str(), std::ios::binary);
+	if (os.fail())
+		return false;
+	// frame count and table offset are written by close
+	os.write(ims_magic, 4);
+	write_binary(os, ims_version);
+	write_binary(os, uint32_t(nr_shells));
+	write_binary(os, uint32_t(0));
+	write_binary(os, uint64_t(0));
+	return !os.fail();
+}
+
+/// append the meshes of the frame at the given time
+bool mesh_sequence_writer::append_frame(double time, const std::vector<extracted_mesh>& meshes)
+{
+	if (!os.is_open() || meshes.size() != nr_shells)
+		return false;
+	frames.push_back(std::make_pair(time, uint64_t(os.tellp())));
+	for (size_t si = 0; si < meshes.size(); ++si) {
+		const extracted_mesh& mesh = meshes[si];
+		write_binary(os, uint64_t(mesh.positions.size()));
+		write_binary(os, uint64_t(mesh.face_sizes.size()));
+		write_binary(os, uint64_t(mesh.corner_vertices.size()));
+		if (!mesh.positions.empty())
+			os.write((const char*)&mesh.positions.front(), mesh.positions.size()*sizeof(extracted_mesh::pnt_type));
+		// meshes without normals get zero normals, such that all records have the same layout
+		if (mesh.normals.size() == mesh.positions.size()) {
+			if (!mesh.normals.empty())
+				os.write((const char*)&mesh.normals.front(), mesh.normals.size()*sizeof(extracted_mesh::vec_type));
+		}
+		else {
+			std::vector<extracted_mesh::vec_type> zero_normals(mesh.positions.size(), extracted_mesh::vec_type(0, 0, 0));
+			if (!zero_normals.empty())
+				os.write((const char*)&zero_normals.front(), zero_normals.size()*sizeof(extracted_mesh::vec_type));
+		}
+		if (!mesh.face_sizes.empty())
+			os.write((const char*)&mesh.face_sizes.front(), mesh.face_sizes.size()*sizeof(unsigned));
+		if (!mesh.corner_vertices.empty())
+			os.write((const char*)&mesh.corner_vertices.front(), mesh.corner_vertices.size()*sizeof(unsigned));
+	}
+	return !os.fail();
+}
+
+/// write the frame table and close the file
+bool mesh_sequence_writer::close()
+{
+	if (!os.is_open())
+		return false;
+	uint64_t table_offset = uint64_t(os.tellp());
+	for (size_t fi = 0; fi < frames.size(); ++fi) {
+		write_binary(os, frames[fi].first);
+		write_binary(os, frames[fi].second);
+	}
+	os.seekp(ims_nr_frames_position);
+	write_binary(os, uint32_t(frames.size()));
+	write_binary(os, table_offset);
+	bool success = !os.fail();
+	os.close();
+	return success;
+}
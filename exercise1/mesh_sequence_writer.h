@@ -0,0 +1,38 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <cstdint>
+#include "surface_extractor.h"
+
+/** writes the meshes of an extracted animation to one binary mesh sequence cache (.ims), which
+    can be read frame by frame without parsing. All numbers are in native byte order:
+    header:      char magic[4] = "IMS1", uint32 version, uint32 nr_shells, uint32 nr_frames,
+                 uint64 table_offset
+    frames:      per frame and shell uint64 nr_vertices, nr_faces, nr_corners, followed by
+                 nr_vertices double positions and normals of three components each, nr_faces
+                 uint32 face sizes and nr_corners uint32 corner vertex indices
+    frame table: starts at table_offset and holds per frame its double time and uint64 offset
+    The frame count and the table are written by close. */
+class mesh_sequence_writer
+{
+protected:
+	/// output file
+	std::ofstream os;
+	/// number of meshes per frame
+	unsigned nr_shells;
+	/// time and file offset per written frame
+	std::vector<std::pair<double, uint64_t> > frames;
+public:
+	/// construct without output file
+	mesh_sequence_writer();
+	/// create the file and write its header for frames of nr_shells meshes
+	bool open(const std::string& file_name, unsigned nr_shells);
+	/// append the meshes of the frame at the given time, which must be one per shell
+	bool append_frame(double time, const std::vector<extracted_mesh>& meshes);
+	/// write the frame table and close the file
+	bool close();
+	/// return the number of frames written so far
+	size_t get_nr_frames() const { return frames.size(); }
+};
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+/// return the number of worker threads to use if nr_threads is zero
+inline unsigned get_nr_worker_threads(unsigned nr_threads = 0)
+{
+	if (nr_threads > 0)
+		return nr_threads;
+	return std::max(1u, std::thread::hardware_concurrency());
+}
+
+/** call f(i) for all i in [0,n) on nr_threads threads including the calling one, where
+    indices are handed out dynamically such that unevenly expensive work is balanced.
+    A value of zero for nr_threads selects the hardware concurrency. */
+template <typename F>
+void parallel_for(size_t n, const F& f, unsigned nr_threads = 0)
+{
+	nr_threads = (unsigned)std::min<size_t>(get_nr_worker_threads(nr_threads), n);
+	if (nr_threads <= 1) {
+		for (size_t i = 0; i < n; ++i)
+			f(i);
+		return;
+	}
+	std::atomic<size_t> next(0);
+	auto worker = [&]() {
+		for (size_t i = next++; i < n; i = next++)
+			f(i);
+	};
+	std::vector<std::thread> threads;
+	for (unsigned t = 1; t < nr_threads; ++t)
+		threads.emplace_back(worker);
+	worker();
+	for (auto& t : threads)
+		t.join();
+}
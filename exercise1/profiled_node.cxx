@@ -0,0 +1,74 @@
+#include "profiled_node.h"
+
+/// construct for the node registered under the given index
+template <typename T>
+profiled_node<T>::profiled_node(evaluation_profiler* _profiler, unsigned _profile_index)
+	: profiler(_profiler), profile_index(_profile_index)
+{
+}
+
+template <typename T>
+std::string profiled_node<T>::get_type_name() const
+{
+	return "profiled_node";
+}
+
+/// measure the evaluation of the child
+template <typename T>
+T profiled_node<T>::evaluate(const pnt_type& p) const
+{
+	if (group::get_nr_children() == 0)
+		return 1;
+	evaluation_profiler::scope s(*profiler, profile_index, false);
+	return implicit_group<T>::get_implicit_child(0)->evaluate(p);
+}
+
+/// measure the bounded evaluation of the child
+template <typename T>
+T profiled_node<T>::evaluate_bounded(const pnt_type& p, T lo, T hi) const
+{
+	if (group::get_nr_children() == 0)
+		return 1;
+	evaluation_profiler::scope s(*profiler, profile_index, false);
+	return implicit_group<T>::get_implicit_child(0)->evaluate_bounded(p, lo, hi);
+}
+
+/// measure the gradient evaluation of the child
+template <typename T>
+typename profiled_node<T>::vec_type profiled_node<T>::evaluate_gradient(const pnt_type& p) const
+{
+	if (group::get_nr_children() == 0)
+		return vec_type(0, 0, 0);
+	evaluation_profiler::scope s(*profiler, profile_index, true);
+	return implicit_group<T>::get_implicit_child(0)->evaluate_gradient(p);
+}
+
+/// forward the color evaluation without measuring it
+template <typename T>
+typename profiled_node<T>::clr_type profiled_node<T>::evaluate_color(const pnt_type& p) const
+{
+	if (group::get_nr_children() == 0)
+		return implicit_base<T>::color;
+	return implicit_group<T>::get_implicit_child(0)->evaluate_color(p);
+}
+
+/// forward to the child
+template <typename T>
+implicit_base<T>* profiled_node<T>::find_determining_leaf(const pnt_type& p)
+{
+	if (group::get_nr_children() == 0)
+		return this;
+	return implicit_group<T>::get_implicit_child(0)->find_determining_leaf(p);
+}
+
+/// the wrapper adds no cost to the child
+template <typename T>
+double profiled_node<T>::estimate_cost() const
+{
+	if (group::get_nr_children() == 0)
+		return 1;
+	return implicit_group<T>::get_implicit_child(0)->estimate_cost();
+}
+
+template class profiled_node<double>;
+template class profiled_node<float>;
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "implicit_group.h"
+#include "evaluation_profiler.h"
+
+/** wrapper around a single child that forwards all evaluations to the child and measures
+    them with an evaluation_profiler. Wrappers are inserted above every node of an
+    evaluation snapshot while profiling is enabled and never appear in the live scene. */
+template <typename T>
+class profiled_node : public implicit_group<T>
+{
+public:
+	typedef typename implicit_base<T>::clr_type clr_type;
+	typedef typename implicit_base<T>::vec_type vec_type;
+	typedef typename implicit_base<T>::pnt_type pnt_type;
+protected:
+	/// profiler that receives the measurements
+	evaluation_profiler* profiler;
+	/// index of the wrapped node in the profiler
+	unsigned profile_index;
+public:
+	/// construct for the node registered under the given index
+	profiled_node(evaluation_profiler* _profiler, unsigned _profile_index);
+	/// returns "profiled_node"
+	std::string get_type_name() const;
+	/// measure the evaluation of the child
+	T evaluate(const pnt_type& p) const;
+	/// measure the bounded evaluation of the child
+	T evaluate_bounded(const pnt_type& p, T lo, T hi) const;
+	/// measure the gradient evaluation of the child
+	vec_type evaluate_gradient(const pnt_type& p) const;
+	/// forward the color evaluation without measuring it
+	clr_type evaluate_color(const pnt_type& p) const;
+	/// forward to the child
+	implicit_base<T>* find_determining_leaf(const pnt_type& p);
+	/// the wrapper adds no cost to the child such that csg orders stay unchanged
+	double estimate_cost() const;
+};
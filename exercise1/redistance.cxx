@@ -0,0 +1,336 @@
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <cgv/math/fvec.h>
+#include "implicit_group.h"
+#include "parallel.h"
+
+/** converts the function of its child into a signed distance field. The child is sampled
+    on a regular grid, distances are initialized at the grid edges with sign changes and
+    propagated with a fast sweeping solver of the Eikonal equation |grad u| = 1. The
+    result is evaluated by trilinear interpolation and can be bounded with a Lipschitz
+    constant close to one, which allows large safe steps for sphere tracing and culling. */
+template <typename T>
+class redistance : public implicit_group<T>
+{
+	/// copies of the other precision share the distance field
+	template <typename S> friend class redistance;
+public:
+	typedef typename implicit_base<T>::vec_type vec_type;
+	typedef typename implicit_base<T>::pnt_type pnt_type;
+	typedef typename implicit_base<T>::box_type box_type;
+
+protected:
+	/// number of grid samples per axis
+	unsigned res;
+	/// number of rounds of the eight sweep directions
+	unsigned nr_sweep_rounds;
+	/// grid domain
+	box_type domain;
+	/// signed distances at the grid nodes
+	std::vector<T> values;
+	/// grid spacing per axis
+	vec_type spacing;
+	/// lipschitz constant of the interpolated distance field
+	T grid_lipschitz;
+	/// whether the grid has been computed for the current child
+	bool valid;
+	/// whether the grid has been copied from the source of a snapshot copy and need not be recomputed
+	bool field_shared;
+	/// child, version of its subtree, resolution, number of sweep rounds and domain of the last computed field
+	const implicit_base<T>* field_child;
+	unsigned long long field_child_version;
+	unsigned field_res, field_nr_sweep_rounds;
+	box_type field_domain;
+
+	/// linear index of grid node
+	size_t node_index(unsigned i, unsigned j, unsigned k) const { return (size_t(k)*res + j)*res + i; }
+	/// sample child, initialize distances close to the zero crossings and run fast sweeping
+	void compute_distance_field()
+	{
+		valid = false;
+		if (group::get_nr_children() == 0 || res < 2)
+			return;
+		const implicit_base<T>* child_ptr = implicit_group<T>::get_implicit_child(0);
+		for (unsigned c = 0; c < 3; ++c)
+			spacing(c) = domain.get_extent()(c) / (res - 1);
+
+		// sample the child function slice by slice in parallel
+		std::vector<T> f(size_t(res)*res*res);
+		parallel_for(res, [&](size_t k) {
+			for (unsigned j = 0; j < res; ++j)
+				for (unsigned i = 0; i < res; ++i)
+					f[node_index(i, j, unsigned(k))] = child_ptr->evaluate(get_node_location(i, j, unsigned(k)));
+		});
+
+		// initialize unsigned distances of nodes incident to edges with sign changes from
+		// the linearly interpolated crossing locations and freeze them
+		const T inf = std::numeric_limits<T>::infinity();
+		values.assign(f.size(), inf);
+		std::vector<char> frozen(f.size(), 0);
+		for (unsigned k = 0; k < res; ++k)
+			for (unsigned j = 0; j < res; ++j)
+				for (unsigned i = 0; i < res; ++i) {
+					size_t vi = node_index(i, j, k);
+					unsigned idx[3] = { i, j, k };
+					size_t stride[3] = { 1, res, size_t(res)*res };
+					for (unsigned c = 0; c < 3; ++c) {
+						if (idx[c] + 1 >= res)
+							continue;
+						size_t vj = vi + stride[c];
+						if ((f[vi] < 0) == (f[vj] < 0))
+							continue;
+						T theta = f[vi] / (f[vi] - f[vj]);
+						values[vi] = std::min(values[vi], theta*spacing(c));
+						values[vj] = std::min(values[vj], (1 - theta)*spacing(c));
+						frozen[vi] = frozen[vj] = 1;
+					}
+				}
+
+		// fast sweeping in the eight diagonal directions
+		for (unsigned round = 0; round < nr_sweep_rounds; ++round)
+			for (unsigned dir = 0; dir < 8; ++dir)
+				sweep(dir, frozen);
+
+		// apply signs and determine the lipschitz constant along the grid axes
+		T axis_lipschitz = 0;
+		for (size_t vi = 0; vi < values.size(); ++vi) {
+			if (values[vi] == inf)
+				values[vi] = domain.get_extent().length();
+			if (f[vi] < 0)
+				values[vi] = -values[vi];
+		}
+		for (unsigned k = 0; k < res; ++k)
+			for (unsigned j = 0; j < res; ++j)
+				for (unsigned i = 0; i < res; ++i) {
+					size_t vi = node_index(i, j, k);
+					if (i + 1 < res)
+						axis_lipschitz = std::max(axis_lipschitz, std::abs(values[vi + 1] - values[vi]) / spacing(0));
+					if (j + 1 < res)
+						axis_lipschitz = std::max(axis_lipschitz, std::abs(values[vi + res] - values[vi]) / spacing(1));
+					if (k + 1 < res)
+						axis_lipschitz = std::max(axis_lipschitz, std::abs(values[vi + size_t(res)*res] - values[vi]) / spacing(2));
+				}
+		// trilinear interpolation is bounded per axis, so the gradient length by sqrt(3) times that
+		grid_lipschitz = std::max(T(1), axis_lipschitz * std::sqrt(T(3)));
+		valid = true;
+	}
+	/// one Gauss-Seidel sweep in the octant direction encoded by the bits of dir
+	void sweep(unsigned dir, const std::vector<char>& frozen)
+	{
+		const T inf = std::numeric_limits<T>::infinity();
+		for (unsigned kk = 0; kk < res; ++kk) {
+			unsigned k = (dir & 4) ? res - 1 - kk : kk;
+			for (unsigned jj = 0; jj < res; ++jj) {
+				unsigned j = (dir & 2) ? res - 1 - jj : jj;
+				for (unsigned ii = 0; ii < res; ++ii) {
+					unsigned i = (dir & 1) ? res - 1 - ii : ii;
+					size_t vi = node_index(i, j, k);
+					if (frozen[vi])
+						continue;
+					T a[3] = {
+						std::min(i > 0 ? values[vi - 1] : inf, i + 1 < res ? values[vi + 1] : inf),
+						std::min(j > 0 ? values[vi - res] : inf, j + 1 < res ? values[vi + res] : inf),
+						std::min(k > 0 ? values[vi - size_t(res)*res] : inf, k + 1 < res ? values[vi + size_t(res)*res] : inf)
+					};
+					T u = solve_eikonal(a);
+					if (u < values[vi])
+						values[vi] = u;
+				}
+			}
+		}
+	}
+	/// Godunov upwind solution of the discretized Eikonal equation for neighbor minima a
+	T solve_eikonal(T a[3]) const
+	{
+		T h[3] = { spacing(0), spacing(1), spacing(2) };
+		// sort neighbor values ascendingly together with their spacings
+		for (unsigned m = 0; m < 2; ++m)
+			for (unsigned n = 0; n + 1 < 3 - m; ++n)
+				if (a[n] > a[n + 1]) {
+					std::swap(a[n], a[n + 1]);
+					std::swap(h[n], h[n + 1]);
+				}
+		if (a[0] == std::numeric_limits<T>::infinity())
+			return a[0];
+		// solve sum_c ((u - a_c) / h_c)^2 = 1 with increasing number of contributing axes
+		T u = a[0] + h[0];
+		T sum_w = 0, sum_wa = 0, sum_wa2 = 0;
+		for (unsigned n = 0; n < 3; ++n) {
+			if (n > 0 && u <= a[n])
+				break;
+			T w = 1 / (h[n] * h[n]);
+			sum_w += w;
+			sum_wa += w * a[n];
+			sum_wa2 += w * a[n] * a[n];
+			T disc = sum_wa*sum_wa - sum_w*(sum_wa2 - 1);
+			if (disc < 0)
+				break;
+			u = (sum_wa + std::sqrt(disc)) / sum_w;
+		}
+		return u;
+	}
+	/// location of grid node
+	pnt_type get_node_location(unsigned i, unsigned j, unsigned k) const
+	{
+		return domain.get_min_pnt() + pnt_type(i*spacing(0), j*spacing(1), k*spacing(2));
+	}
+	/// trilinear interpolation of the distance field and its gradient at a point inside the domain
+	T interpolate(const pnt_type& p, vec_type* grad_ptr) const
+	{
+		unsigned idx[3];
+		T w[3];
+		for (unsigned c = 0; c < 3; ++c) {
+			T x = (p(c) - domain.get_min_pnt()(c)) / spacing(c);
+			x = std::min(std::max(x, T(0)), T(res - 1));
+			idx[c] = std::min(unsigned(x), res - 2);
+			w[c] = x - idx[c];
+		}
+		size_t vi = node_index(idx[0], idx[1], idx[2]);
+		size_t sj = res, sk = size_t(res)*res;
+		T v[8] = {
+			values[vi], values[vi + 1], values[vi + sj], values[vi + sj + 1],
+			values[vi + sk], values[vi + sk + 1], values[vi + sk + sj], values[vi + sk + sj + 1]
+		};
+		T x00 = v[0] + w[0]*(v[1] - v[0]), x10 = v[2] + w[0]*(v[3] - v[2]);
+		T x01 = v[4] + w[0]*(v[5] - v[4]), x11 = v[6] + w[0]*(v[7] - v[6]);
+		T y0 = x00 + w[1]*(x10 - x00), y1 = x01 + w[1]*(x11 - x01);
+		if (grad_ptr) {
+			T dx0 = (1 - w[1])*(v[1] - v[0]) + w[1]*(v[3] - v[2]);
+			T dx1 = (1 - w[1])*(v[5] - v[4]) + w[1]*(v[7] - v[6]);
+			(*grad_ptr)(0) = ((1 - w[2])*dx0 + w[2]*dx1) / spacing(0);
+			(*grad_ptr)(1) = ((1 - w[2])*(x10 - x00) + w[2]*(x11 - x01)) / spacing(1);
+			(*grad_ptr)(2) = (y1 - y0) / spacing(2);
+		}
+		return y0 + w[2]*(y1 - y0);
+	}
+	/// closest point to p inside the domain
+	pnt_type clamp_to_domain(const pnt_type& p) const
+	{
+		pnt_type q;
+		for (unsigned c = 0; c < 3; ++c)
+			q(c) = std::min(std::max(p(c), domain.get_min_pnt()(c)), domain.get_max_pnt()(c));
+		return q;
+	}
+
+public:
+	/// construct with a grid of 64^3 samples over [-1.5,1.5]^3
+	redistance() : res(64), nr_sweep_rounds(2), domain(pnt_type(-1.5, -1.5, -1.5), pnt_type(1.5, 1.5, 1.5)),
+		spacing(0, 0, 0), grid_lipschitz(1), valid(false), field_shared(false), field_child(0), field_child_version(0),
+		field_res(0), field_nr_sweep_rounds(0)
+	{
+		implicit_base<T>::gui_color = 0x00FFFF;
+	}
+	std::string get_type_name() const { return "redistance"; }
+	bool self_reflect(cgv::reflect::reflection_handler& rh)
+	{
+		return
+			rh.reflect_member("res", res) &&
+			rh.reflect_member("nr_sweep_rounds", nr_sweep_rounds) &&
+			rh.reflect_member("minx", domain.ref_min_pnt()(0)) &&
+			rh.reflect_member("miny", domain.ref_min_pnt()(1)) &&
+			rh.reflect_member("minz", domain.ref_min_pnt()(2)) &&
+			rh.reflect_member("maxx", domain.ref_max_pnt()(0)) &&
+			rh.reflect_member("maxy", domain.ref_max_pnt()(1)) &&
+			rh.reflect_member("maxz", domain.ref_max_pnt()(2)) &&
+			implicit_group<T>::self_reflect(rh);
+	}
+	/// recompute the distance field from the prepared child if the child or the grid changed since the
+	/// last computation, as the scene prepares all nodes after parsing a changed description
+	void prepare_node_evaluation()
+	{
+		const implicit_base<T>* child_ptr = group::get_nr_children() > 0 ? implicit_group<T>::get_implicit_child(0) : 0;
+		unsigned long long child_version = child_ptr ? child_ptr->get_subtree_version() : 0;
+		if (field_shared)
+			field_shared = false;
+		else if (child_ptr != field_child || child_version != field_child_version || res != field_res ||
+			nr_sweep_rounds != field_nr_sweep_rounds || field_domain.get_min_pnt() != domain.get_min_pnt() ||
+			field_domain.get_max_pnt() != domain.get_max_pnt())
+			compute_distance_field();
+		field_child = child_ptr;
+		field_child_version = child_version;
+		field_res = res;
+		field_nr_sweep_rounds = nr_sweep_rounds;
+		field_domain = domain;
+	}
+	/// copy the distance field of a node of either precision, as it has been computed from an
+	/// identical child
+	template <typename S>
+	void copy_distance_field(const implicit_base<S>& source)
+	{
+		const redistance<S>* src = dynamic_cast<const redistance<S>*>(&source);
+		if (!src || !src->valid || src->res != res ||
+			pnt_type(src->domain.get_min_pnt()) != domain.get_min_pnt() ||
+			pnt_type(src->domain.get_max_pnt()) != domain.get_max_pnt())
+			return;
+		values.assign(src->values.begin(), src->values.end());
+		spacing = vec_type(src->spacing);
+		grid_lipschitz = T(src->grid_lipschitz);
+		valid = true;
+		field_shared = true;
+	}
+	/// copy the distance field of the node this one has been copied from
+	void share_evaluation_data(const implicit_base<T>& source)
+	{
+		copy_distance_field(source);
+	}
+	/// a single precision copy converts the distance field instead of sampling the child again
+	void share_double_evaluation_data(const implicit_base<double>& source)
+	{
+		copy_distance_field(source);
+	}
+	/// interpolate inside the grid and add the distance to the grid outside
+	T evaluate(const pnt_type& p) const
+	{
+		if (group::get_nr_children() == 0)
+			return 1;
+		if (!valid)
+			return implicit_group<T>::get_implicit_child(0)->evaluate(p);
+		pnt_type q = clamp_to_domain(p);
+		return interpolate(q, 0) + (p - q).length();
+	}
+	vec_type evaluate_gradient(const pnt_type& p) const
+	{
+		if (group::get_nr_children() == 0)
+			return vec_type(0, 0, 0);
+		if (!valid)
+			return implicit_group<T>::get_implicit_child(0)->evaluate_gradient(p);
+		pnt_type q = clamp_to_domain(p);
+		vec_type d = p - q;
+		vec_type g;
+		interpolate(q, &g);
+		T l = d.length();
+		if (l == 0)
+			return g;
+		// along clamped axes only the distance to the domain varies, along the others only the field
+		for (unsigned c = 0; c < 3; ++c)
+			g(c) = d(c) != 0 ? d(c) / l : g(c);
+		return g;
+	}
+	/// the interpolated field has a bounded gradient independent of the child. Outside the domain the
+	/// field varies along the unclamped axes and the distance to the domain along the others, such
+	/// that both bounds add up orthogonally.
+	T lipschitz_bound(const box_type& d) const
+	{
+		if (!valid)
+			return implicit_group<T>::lipschitz_bound(d);
+		for (unsigned c = 0; c < 3; ++c)
+			if (d.get_min_pnt()(c) < domain.get_min_pnt()(c) || d.get_max_pnt()(c) > domain.get_max_pnt()(c))
+				return std::sqrt(grid_lipschitz*grid_lipschitz + 1);
+		return grid_lipschitz;
+	}
+	/// lookup of eight grid values
+	double estimate_cost() const
+	{
+		return 2;
+	}
+	void create_gui()
+	{
+		provider::add_member_control(this, "res", res, "value_slider", "min=4;max=256;log=true;ticks=true");
+		provider::add_member_control(this, "nr_sweep_rounds", nr_sweep_rounds, "value_slider", "min=1;max=8;ticks=true");
+		provider::add_gui("domain", domain, "", "options='min=-10;max=10;ticks=true'");
+		implicit_group<T>::create_gui();
+	}
+};
+
+scene_factory_registration<redistance<double> >sfr_redistance("redistance");
@@ -0,0 +1,513 @@
+#include "sample_grid.h"
+#include "parallel.h"
+#include <algorithm>
+#include <bitset>
+#include <cmath>
+#include <cstring>
+#include <atomic>
+#include <limits>
+
+/// number of samples per brick
+static const unsigned brick_size = 512;
+/// number of sampled slices kept while encoding a layer of bricks, which is the layer and one slice on either side
+static const unsigned window_size = 10;
+static const uint32_t invalid_index = uint32_t(-1);
+
+/// convert a float to the nearest half precision float, where values beyond the half range are clamped
+static uint16_t float_to_half(float f)
+{
+	uint32_t x;
+	std::memcpy(&x, &f, sizeof(x));
+	uint16_t sign = uint16_t((x >> 16) & 0x8000);
+	uint32_t float_exponent = (x >> 23) & 0xff, mantissa = x & 0x7fffff;
+	if (float_exponent == 0xff)
+		return uint16_t(sign | 0x7c00 | (mantissa != 0 ? 0x200 : 0));
+	int exponent = int(float_exponent) - 127 + 15;
+	if (exponent >= 31)
+		return uint16_t(sign | 0x7bff);
+	uint32_t h, rest, half;
+	if (exponent <= 0) {
+		// subnormal half
+		if (exponent < -10)
+			return sign;
+		mantissa |= 0x800000;
+		unsigned shift = unsigned(14 - exponent);
+		h = mantissa >> shift;
+		rest = mantissa & ((1u << shift) - 1);
+		half = 1u << (shift - 1);
+	}
+	else {
+		h = (uint32_t(exponent) << 10) | (mantissa >> 13);
+		rest = mantissa & 0x1fff;
+		half = 0x1000;
+	}
+	// round to nearest even, where a carry into the exponent is correct except beyond the largest half
+	if (rest > half || (rest == half && (h & 1) != 0))
+		++h;
+	return uint16_t(sign | std::min(h, uint32_t(0x7bff)));
+}
+
+/// convert a half precision float to float
+static float half_to_float(uint16_t h)
+{
+	uint32_t sign = uint32_t(h & 0x8000) << 16, exponent = (h >> 10) & 0x1f, mantissa = h & 0x3ff;
+	if (exponent == 0) {
+		float f = std::ldexp(float(mantissa), -24);
+		return sign != 0 ? -f : f;
+	}
+	uint32_t x = sign | (exponent == 31 ? 0x7f800000 : (exponent + 112) << 23) | (mantissa << 13);
+	float f;
+	std::memcpy(&f, &x, sizeof(f));
+	return f;
+}
+
+/// construct an empty grid with dense double storage
+sample_grid::sample_grid()
+	: encoding(DOUBLE_SAMPLES), sparse(false), band_width(1), isovalues(1, 0.0), nr_threads(0), res(0), nr_bricks(0),
+	  band_center(0), band_half_width(1), peak_memory(0),
+	  band_limited(false), nr_refined(0)
+{
+}
+
+/// return whether contouring the grid at isovalue gives the same result as with dense doubles
+bool sample_grid::is_exact_for(double isovalue) const
+{
+	return (encoding == DOUBLE_SAMPLES && !sparse && !band_limited) || std::binary_search(levels.begin(), levels.end(), isovalue);
+}
+
+/// return the number of isovalues of the last build that are less than or equal to v
+unsigned sample_grid::get_level(double v) const
+{
+	unsigned l = 0;
+	for (size_t i = 0; i < levels.size(); ++i)
+		if (v >= levels[i])
+			++l;
+	return l;
+}
+
+/// remove all samples
+void sample_grid::clear()
+{
+	res = 0;
+	nr_bricks = 0;
+	std::vector<double>().swap(values);
+	std::vector<brick>().swap(bricks);
+	std::vector<unsigned char>().swap(samples);
+	std::vector<double>().swap(exact_values);
+	std::vector<uint64_t>().swap(exact_masks);
+}
+
+/// return the number of bytes per encoded sample
+size_t sample_grid::get_sample_size() const
+{
+	switch (encoding) {
+	case FLOAT32_SAMPLES: return sizeof(float);
+	case FLOAT16_SAMPLES: return sizeof(uint16_t);
+	case INT16_SAMPLES: return sizeof(int16_t);
+	case INT8_SAMPLES: return sizeof(int8_t);
+	default: return sizeof(double);
+	}
+}
+
+/// return an upper bound of the encoding error of samples of at most the given magnitude
+double sample_grid::get_max_encoding_error(double magnitude) const
+{
+	switch (encoding) {
+	case FLOAT32_SAMPLES: return std::ldexp(magnitude, -23) + std::numeric_limits<float>::denorm_min();
+	case FLOAT16_SAMPLES: return magnitude > 65504 ? std::numeric_limits<double>::infinity() : std::ldexp(magnitude, -10) + std::ldexp(1.0, -24);
+	case INT16_SAMPLES: return band_half_width / 32767;
+	case INT8_SAMPLES: return band_half_width / 127;
+	default: return 0;
+	}
+}
+
+/// encode n samples, where samples that change their level are stored exactly by the caller
+void sample_grid::encode(const double* v, size_t n, unsigned char* ptr) const
+{
+	switch (encoding) {
+	case FLOAT32_SAMPLES:
+		for (size_t i = 0; i < n; ++i, ptr += sizeof(float)) {
+			float f = float(v[i]);
+			std::memcpy(ptr, &f, sizeof(f));
+		}
+		break;
+	case FLOAT16_SAMPLES:
+		for (size_t i = 0; i < n; ++i, ptr += sizeof(uint16_t)) {
+			uint16_t h = float_to_half(float(v[i]));
+			std::memcpy(ptr, &h, sizeof(h));
+		}
+		break;
+	case INT16_SAMPLES:
+	case INT8_SAMPLES: {
+		double max_code = encoding == INT16_SAMPLES ? 32767 : 127;
+		for (size_t i = 0; i < n; ++i) {
+			double x = std::max(-1.0, std::min(1.0, (v[i] - band_center) / band_half_width));
+			int code = int(std::floor(x*max_code + 0.5));
+			if (encoding == INT16_SAMPLES) {
+				int16_t c = int16_t(code);
+				std::memcpy(ptr + i*sizeof(c), &c, sizeof(c));
+			}
+			else
+				ptr[i] = (unsigned char)int8_t(code);
+		}
+		break;
+	}
+	default:
+		std::memcpy(ptr, v, n*sizeof(double));
+		break;
+	}
+}
+
+/// decode n samples
+void sample_grid::decode(const unsigned char* ptr, size_t n, double* v) const
+{
+	switch (encoding) {
+	case FLOAT32_SAMPLES:
+		for (size_t i = 0; i < n; ++i, ptr += sizeof(float)) {
+			float f;
+			std::memcpy(&f, ptr, sizeof(f));
+			v[i] = f;
+		}
+		break;
+	case FLOAT16_SAMPLES:
+		for (size_t i = 0; i < n; ++i, ptr += sizeof(uint16_t)) {
+			uint16_t h;
+			std::memcpy(&h, ptr, sizeof(h));
+			v[i] = half_to_float(h);
+		}
+		break;
+	case INT16_SAMPLES:
+		for (size_t i = 0; i < n; ++i, ptr += sizeof(int16_t)) {
+			int16_t c;
+			std::memcpy(&c, ptr, sizeof(c));
+			v[i] = band_center + c*band_half_width / 32767;
+		}
+		break;
+	case INT8_SAMPLES:
+		for (size_t i = 0; i < n; ++i)
+			v[i] = band_center + int8_t(ptr[i])*band_half_width / 127;
+		break;
+	default:
+		std::memcpy(v, ptr, n*sizeof(double));
+		break;
+	}
+}
+
+/// return the sample with brick local index l of a brick
+double sample_grid::get_brick_value(const brick& b, unsigned l) const
+{
+	if (b.first_exact != invalid_index) {
+		const uint64_t* mask = &exact_masks[8 * size_t(b.exact_mask)];
+		unsigned w = l / 64;
+		uint64_t bit = uint64_t(1) << (l % 64);
+		if ((mask[w] & bit) != 0) {
+			// exact samples are stored in the order of their local indices
+			size_t rank = std::bitset<64>(mask[w] & (bit - 1)).count();
+			for (unsigned i = 0; i < w; ++i)
+				rank += std::bitset<64>(mask[i]).count();
+			return exact_values[b.first_exact + rank];
+		}
+	}
+	if (b.sample_block == invalid_index)
+		return b.uniform_value;
+	double v;
+	decode(&samples[(size_t(b.sample_block)*brick_size + l)*get_sample_size()], 1, &v);
+	return v;
+}
+
+/// decode the 64 samples of a brick with local indices 64*w to 64*w+63, which form one slice of the brick
+void sample_grid::decode_brick_slice(const brick& b, unsigned w, double* v) const
+{
+	if (b.sample_block == invalid_index)
+		std::fill(v, v + 64, b.uniform_value);
+	else
+		decode(&samples[(size_t(b.sample_block)*brick_size + 64 * w)*get_sample_size()], 64, v);
+	if (b.first_exact == invalid_index)
+		return;
+	const uint64_t* mask = &exact_masks[8 * size_t(b.exact_mask)];
+	size_t rank = b.first_exact;
+	for (unsigned i = 0; i < w; ++i)
+		rank += std::bitset<64>(mask[i]).count();
+	for (unsigned l = 0; l < 64; ++l)
+		if ((mask[w] >> l) & 1)
+			v[l] = exact_values[rank++];
+}
+
+/// return the sample at a grid node
+double sample_grid::get_value(unsigned i, unsigned j, unsigned k) const
+{
+	if (!values.empty())
+		return values[(size_t(k)*res + j)*res + i];
+	const brick& b = bricks[(size_t(k / 8)*nr_bricks + j / 8)*nr_bricks + i / 8];
+	return get_brick_value(b, ((k % 8) * 8 + j % 8) * 8 + i % 8);
+}
+
+/// return the samples of slice k if they are stored densely as doubles and 0 otherwise
+const double* sample_grid::get_dense_slice(unsigned k) const
+{
+	return values.empty() ? 0 : &values[size_t(k)*res*res];
+}
+
+/// decode the res^2 samples of slice k into slice
+void sample_grid::get_slice(unsigned k, double* slice) const
+{
+	if (!values.empty()) {
+		std::copy(values.begin() + size_t(k)*res*res, values.begin() + size_t(k + 1)*res*res, slice);
+		return;
+	}
+	double v[64];
+	for (unsigned bj = 0; bj < nr_bricks; ++bj)
+		for (unsigned bi = 0; bi < nr_bricks; ++bi) {
+			decode_brick_slice(bricks[(size_t(k / 8)*nr_bricks + bj)*nr_bricks + bi], k % 8, v);
+			unsigned j_end = std::min(res, 8 * bj + 8), i_end = std::min(res, 8 * bi + 8);
+			for (unsigned j = 8 * bj; j < j_end; ++j)
+				std::copy(v + (j % 8) * 8, v + (j % 8) * 8 + i_end - 8 * bi, slice + size_t(j)*res + 8 * bi);
+		}
+}
+
+/// decode the res samples of row j of slice k into row
+void sample_grid::get_row(unsigned j, unsigned k, double* row) const
+{
+	if (!values.empty()) {
+		std::copy(values.begin() + (size_t(k)*res + j)*res, values.begin() + (size_t(k)*res + j + 1)*res, row);
+		return;
+	}
+	const brick* brick_row = &bricks[(size_t(k / 8)*nr_bricks + j / 8)*nr_bricks];
+	unsigned l0 = ((k % 8) * 8 + j % 8) * 8;
+	for (unsigned i = 0; i < res; ++i)
+		row[i] = get_brick_value(brick_row[i / 8], l0 + i % 8);
+}
+
+/// return the number of bytes held by the encoded samples
+size_t sample_grid::get_memory_usage() const
+{
+	return values.capacity()*sizeof(double) + bricks.capacity()*sizeof(brick) + samples.capacity() +
+		exact_values.capacity()*sizeof(double) + exact_masks.capacity()*sizeof(uint64_t);
+}
+
+/// encode the bricks of layer bk from the window of sampled slices
+void sample_grid::encode_layer(unsigned bk, const std::vector<double>& window)
+{
+	size_t slice_size = size_t(res)*res, nr_layer_bricks = size_t(nr_bricks)*nr_bricks, sample_size = get_sample_size();
+	auto sample_row = [&](unsigned j, unsigned k) { return &window[(k % window_size)*slice_size + size_t(j)*res]; };
+	auto sample_at = [&](unsigned i, unsigned j, unsigned k) { return sample_row(j, k)[i]; };
+	// samples beyond the grid pad the bricks at the upper border with the closest sample
+	auto gather_brick = [&](const unsigned lo[3], double* v) {
+		for (unsigned k = 0; k < 8; ++k)
+			for (unsigned j = 0; j < 8; ++j) {
+				const double* row = sample_row(std::min(res - 1, lo[1] + j), std::min(res - 1, lo[2] + k));
+				for (unsigned i = 0; i < 8; ++i)
+					v[(k * 8 + j) * 8 + i] = row[std::min(res - 1, lo[0] + i)];
+			}
+	};
+	// doubles are exact themselves, such that only the other encodings mark samples to be stored exactly
+	bool mark_exact = encoding != DOUBLE_SAMPLES;
+	std::vector<unsigned char> has_crossing(nr_layer_bricks);
+	std::vector<double> closest_values(nr_layer_bricks);
+	std::vector<unsigned> nr_exact(nr_layer_bricks, 0);
+	std::vector<uint64_t> masks(mark_exact ? 8 * nr_layer_bricks : 0, 0);
+	parallel_for(nr_layer_bricks, [&](size_t b) {
+		unsigned lo[3] = { 8 * unsigned(b % nr_bricks), 8 * unsigned(b / nr_bricks), 8 * bk }, hi[3], ext_lo[3], ext_hi[3];
+		for (unsigned c = 0; c < 3; ++c) {
+			hi[c] = std::min(res, lo[c] + 8);
+			ext_lo[c] = lo[c] > 0 ? lo[c] - 1 : 0;
+			ext_hi[c] = std::min(res, hi[c] + 1);
+		}
+		// the neighborhoods of all samples of the brick lie in the brick extended by one sample
+		unsigned first_level = get_level(sample_at(ext_lo[0], ext_lo[1], ext_lo[2]));
+		bool crossing = false;
+		double closest = std::numeric_limits<double>::infinity(), min_value = closest, max_value = -closest;
+		for (unsigned k = ext_lo[2]; k < ext_hi[2]; ++k)
+			for (unsigned j = ext_lo[1]; j < ext_hi[1]; ++j) {
+				const double* row = sample_row(j, k);
+				bool row_in_brick = k >= lo[2] && k < hi[2] && j >= lo[1] && j < hi[1];
+				for (unsigned i = ext_lo[0]; i < ext_hi[0]; ++i) {
+					if (!crossing && get_level(row[i]) != first_level)
+						crossing = true;
+					if (!row_in_brick || i < lo[0] || i >= hi[0])
+						continue;
+					if (!(std::abs(row[i]) >= std::abs(closest)))
+						closest = row[i];
+					min_value = std::min(min_value, row[i]);
+					max_value = std::max(max_value, row[i]);
+				}
+			}
+		has_crossing[b] = crossing;
+		closest_values[b] = closest;
+		if (!mark_exact || (sparse && !crossing))
+			return;
+		uint64_t* mask = &masks[8 * b];
+		for (unsigned k = lo[2]; crossing && k < hi[2]; ++k)
+			for (unsigned j = lo[1]; j < hi[1]; ++j)
+				for (unsigned i = lo[0]; i < hi[0]; ++i) {
+					unsigned level = get_level(sample_at(i, j, k));
+					bool near_crossing = false;
+					for (unsigned nk = std::max(k, 1u) - 1; !near_crossing && nk < std::min(res, k + 2); ++nk)
+						for (unsigned nj = std::max(j, 1u) - 1; !near_crossing && nj < std::min(res, j + 2); ++nj)
+							for (unsigned ni = std::max(i, 1u) - 1; !near_crossing && ni < std::min(res, i + 2); ++ni)
+								near_crossing = get_level(sample_at(ni, nj, nk)) != level;
+					if (!near_crossing)
+						continue;
+					unsigned l = ((k - lo[2]) * 8 + j - lo[1]) * 8 + i - lo[0];
+					mask[l / 64] |= uint64_t(1) << (l % 64);
+					++nr_exact[b];
+				}
+		// samples whose encoding falls on the other side of an isovalue are stored exactly as well, which
+		// is only possible if an isovalue lies within the encoding error of the values of the brick
+		double error = get_max_encoding_error(std::max(std::abs(min_value), std::abs(max_value)));
+		std::vector<double>::const_iterator level = std::lower_bound(levels.begin(), levels.end(), min_value - error);
+		if (level == levels.end() || *level > max_value + error)
+			return;
+		double v[brick_size], decoded[brick_size];
+		unsigned char code[brick_size*sizeof(double)];
+		gather_brick(lo, v);
+		encode(v, brick_size, code);
+		decode(code, brick_size, decoded);
+		for (unsigned l = 0; l < brick_size; ++l) {
+			uint64_t bit = uint64_t(1) << (l % 64);
+			if ((mask[l / 64] & bit) != 0 || lo[0] + l % 8 >= res || lo[1] + (l / 8) % 8 >= res || lo[2] + l / 64 >= res)
+				continue;
+			if (get_level(decoded[l]) != get_level(v[l])) {
+				mask[l / 64] |= bit;
+				++nr_exact[b];
+			}
+		}
+	}, nr_threads);
+
+	// allocate the samples of the layer in brick order
+	size_t first_brick = size_t(bk)*nr_layer_bricks;
+	size_t nr_blocks = samples.size() / (brick_size*sample_size), nr_exact_values = exact_values.size(), nr_masks = exact_masks.size() / 8;
+	for (size_t b = 0; b < nr_layer_bricks; ++b) {
+		brick& br = bricks[first_brick + b];
+		br.uniform_value = closest_values[b];
+		br.sample_block = sparse && !has_crossing[b] ? invalid_index : uint32_t(nr_blocks++);
+		br.first_exact = br.exact_mask = invalid_index;
+		if (nr_exact[b] > 0) {
+			br.first_exact = uint32_t(nr_exact_values);
+			br.exact_mask = uint32_t(nr_masks++);
+			nr_exact_values += nr_exact[b];
+		}
+	}
+	samples.resize(nr_blocks*brick_size*sample_size);
+	exact_values.resize(nr_exact_values);
+	exact_masks.resize(8 * nr_masks);
+
+	parallel_for(nr_layer_bricks, [&](size_t b) {
+		const brick& br = bricks[first_brick + b];
+		unsigned lo[3] = { 8 * unsigned(b % nr_bricks), 8 * unsigned(b / nr_bricks), 8 * bk };
+		if (br.sample_block != invalid_index) {
+			double v[brick_size];
+			gather_brick(lo, v);
+			encode(v, brick_size, &samples[size_t(br.sample_block)*brick_size*sample_size]);
+		}
+		if (br.first_exact != invalid_index) {
+			const uint64_t* mask = &masks[8 * b];
+			std::copy(mask, mask + 8, &exact_masks[8 * size_t(br.exact_mask)]);
+			double* dst = &exact_values[br.first_exact];
+			for (unsigned l = 0; l < brick_size; ++l)
+				if ((mask[l / 64] >> (l % 64)) & 1)
+					*dst++ = sample_at(lo[0] + l % 8, lo[1] + (l / 8) % 8, lo[2] + l / 64);
+		}
+	}, nr_threads);
+}
+
+/// take the samples of slices k0 to k1-1 that are bounds beyond the band again next to crossings
+void sample_grid::refine_slices(unsigned k0, unsigned k1, const std::vector<double*>& slice_ptrs, const node_sampler& sample_node)
+{
+	if (k0 >= k1)
+		return;
+	double lo = levels.front() - band_width, hi = levels.back() + band_width;
+	// the nodes are collected before they are sampled again, such that all threads see the levels of the bounds.
+	// A sample taken again keeps its level, which is why the order does not matter otherwise.
+	size_t nr_rows = size_t(k1 - k0)*res;
+	std::vector<std::vector<unsigned> > row_nodes(nr_rows);
+	parallel_for(nr_rows, [&](size_t r) {
+		unsigned j = unsigned(r % res), k = k0 + unsigned(r / res);
+		const double* row = slice_ptrs[k - k0 + 1] + size_t(j)*res;
+		for (unsigned i = 0; i < res; ++i) {
+			if (row[i] > lo && row[i] < hi)
+				continue;
+			unsigned level = get_level(row[i]);
+			bool near_crossing = false;
+			for (unsigned nk = std::max(k, 1u) - 1; !near_crossing && nk < std::min(res, k + 2); ++nk)
+				for (unsigned nj = std::max(j, 1u) - 1; !near_crossing && nj < std::min(res, j + 2); ++nj) {
+					const double* neighbor_row = slice_ptrs[nk + 1 - k0] + size_t(nj)*res;
+					for (unsigned ni = std::max(i, 1u) - 1; !near_crossing && ni < std::min(res, i + 2); ++ni)
+						near_crossing = get_level(neighbor_row[ni]) != level;
+				}
+			if (near_crossing)
+				row_nodes[r].push_back(i);
+		}
+	}, nr_threads);
+	std::atomic<size_t> nr_nodes(0);
+	parallel_for(nr_rows, [&](size_t r) {
+		unsigned j = unsigned(r % res), k = k0 + unsigned(r / res);
+		double* row = slice_ptrs[k - k0 + 1] + size_t(j)*res;
+		for (unsigned i : row_nodes[r])
+			row[i] = sample_node(i, j, k);
+		nr_nodes += row_nodes[r].size();
+	}, nr_threads);
+	nr_refined += nr_nodes;
+}
+
+/// sample a grid of res^3 nodes row by row and encode it
+void sample_grid::build(unsigned _res, const row_sampler& sample_row, const node_sampler& sample_node)
+{
+	clear();
+	res = _res;
+	peak_memory = 0;
+	nr_refined = 0;
+	levels = isovalues;
+	std::sort(levels.begin(), levels.end());
+	levels.erase(std::unique(levels.begin(), levels.end()), levels.end());
+	band_center = levels.empty() ? 0 : 0.5*(levels.front() + levels.back());
+	band_half_width = band_width + (levels.empty() ? 0 : 0.5*(levels.back() - levels.front()));
+	// without isovalues there is no band and the samples are not refined
+	band_limited = sample_node && !levels.empty();
+	if (res == 0)
+		return;
+	size_t slice_size = size_t(res)*res;
+	// pointers to the slices k0-1 to k1 of a window of sampled slices, which are null outside the grid
+	auto get_slice_ptrs = [&](unsigned k0, unsigned k1, double* base, unsigned nr_slices) {
+		std::vector<double*> slice_ptrs;
+		for (unsigned k = k0; k <= k1 + 1; ++k)
+			slice_ptrs.push_back(k > 0 && k <= res ? base + ((k - 1) % nr_slices)*slice_size : 0);
+		return slice_ptrs;
+	};
+	if (encoding == DOUBLE_SAMPLES && !sparse) {
+		values.resize(slice_size*res);
+		parallel_for(slice_size, [&](size_t r) {
+			sample_row(unsigned(r % res), unsigned(r / res), &values[r*res]);
+		}, nr_threads);
+		if (band_limited)
+			refine_slices(0, res, get_slice_ptrs(0, res, &values.front(), res), sample_node);
+		peak_memory = get_memory_usage();
+		return;
+	}
+	// the layers of bricks are encoded one after the other from a window of slices
+	nr_bricks = (res + 7) / 8;
+	bricks.resize(size_t(nr_bricks)*nr_bricks*nr_bricks);
+	if (!sparse)
+		samples.reserve(bricks.size()*brick_size*get_sample_size());
+	std::vector<double> window(window_size*slice_size);
+	unsigned nr_sampled_slices = 0;
+	for (unsigned bk = 0; bk < nr_bricks; ++bk) {
+		unsigned end = std::min(res, 8 * bk + 9);
+		parallel_for(size_t(end - nr_sampled_slices)*res, [&](size_t r) {
+			unsigned j = unsigned(r % res), k = nr_sampled_slices + unsigned(r / res);
+			sample_row(j, k, &window[(k % window_size)*slice_size + size_t(j)*res]);
+		}, nr_threads);
+		// the samples of a slice are refined once the slices on either side are sampled, which is before
+		// the layer is encoded for all of its slices. The slice after the layer only contributes levels.
+		if (band_limited) {
+			unsigned k0 = nr_sampled_slices == 0 ? 0 : nr_sampled_slices - 1, k1 = end == res ? res : end - 1;
+			refine_slices(k0, k1, get_slice_ptrs(k0, k1, &window.front(), window_size), sample_node);
+		}
+		nr_sampled_slices = end;
+		encode_layer(bk, window);
+		peak_memory = std::max(peak_memory, get_memory_usage() + window.capacity()*sizeof(double));
+	}
+	samples.shrink_to_fit();
+	exact_values.shrink_to_fit();
+	exact_masks.shrink_to_fit();
+}
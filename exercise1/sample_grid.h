@@ -0,0 +1,130 @@
+#pragma once
+
+#include <vector>
+#include <functional>
+#include <cstdint>
+
+/** regular grid of function samples with selectable storage. By default the samples are
+    stored densely as doubles. The other encodings store them as 32 or 16 bit floats or as
+    16 or 8 bit integers that quantize the narrow band of band_width around the isovalues
+    and clamp values beyond it. They all store the samples in bricks of 8x8x8, and keep the
+    exact double of each sample next to a crossing of an isovalue, i.e. of each corner of a
+    cell contoured at one of the isovalues, and of each sample whose encoding falls on the
+    other side of an isovalue, such that contouring the grid at any of the isovalues gives
+    the same result as with dense doubles. If sparse is set, bricks without a crossing
+    within one sample of their border are stored as a single value. The grid is sampled
+    slab by slab, such that only ten slices of doubles are held besides the encoded
+    samples. The row sampler can take samples farther than band_width from all isovalues as
+    bounds only, if a node sampler is given that evaluates single nodes exactly. Such a sample is
+    below the band and not below the exact value, or above the band and not above it, such that
+    it lies on the same side of every isovalue. The samples beyond the band next to a crossing
+    are then taken again with the node sampler. */
+class sample_grid
+{
+public:
+	/// encodings of the samples
+	enum sample_encoding { DOUBLE_SAMPLES, FLOAT32_SAMPLES, FLOAT16_SAMPLES, INT16_SAMPLES, INT8_SAMPLES };
+	/// encoding of the samples
+	sample_encoding encoding;
+	/// whether bricks far from crossings of the isovalues are stored as a single value
+	bool sparse;
+	/// half width of the band around the isovalues quantized by the integer encodings
+	double band_width;
+	/// isovalues at which the grid is contoured exactly, which are zero by default
+	std::vector<double> isovalues;
+	/// number of threads, where zero selects the hardware concurrency
+	unsigned nr_threads;
+	/// function that writes the res samples of row j of slice k to row
+	typedef std::function<void(unsigned j, unsigned k, double* row)> row_sampler;
+	/// function that returns the exact sample at node (i,j,k)
+	typedef std::function<double(unsigned i, unsigned j, unsigned k)> node_sampler;
+
+	/// construct an empty grid with dense double storage
+	sample_grid();
+	/// sample a grid of res^3 nodes row by row and encode it. If sample_node is given, the samples of
+	/// sample_row beyond the band may be bounds, which are taken exactly with sample_node next to crossings.
+	void build(unsigned _res, const row_sampler& sample_row, const node_sampler& sample_node = node_sampler());
+	/// remove all samples
+	void clear();
+	/// return the number of samples per axis
+	unsigned get_res() const { return res; }
+	/// return whether the grid holds samples
+	bool empty() const { return res == 0; }
+	/// return whether contouring the grid at isovalue gives the same result as with dense doubles
+	bool is_exact_for(double isovalue) const;
+	/// return the sample at a grid node
+	double get_value(unsigned i, unsigned j, unsigned k) const;
+	/// return the samples of slice k if they are stored densely as doubles and 0 otherwise
+	const double* get_dense_slice(unsigned k) const;
+	/// decode the res^2 samples of slice k into slice
+	void get_slice(unsigned k, double* slice) const;
+	/// decode the res samples of row j of slice k into row
+	void get_row(unsigned j, unsigned k, double* row) const;
+	/// return the number of bytes held by the encoded samples
+	size_t get_memory_usage() const;
+	/// return the largest number of bytes held while the last build sampled and encoded the grid
+	size_t get_peak_memory_usage() const { return peak_memory; }
+	/// return the number of samples the last build took again with the node sampler
+	size_t get_nr_refined_samples() const { return nr_refined; }
+
+protected:
+	/// per brick the location of its samples
+	struct brick
+	{
+		/// index of the block of 512 encoded samples or -1 for a uniform brick
+		uint32_t sample_block;
+		/// index of the first exactly stored sample or -1 if the brick has none
+		uint32_t first_exact;
+		/// index of the 512 bit mask of the exactly stored samples
+		uint32_t exact_mask;
+		/// value of all samples of a uniform brick
+		double uniform_value;
+	};
+	/// number of samples per axis
+	unsigned res;
+	/// number of bricks per axis
+	unsigned nr_bricks;
+	/// sorted isovalues of the last build
+	std::vector<double> levels;
+	/// center and half width of the value range quantized by the integer encodings
+	double band_center, band_half_width;
+	/// dense samples for DOUBLE_SAMPLES without sparsity
+	std::vector<double> values;
+	/// bricks in x-fastest order
+	std::vector<brick> bricks;
+	/// blocks of 512 encoded samples
+	std::vector<unsigned char> samples;
+	/// exactly stored samples next to crossings of the isovalues
+	std::vector<double> exact_values;
+	/// eight words per mask, where bit l is set if the sample with brick local index l is stored exactly
+	std::vector<uint64_t> exact_masks;
+	/// bytes held during the last build
+	size_t peak_memory;
+	/// whether samples beyond the band of the last build can be bounds
+	bool band_limited;
+	/// number of samples taken again with the node sampler during the last build
+	size_t nr_refined;
+
+	/// return the number of bytes per encoded sample
+	size_t get_sample_size() const;
+	/// return the number of isovalues of the last build that are less than or equal to v, such that
+	/// two samples lie on the same side of all isovalues if their levels are equal
+	unsigned get_level(double v) const;
+	/// return an upper bound of the encoding error of samples of at most the given magnitude, which
+	/// excludes samples clamped by the integer encodings as they stay beyond all isovalues
+	double get_max_encoding_error(double magnitude) const;
+	/// encode n samples
+	void encode(const double* v, size_t n, unsigned char* ptr) const;
+	/// decode n samples
+	void decode(const unsigned char* ptr, size_t n, double* v) const;
+	/// return the sample with brick local index l of a brick
+	double get_brick_value(const brick& b, unsigned l) const;
+	/// decode the 64 samples of a brick with local indices 64*w to 64*w+63, which form one slice of the brick
+	void decode_brick_slice(const brick& b, unsigned w, double* v) const;
+	/// take the samples of slices k0 to k1-1 that are bounds beyond the band again with sample_node if a
+	/// sample in their 3x3x3 neighborhood lies on another side of an isovalue, where slice k is at slice_ptrs[k-k0+1]
+	/// and slices k0-1 and k1 are null outside the grid
+	void refine_slices(unsigned k0, unsigned k1, const std::vector<double*>& slice_ptrs, const node_sampler& sample_node);
+	/// encode the bricks of layer bk from the window of sampled slices, where slice k is at window[(k % 10)*res*res]
+	void encode_layer(unsigned bk, const std::vector<double>& window);
+};
@@ -1,5 +1,13 @@
 #include "scene.h"
 #include "implicit_group.h"
+#include "mapped_file.h"
+#include "profiled_node.h"
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
 #include <cgv/signal/rebind.h>
 #include <cgv/base/group.h>
 #include <cgv/gui/gui_driver.h>
@@ -9,10 +17,15 @@
 #include <cgv/math/qem.h>
 #include <cgv/base/register.h>
 #include <cgv/utils/convert_string.h>
+#include <cgv/utils/file.h>
+#include <cgv/utils/scan.h>
+#include <cgv/utils/stopwatch.h>
+#include <cgv/gui/file_dialog.h>
+#include <cgv/render/view.h>
 
 using namespace cgv::media::font;
 
-#define NR_TEXT_STYLES 8
+#define NR_TEXT_STYLES 9
 
 static text_style* get_text_style_table() {
 	static text_style style_table[NR_TEXT_STYLES] = {
@@ -23,7 +36,8 @@ static text_style* get_text_style_table() {
 		{ 0x108020, find_font("Courier")->get_font_face(FFA_REGULAR), 12 },
 		{ 0xaf0000, find_font("Courier")->get_font_face(FFA_BOLD), 12 },
 		{ 0x777777, find_font("Courier")->get_font_face(FFA_REGULAR), 12 },
-		{ 0x007777, find_font("Courier")->get_font_face(FFA_REGULAR), 12 }
+		{ 0x007777, find_font("Courier")->get_font_face(FFA_REGULAR), 12 },
+		{ 0x000000, find_font("Courier")->get_font_face(FFA_BOLD), 12 }
 	};
 	return style_table;
 }
@@ -64,7 +78,30 @@ void register_scene_factory(abst_scene_factory* _scene_factory)
 
 void scene::register_factory(abst_scene_factory* _scene_factory)
 {
+	int fi = (int)factories.size();
 	factories.push_back(_scene_factory);
+	// insert all symbols into the trie such that parsing needs a single pass over the description
+	if (symbol_trie.empty())
+		symbol_trie.push_back(symbol_trie_node());
+	std::vector<cgv::utils::token> tokens;
+	cgv::utils::split_to_tokens(_scene_factory->names, tokens, ";,", false);
+	for (unsigned j = 0; j < tokens.size(); ++j) {
+		unsigned ni = 0;
+		for (const char* c = tokens[j].begin; c < tokens[j].end; ++c) {
+			std::map<char, unsigned>::iterator it = symbol_trie[ni].successors.find(*c);
+			if (it == symbol_trie[ni].successors.end()) {
+				unsigned nj = (unsigned)symbol_trie.size();
+				symbol_trie[ni].successors[*c] = nj;
+				symbol_trie.push_back(symbol_trie_node());
+				ni = nj;
+			}
+			else
+				ni = it->second;
+		}
+		// the first factory registered for a symbol keeps it
+		if (ni > 0 && symbol_trie[ni].factory_index == -1)
+			symbol_trie[ni].factory_index = fi;
+	}
 }
 
 std::string scene::get_property_declarations()
@@ -78,8 +115,12 @@ bool scene::set_void(const std::string& property, const std::string& value_type,
 {
 	if (property == "file_name") {
 		file_name = variant<std::string>::get(value_type, value_ptr);
-		if (editor)
+		if (cgv::utils::to_lower(cgv::utils::file::get_extension(file_name)) == "isb")
+			read_binary_description(file_name);
+		else if (editor)
 			editor->read(file_name);
+		else
+			load_description(file_name);
 		return true;
 	}
 	if (!editor)
@@ -128,6 +169,13 @@ void scene::on_close_editor()
 void scene::on_text_insertion(int text_pos, int nr_inserted)
 {
 	text_changed(editor->get_text(), editor->get_length());
+	if (description.size() + nr_inserted != (size_t)editor->get_length())
+		resync_description();
+	else {
+		description.insert(text_pos, editor->get_text() + text_pos, nr_inserted);
+		shift_spans(description_tree, text_pos, 0, nr_inserted);
+		reparse_range(text_pos, text_pos + nr_inserted);
+	}
 	update_style(text_pos, nr_inserted);
 }
 
@@ -135,9 +183,116 @@ void scene::on_text_insertion(int text_pos, int nr_inserted)
 void scene::on_text_deletion(int text_pos, int nr_deleted, const char* deleted_text)
 {
 	text_changed(editor->get_text(), editor->get_length());
+	if (description.size() != (size_t)editor->get_length() + nr_deleted)
+		resync_description();
+	else {
+		description.erase(text_pos, nr_deleted);
+		shift_spans(description_tree, text_pos, nr_deleted, 0);
+		reparse_range(text_pos, text_pos);
+	}
 	update_style(text_pos, 0);
 }
 
+/// shift a position behind an edit that replaced old_length characters at pos by new_length
+/// characters. Positions at pos only move for insertions if they mark the end of a range.
+static void shift_position(unsigned int& p, unsigned int pos, unsigned int old_length, unsigned int new_length, bool is_end)
+{
+	if (p < pos || (p == pos && !is_end))
+		return;
+	if (p < pos + old_length)
+		p = pos;
+	else
+		p = p - old_length + new_length;
+}
+
+void scene::shift_spans(std::vector<description_node>& nodes, unsigned int pos, unsigned int old_length, unsigned int new_length)
+{
+	for (unsigned int j=0; j<nodes.size(); ++j) {
+		description_node& dn = nodes[j];
+		if (dn.end < pos)
+			continue;
+		shift_position(dn.begin, pos, old_length, new_length, false);
+		shift_position(dn.symbol_end, pos, old_length, new_length, true);
+		shift_position(dn.end, pos, old_length, new_length, true);
+		if (dn.defs_begin > 0) {
+			shift_position(dn.defs_begin, pos, old_length, new_length, false);
+			shift_position(dn.defs_end, pos, old_length, new_length, true);
+		}
+		if (dn.children_begin > 0) {
+			shift_position(dn.children_begin, pos, old_length, new_length, false);
+			shift_position(dn.children_end, pos, old_length, new_length, true);
+			shift_spans(dn.children, pos, old_length, new_length);
+		}
+	}
+}
+
+void scene::resync_description()
+{
+	description = editor->get_text();
+	std::vector<description_node> tree;
+	unsigned int i=0;
+	parse_description_recursive(i, tree);
+	description_tree.swap(tree);
+}
+
+void scene::reparse_range(unsigned int lo, unsigned int hi)
+{
+	if (!reparse_in_nodes(description_tree, lo, hi))
+		resync_description();
+}
+
+bool scene::reparse_in_nodes(std::vector<description_node>& nodes, unsigned int lo, unsigned int hi)
+{
+	// find the last node starting before the edit, as nodes are sorted by their begin
+	unsigned int l = 0, r = (unsigned int)nodes.size();
+	while (l < r) {
+		unsigned int m = (l + r) / 2;
+		if (nodes[m].begin <= lo)
+			l = m + 1;
+		else
+			r = m;
+	}
+	if (l == 0)
+		return false;
+	description_node& dn = nodes[l-1];
+	// nodes whose symbol has been deleted collapse to an empty range
+	if (hi > dn.end || dn.begin == dn.symbol_end)
+		return false;
+	if (dn.defs_begin > 0 && dn.defs_begin <= lo && hi <= dn.defs_end && description[dn.defs_begin-1] == '[') {
+		// the block is still valid if its closing bracket is the first one after the opening bracket
+		if (description.find(']', dn.defs_begin) != dn.defs_end)
+			return false;
+		dn.defs = description.substr(dn.defs_begin, dn.defs_end - dn.defs_begin);
+		return true;
+	}
+	if (dn.children_begin > 0 && dn.children_begin <= lo && hi <= dn.children_end && description[dn.children_begin-1] == '(') {
+		if (reparse_in_nodes(dn.children, lo, hi))
+			return true;
+		// re-parse the child list, which needs to end at the old closing parenthesis
+		unsigned int i = dn.children_begin;
+		std::vector<description_node> children;
+		parse_description_recursive(i, children);
+		if (i != dn.children_end || i >= description.size() || description[i] != ')')
+			return false;
+		dn.children.swap(children);
+		return true;
+	}
+	return false;
+}
+
+void scene::collect_symbol_spans(const std::vector<description_node>& nodes, unsigned int lo, unsigned int hi, std::vector<std::pair<unsigned int, unsigned int> >& spans) const
+{
+	for (unsigned int j=0; j<nodes.size(); ++j) {
+		const description_node& dn = nodes[j];
+		if (dn.end <= lo)
+			continue;
+		if (dn.begin >= hi)
+			break;
+		spans.push_back(std::make_pair(dn.begin, dn.symbol_end));
+		collect_symbol_spans(dn.children, lo, hi, spans);
+	}
+}
+
 /// update the style starting from text_pos. The text is unchanged after text_pos + min_nr_checked. Return the number of changed style characters. The default implementation does nothing, such that style A is kept for all characters and returns 0
 void scene::update_style(int text_pos, int min_nr_checked)
 {
@@ -204,6 +359,13 @@ void scene::update_style(int text_pos, int min_nr_checked)
 				}
 			}
 		}
+		// highlight factory symbols known from the span index of the parse tree
+		std::vector<std::pair<unsigned int, unsigned int> > spans;
+		collect_symbol_spans(description_tree, text_pos, text_pos + n, spans);
+		for (unsigned int j=0; j<spans.size(); ++j)
+			for (int k = std::max((int)spans[j].first - text_pos, 0); k < std::min((int)spans[j].second - text_pos, n); ++k)
+				if (style[k] == 'A')
+					style[k] = 'I';
 		char c = editor->get_style()[text_pos+n];
 		not_finished = n < length && ( (c == 'H') != in_string );
 		editor->set_style(text_pos,n,style.c_str());
@@ -219,14 +381,26 @@ void scene::update_style(int text_pos, int min_nr_checked)
 
 scene::scene(const std::string& _description) 
 	: description(_description),
-	  impl_draw_ptr(new gl_implicit_surface_drawable())
+	  extraction_driver(0),
+	  headless_domain(implicit_type::pnt_type(-1.2, -1.2, -1.2), implicit_type::pnt_type(1.2, 1.2, 1.2))
 {
 	name = "scene";
 
 	disable_update = false;
 	help_shown = false;
-	register_object(impl_draw_ptr);
-	impl_draw_ptr->set_function(this);
+	preview_width = 640;
+	preview_height = 480;
+	DPV_valid = false;
+	scene_version = 0;
+	scene_update_pending = false;
+	description_update_pending = false;
+	nr_update_requests = 0;
+	nr_executed_updates = 0;
+	profile_evaluation = false;
+	single_precision = false;
+	animation_time = 0;
+	applying_animation = false;
+	only_animated_changes = false;
 	if (cgv::gui::get_gui_driver())
 		construct_editor();
 	else {
@@ -250,77 +424,141 @@ void scene::unregister()
 {
 	//if (func_base_ptr)
 //		unregister_object(func_base_ptr, "");
-	if (impl_draw_ptr)
-		unregister_object(impl_draw_ptr, "");
+	if (extraction_driver_base_ptr)
+		unregister_object(extraction_driver_base_ptr, "");
+}
+
+/// attach the object that extracts and shows the surface and register it
+void scene::set_extraction_driver(base_ptr driver)
+{
+	if (extraction_driver_base_ptr)
+		unregister_object(extraction_driver_base_ptr, "");
+	extraction_driver_base_ptr = driver;
+	extraction_driver = driver ? driver->get_interface<surface_extraction_driver>() : 0;
+	if (!extraction_driver)
+		return;
+	register_object(driver);
+	extraction_driver->set_extracted_function(this);
+	extraction_driver->set_extraction_handler(this);
+}
+
+/// request an extraction from the extraction driver if one is attached
+void scene::request_extraction()
+{
+	if (extraction_driver)
+		extraction_driver->request_rebuild();
+}
+
+/// return the box in which the surface is extracted
+const scene::implicit_type::box_type& scene::get_domain() const
+{
+	return extraction_driver ? extraction_driver->get_domain() : headless_domain;
 }
 
 void scene::parse_description()
 {
 	disable_update = true;
-	if (editor) {
-		description = editor->get_text();
+	// the parsed text supersedes node changes that have not been written to the description yet
+	scene_update_pending = false;
+	description_update_pending = false;
+	// counters only restart for a complete rebuild, such that new nodes do not duplicate names of kept ones
+	if (!func_base_ptr)
+		for (unsigned int j=0; j<factories.size(); ++j)
+			factories[j]->init_counter();
+
+	// the parse tree is kept up to date by the edit callbacks of the editor
+	if (!editor || description != editor->get_text()) {
+		if (editor)
+			description = editor->get_text();
+		std::vector<description_node> tree;
+		unsigned int i=0;
+		parse_description_recursive(i, tree);
+		description_tree.swap(tree);
 	}
 
-	for (unsigned int j=0; j<factories.size(); ++j)
-		factories[j]->init_counter();
+	// diff the parse tree against the tree the live nodes were built from
+	std::vector<base_ptr> new_subtrees;
+	bool structure_changed = false;
+	base_ptr new_func_base_ptr;
+	if (!description_tree.empty())
+		new_func_base_ptr = update_node(func_base_ptr, description_tree.back(), applied_description_tree.empty() ? 0 : &applied_description_tree.back(), new_subtrees, structure_changed);
+	applied_description_tree = description_tree;
 
-	if (func_base_ptr) {
-		remove_all_children();
-		func_base_ptr.clear();
+	bool root_changed = new_func_base_ptr != func_base_ptr;
+	if (root_changed) {
+		structure_changed = true;
+		if (func_base_ptr) {
+			remove_all_children();
+			func_base_ptr.clear();
+		}
+		func_base_ptr = new_func_base_ptr;
 	}
-	unsigned int i=0;
-	func_base_ptr = parse_description_recursive(i, 0);
-	post_recreate_gui();
+	// new nodes can reuse the addresses of the removed ones, and the kept copies of removed nodes are released
+	if (structure_changed) {
+		changed_values_cache.clear();
+		clear_snapshot_copies();
+	}
+	if (func_base_ptr)
+		func_base_ptr->get_interface<implicit_type>()->prepare_evaluation();
+	if (structure_changed)
+		post_recreate_gui();
 	post_redraw();
 	if (func_base_ptr) {
-		append_child(func_base_ptr);
-		get_context()->make_current();
-		get_context()->configure_new_child(func_base_ptr);
-		impl_draw_ptr->set_function(this);
+		if (root_changed)
+			append_child(func_base_ptr);
+		// without a context, as in headless use, the nodes need no gl configuration
+		if (!new_subtrees.empty() && get_context()) {
+			get_context()->make_current();
+			for (unsigned int j=0; j<new_subtrees.size(); ++j)
+				get_context()->configure_new_child(new_subtrees[j]);
+		}
+		if (extraction_driver)
+			extraction_driver->set_extracted_function(this);
 	}
+	publish_snapshot();
 	disable_update = false;
 }
 
-bool scene::symbol_matches_description(unsigned int i, abst_scene_factory* factory, unsigned int& offset) const
+int scene::match_symbol(unsigned int i, unsigned int& offset) const
 {
-	if (factory->names.size() == 1) {
-		if (description[i] == factory->names[0]) {
-			offset = 1;
-			return true;
+	int fi = -1;
+	if (symbol_trie.empty())
+		return fi;
+	unsigned ni = 0;
+	for (unsigned int j = i; j < description.size(); ++j) {
+		std::map<char, unsigned>::const_iterator it = symbol_trie[ni].successors.find(description[j]);
+		if (it == symbol_trie[ni].successors.end())
+			break;
+		ni = it->second;
+		// prefer longer symbols such that "scale" does not match inside of "scale_uniform"
+		if (symbol_trie[ni].factory_index != -1) {
+			fi = symbol_trie[ni].factory_index;
+			offset = j + 1 - i;
 		}
-		return false;
 	}
-	std::vector<cgv::utils::token> tokens;
-	cgv::utils::split_to_tokens(factory->names, tokens, ";,", false);
-	for (unsigned j = 0; j < tokens.size(); ++j) {
-		std::string symbol = to_string(tokens[j]);
-		if (i + symbol.size() <= description.size())
-			if (description.substr(i, symbol.size()) == symbol) {
-				offset = (unsigned)symbol.size();
-				return true;
-			}
-	}
-	return false;
+	return fi;
 }
 
-base_ptr scene::parse_description_recursive(unsigned int& i, group* g)
+bool scene::symbol_matches_description(unsigned int i, abst_scene_factory* factory, unsigned int& offset) const
+{
+	int fi = match_symbol(i, offset);
+	return fi != -1 && factories[fi] == factory;
+}
+
+void scene::parse_description_recursive(unsigned int& i, std::vector<description_node>& nodes) const
 {
-	base_ptr bp;
-	std::string group_defs;
+	description_node dn;
+	bool has_node = false;
 	while (i < (unsigned int)description.size()) {
-		bool used_factory = false;
 		unsigned int offset = 0;
-		for (unsigned int j=0; j<factories.size(); ++j) {
-			if (symbol_matches_description(i, factories[j], offset)) {
-				bp = factories[j]->create_function();
-				bp->get_interface<implicit_type>()->set_update_handler(this);
-				used_factory = true;
-				break;
-			}
-		}
-		if (used_factory) {
+		int fi = match_symbol(i, offset);
+		if (fi != -1) {
+			dn = description_node();
+			dn.factory_index = fi;
+			dn.begin = i;
 			i += offset;
-			group_defs = "";
+			dn.symbol_end = dn.end = i;
+			has_node = true;
 			continue;
 		}
 		switch (description[i]) {
@@ -329,9 +567,12 @@ base_ptr scene::parse_description_recursive(unsigned int& i, group* g)
 				unsigned int t = i+1;
 				for (++i; i < description.size() && description[i] != ']'; ++i) {
 				}
-				std::string defs = description.substr(t,i-t);
-				group_defs = defs;
-				bp->multi_set(defs);
+				if (has_node) {
+					dn.defs = description.substr(t,i-t);
+					dn.defs_begin = t;
+					dn.defs_end = i;
+					dn.end = i+1;
+				}
 				break;
 			}
 		case '<' :
@@ -339,29 +580,31 @@ base_ptr scene::parse_description_recursive(unsigned int& i, group* g)
 				unsigned int t = i+1;
 				for (++i; i < description.size() && description[i] != '>'; ++i) {
 				}
-				std::string name = description.substr(t,i-t);
-				bp->get_named()->set_name(name);
+				if (has_node) {
+					dn.name = description.substr(t,i-t);
+					dn.end = i+1;
+				}
 				break;
 			}
 		case '(' :
-			if (bp) {
-				group* new_g = bp->get_interface<group>();
-				if (new_g) {
-					++i;
-					parse_description_recursive(i, new_g);
-					if (!group_defs.empty())
-						new_g->multi_set(group_defs);
-				}
+			if (has_node) {
+				++i;
+				dn.children.clear();
+				dn.children_begin = i;
+				parse_description_recursive(i, dn.children);
+				dn.children_end = i;
+				dn.end = i+1;
 			}
 			break;
 		case ',' :
-			if (bp && g)
-				g->append_child(bp);
+			if (has_node)
+				nodes.push_back(dn);
+			has_node = false;
 			break;
 		case ')' :
-			if (bp && g)
-				g->append_child(bp);
-			return bp;
+			if (has_node)
+				nodes.push_back(dn);
+			return;
 		case '%' : 
 				for (; i<description.size(); ++i) {
 					if (description[i] == '\n')
@@ -374,16 +617,115 @@ base_ptr scene::parse_description_recursive(unsigned int& i, group* g)
 		}
 		++i;
 	}
+	if (has_node)
+		nodes.push_back(dn);
+}
+
+base_ptr scene::create_node(const description_node& dn, std::vector<base_ptr>& new_subtrees, bool is_subtree_root)
+{
+	base_ptr bp = factories[dn.factory_index]->create_function();
+	bp->get_interface<implicit_type>()->set_update_handler(this);
+	bp->multi_set(dn.defs);
+	if (!dn.name.empty())
+		bp->get_named()->set_name(dn.name);
+	group* g = bp->get_interface<group>();
+	if (g) {
+		for (unsigned int j=0; j<dn.children.size(); ++j)
+			g->append_child(create_node(dn.children[j], new_subtrees, false));
+		if (!dn.defs.empty())
+			g->multi_set(dn.defs);
+	}
+	if (is_subtree_root)
+		new_subtrees.push_back(bp);
+	return bp;
+}
+
+/// extract the property names assigned in a property definition string
+static std::vector<std::string> get_assigned_names(const std::string& defs)
+{
+	std::vector<std::string> names;
+	std::vector<token> toks;
+	bite_all(tokenizer(defs).set_ws(";"), toks);
+	for (unsigned int i=0; i<toks.size(); ++i) {
+		std::string assignment = to_string(toks[i]);
+		names.push_back(assignment.substr(0, assignment.find('=')));
+	}
+	return names;
+}
+
+base_ptr scene::update_node(base_ptr bp, const description_node& dn, const description_node* old_dn, std::vector<base_ptr>& new_subtrees, bool& structure_changed)
+{
+	// nodes are only kept if they sit at the same position and are created by the same factory
+	if (!bp || !old_dn || old_dn->factory_index != dn.factory_index) {
+		structure_changed = true;
+		return create_node(dn, new_subtrees, true);
+	}
+
+	if (dn.defs != old_dn->defs) {
+		// properties whose assignment was removed from the description fall back to their defaults
+		std::vector<std::string> old_names = get_assigned_names(old_dn->defs);
+		std::vector<std::string> new_names = get_assigned_names(dn.defs);
+		const std::map<std::string, std::string>& defaults = get_default_values(factories[dn.factory_index]);
+		for (unsigned int j=0; j<old_names.size(); ++j) {
+			if (std::find(new_names.begin(), new_names.end(), old_names[j]) != new_names.end())
+				continue;
+			std::map<std::string, std::string>::const_iterator it = defaults.find(old_names[j]);
+			if (it != defaults.end())
+				bp->set_void(old_names[j], "string", &it->second);
+		}
+		bp->multi_set(dn.defs);
+	}
+	// a node whose name has been removed from the description gets a generated name like a new node
+	if (dn.name != old_dn->name) {
+		bp->get_named()->set_name(dn.name.empty() ? factories[dn.factory_index]->create_name() : dn.name);
+		node_changed(bp.operator->());
+	}
+
+	group* g = bp->get_interface<group>();
+	if (!g)
+		return bp;
+	std::vector<base_ptr> children;
+	bool children_changed = g->get_nr_children() != dn.children.size();
+	for (unsigned int j=0; j<dn.children.size(); ++j) {
+		base_ptr child;
+		if (j < g->get_nr_children() && j < old_dn->children.size())
+			child = update_node(g->get_child(j), dn.children[j], &old_dn->children[j], new_subtrees, structure_changed);
+		else
+			child = create_node(dn.children[j], new_subtrees, true);
+		if (j >= g->get_nr_children() || child != g->get_child(j))
+			children_changed = true;
+		children.push_back(child);
+	}
+	if (children_changed) {
+		// rebuild the child list of this group only, where unchanged children are reinserted
+		g->remove_all_children();
+		for (unsigned int j=0; j<children.size(); ++j)
+			g->append_child(children[j]);
+		if (!dn.defs.empty())
+			g->multi_set(dn.defs);
+		node_changed(bp.operator->());
+		structure_changed = true;
+	}
 	return bp;
 }
 
 void scene::reconstruct_description()
 {
 	unsigned int i=0;
-	std::string d = reconstruct_description_recursive(i, func_base_ptr->get_interface<implicit_type>(), 0);
+	replace_description(reconstruct_description_recursive(i, func_base_ptr->get_interface<implicit_type>(), 0));
+}
+
+void scene::replace_description(const std::string& d)
+{
 	if (editor)
 		editor->set_text(d);
 	description = d;
+	// the live nodes already match the new text, so only the parse tree is refreshed
+	std::vector<description_node> tree;
+	unsigned int i = 0;
+	parse_description_recursive(i, tree);
+	description_tree.swap(tree);
+	applied_description_tree = description_tree;
 }
 
 void scene::show_help()
@@ -406,13 +748,12 @@ void scene::show_help()
 }
 
 
-std::string scene::get_changed_values(implicit_type* fp, implicit_type* fp_ref) const
+const std::vector<std::pair<std::string, std::string> >& scene::get_parsed_declarations(const std::string& prop_decs) const
 {
-	base* bp = fp->get_base();
-	base* bp_ref = fp_ref->get_base();
-
-	std::string decs;
-	std::string prop_decs = bp->get_property_declarations();
+	std::map<std::string, std::vector<std::pair<std::string, std::string> > >::iterator it = declaration_cache.find(prop_decs);
+	if (it != declaration_cache.end())
+		return it->second;
+	std::vector<std::pair<std::string, std::string> >& decls = declaration_cache[prop_decs];
 	std::vector<token> toks;
 	bite_all(tokenizer(prop_decs).set_ws(";"), toks);
 	for (unsigned int i=0; i<toks.size(); ++i) {
@@ -423,18 +764,62 @@ std::string scene::get_changed_values(implicit_type* fp, implicit_type* fp_ref)
 						 << to_string(toks[i]).c_str() << "<" << std::endl;
 			continue;
 		}
+		decls.push_back(std::make_pair(to_string(toks1[0]), to_string(toks1[1])));
+	}
+	return decls;
+}
+
+const std::map<std::string, std::string>& scene::get_default_values(abst_scene_factory* factory) const
+{
+	std::map<abst_scene_factory*, std::map<std::string, std::string> >::iterator it = default_values_cache.find(factory);
+	if (it != default_values_cache.end())
+		return it->second;
+	std::map<std::string, std::string>& defaults = default_values_cache[factory];
+	if (!factory)
+		return defaults;
+	// the reference object only lives until its property values have been read back
+	base_ptr bp_ref = factory->create_function();
+	const std::vector<std::pair<std::string, std::string> >& decls = get_parsed_declarations(bp_ref->get_property_declarations());
+	for (unsigned int i=0; i<decls.size(); ++i) {
+		std::string v;
+		if (bp_ref->get_void(decls[i].first, "string", &v))
+			defaults[decls[i].first] = v;
+	}
+	return defaults;
+}
+
+void scene::node_changed(cgv::base::base* node_ptr)
+{
+	changed_values_cache.erase(node_ptr);
+	dirty_nodes.insert(node_ptr);
+}
+
+std::string scene::get_changed_values(implicit_type* fp, abst_scene_factory* factory) const
+{
+	base* bp = fp->get_base();
+	std::map<const base*, std::string>::iterator it = changed_values_cache.find(bp);
+	if (it != changed_values_cache.end())
+		return it->second;
+
+	const std::map<std::string, std::string>& defaults = get_default_values(factory);
+	std::string decs;
+	const std::vector<std::pair<std::string, std::string> >& decls = get_parsed_declarations(bp->get_property_declarations());
+	for (unsigned int i=0; i<decls.size(); ++i) {
+		const std::string& name = decls[i].first;
 		std::string v;
 		std::string v1;
-		if (!bp->get_void(to_string(toks1[0]), "string", &v)) {
-			std::cerr << "property " << to_string(toks1[0]).c_str() << " not found" << std::endl; 
+		if (!bp->get_void(name, "string", &v)) {
+			std::cerr << "property " << name.c_str() << " not found" << std::endl; 
 			continue;
 		}
-		if (bp_ref) {
-			if (!bp_ref->get_void(to_string(toks1[0]), "string", &v1)) {
-				v1 = "";
+		if (factory) {
+			std::map<std::string, std::string>::const_iterator jt = defaults.find(name);
+			if (jt != defaults.end())
+				v1 = jt->second;
+			else {
 				// hard coded special case of flags whether group children are visible in gui
 				int i;
-				if (to_string(toks1[0]).substr(0, 5) == "child" && cgv::utils::is_integer(to_string(toks1[0]).substr(5), i)) {
+				if (name.substr(0, 5) == "child" && cgv::utils::is_integer(name.substr(5), i)) {
 					v1 = "true";
 				}
 			}
@@ -442,8 +827,8 @@ std::string scene::get_changed_values(implicit_type* fp, implicit_type* fp_ref)
 		if (v1 != v) {
 			if (!decs.empty())
 				decs += ";";
-			decs += to_string(toks1[0])+"=";
-			if (toks1[1] == "string") {
+			decs += name+"=";
+			if (decls[i].second == "string") {
 				decs += '"';
 				decs += v;
 				decs += '"';
@@ -452,13 +837,13 @@ std::string scene::get_changed_values(implicit_type* fp, implicit_type* fp_ref)
 				decs += v;
 		}
 	}
+	changed_values_cache[bp] = decs;
 	return decs;
 }
 
 std::string scene::reconstruct_description_recursive(unsigned int& i, implicit_type* func_ptr, group* g)
 {
-	cgv::base::base_ptr bp_ref;
-//	implicit_type* func_ptr_ref = 0;
+	abst_scene_factory* factory_ref = 0;
 	std::string desc;
 	unsigned int i0 = i;
 	unsigned int ci = 0;
@@ -469,16 +854,10 @@ std::string scene::reconstruct_description_recursive(unsigned int& i, implicit_t
 			func_ptr = 0;
 	}
 	while (i < (unsigned int)description.size()) {
-		bool used_factory = false;
 		unsigned offset = 0;
-		for (unsigned int j=0; j<factories.size(); ++j) {
-			if (symbol_matches_description(i, factories[j], offset)) {
-				bp_ref = factories[j]->create_function();
-				used_factory = true;
-				break;
-			}
-		}
-		if (used_factory) {
+		int fi = match_symbol(i, offset);
+		if (fi != -1) {
+			factory_ref = factories[fi];
 			i += offset;
 			continue;
 		}
@@ -492,9 +871,9 @@ std::string scene::reconstruct_description_recursive(unsigned int& i, implicit_t
 				}
 				i0 = i;
 				if (g)
-					desc += get_changed_values(g->get_child(ci)->get_interface<implicit_type>(), bp_ref->get_interface<implicit_type>());
+					desc += get_changed_values(g->get_child(ci)->get_interface<implicit_type>(), factory_ref);
 				else
-					desc += get_changed_values(func_ptr, bp_ref->get_interface<implicit_type>());
+					desc += get_changed_values(func_ptr, factory_ref);
 				break;
 			}
 		case '<' :
@@ -521,7 +900,7 @@ std::string scene::reconstruct_description_recursive(unsigned int& i, implicit_t
 				func_ptr = g->get_child(ci)->get_interface<implicit_type>();
 			else
 				func_ptr = 0;
-			bp_ref = 0;
+			factory_ref = 0;
 			break;
 		case ')' :
 			return desc + description.substr(i0,i-i0);
@@ -541,9 +920,16 @@ void scene::update_scene()
 		help_shown = true;
 		show_help();
 	}
-	if (!disable_update) {
-		reconstruct_description();
-		impl_draw_ptr->post_rebuild();
+	if (!applying_animation)
+		only_animated_changes = false;
+	if (disable_update)
+		return;
+	++nr_update_requests;
+	update_member(&nr_update_requests);
+	// the work is done from the latest node state in the next frame
+	if (!scene_update_pending) {
+		scene_update_pending = true;
+		post_redraw();
 	}
 }
 
@@ -554,8 +940,971 @@ void scene::update_description()
 		help_shown = true;
 		show_help();
 	}
-	if (!disable_update)
-		reconstruct_description();
+	if (!applying_animation)
+		only_animated_changes = false;
+	if (disable_update)
+		return;
+	++nr_update_requests;
+	update_member(&nr_update_requests);
+	if (!description_update_pending) {
+		description_update_pending = true;
+		post_redraw();
+	}
+}
+
+/// merge all pending update requests into one update
+void scene::execute_pending_updates(bool request_rebuild)
+{
+	if (!scene_update_pending && !description_update_pending)
+		return;
+	bool function_changed = scene_update_pending;
+	scene_update_pending = false;
+	description_update_pending = false;
+	if (!func_base_ptr)
+		return;
+	reconstruct_description();
+	// only the changed nodes and their ancestors need new derived data
+	if (function_changed)
+		prepare_dirty_nodes(func_base_ptr->get_interface<implicit_type>(), get_dirty_paths());
+	// names and colors are part of the snapshot as well
+	publish_snapshot();
+	if (function_changed && request_rebuild)
+		request_extraction();
+	++nr_executed_updates;
+	update_member(&nr_executed_updates);
+}
+
+/// execute the update requests merged since the last frame
+void scene::init_frame(context& ctx)
+{
+	execute_pending_updates();
+}
+
+/// sphere trace the scene inside the extraction box and save color, depth and normal images
+bool scene::render_sphere_traced(const sphere_tracer::camera& cam, unsigned width, unsigned height, const std::string& file_name)
+{
+	if (!func_base_ptr)
+		return false;
+	double time;
+	cgv::utils::stopwatch sw(&time);
+	sphere_tracer::image img;
+	// trace a snapshot such that edits during rendering cannot be observed half way
+	execute_pending_updates();
+	evaluation_snapshot_ptr snapshot = acquire_snapshot();
+	if (!snapshot || !snapshot->function)
+		return false;
+	if (!tracer.render(*snapshot->function, get_domain(), cam, width, height, img,
+		[this, &snapshot]() { return is_stale(*snapshot); })) {
+		std::cout << "[SPHERE TRACING] aborted as the scene changed." << std::endl;
+		return false;
+	}
+	time = sw.get_elapsed_time();
+	std::cout << "[SPHERE TRACING] " << width << "x" << height << " image rendered in " << time << "s." << std::endl;
+	std::string base_name = cgv::utils::file::drop_extension(file_name);
+	return
+		img.write_color_ppm(file_name) &&
+		img.write_depth_pfm(base_name + "_depth.pfm") &&
+		img.write_normal_ppm(base_name + "_normal.ppm");
+}
+
+/// render a preview with the camera of the current view and save it to a file chosen by the user
+void scene::save_sphere_traced_preview()
+{
+	std::string fn = file_save_dialog("choose ppm output file", "Portable Pixmap (ppm):*.ppm|All Files:*.*");
+	if (fn.empty())
+		return;
+	sphere_tracer::camera cam;
+	cgv::render::view* view_ptr = find_view_as_node();
+	if (view_ptr) {
+		cam.eye = view_ptr->get_eye();
+		cam.focus = view_ptr->get_focus();
+		cam.view_up = view_ptr->get_view_up_dir();
+		cam.y_view_angle = view_ptr->get_y_view_angle();
+	}
+	if (!render_sphere_traced(cam, preview_width, preview_height, fn))
+		std::cerr << "could not write sphere traced preview to " << fn << std::endl;
+}
+
+/// intersect a ray with the implicit surface inside the extraction box
+bool scene::intersect_ray(const implicit_type::pnt_type& origin, const implicit_type::vec_type& dir, ray_hit& hit) const
+{
+	if (!func_base_ptr)
+		return false;
+	implicit_type* func_ptr = func_base_ptr->get_interface<implicit_type>();
+	const implicit_type::box_type& domain = get_domain();
+	sphere_tracer::hit_info hi;
+	if (!tracer.trace(*func_ptr, domain, func_ptr->lipschitz_bound(domain), origin, dir, hi))
+		return false;
+	hit.t = hi.t;
+	hit.p = hi.p;
+	hit.n = hi.n;
+	hit.leaf = func_ptr->find_determining_leaf(hi.p);
+	return true;
+}
+
+/// select the leaf hit by the ray and return whether a leaf was hit
+bool scene::pick(const implicit_type::pnt_type& origin, const implicit_type::vec_type& dir)
+{
+	ray_hit hit;
+	if (intersect_ray(origin, dir, hit)) {
+		selected_node = hit.leaf->get_base();
+		const named* n = selected_node->get_named();
+		pick_info = (n ? n->get_name() : selected_node->get_type_name()) + " at " + to_string(hit.p);
+	}
+	else {
+		selected_node.clear();
+		pick_info = "";
+	}
+	update_member(&pick_info);
+	return !selected_node.empty();
+}
+
+/// pick with ctrl + left mouse button
+bool scene::handle(event& e)
+{
+	if (e.get_kind() != EID_MOUSE || e.get_modifiers() != EM_CTRL || !DPV_valid)
+		return false;
+	mouse_event& me = static_cast<mouse_event&>(e);
+	if (me.get_action() != MA_PRESS || me.get_button() != MB_LEFT_BUTTON)
+		return false;
+	cgv::dvec3 p0 = cgv::render::context::get_model_point(me.get_x(), me.get_y(), 0.0, DPV);
+	cgv::dvec3 p1 = cgv::render::context::get_model_point(me.get_x(), me.get_y(), 1.0, DPV);
+	implicit_type::vec_type dir = p1 - p0;
+	dir.normalize();
+	pick(p0, dir);
+	return true;
+}
+
+/// describe the mouse interaction
+void scene::stream_help(std::ostream& os)
+{
+	os << "scene: ctrl+left click picks the primitive under the mouse" << std::endl;
+}
+
+/// store the matrix needed to unproject mouse locations
+void scene::draw(context& ctx)
+{
+	DPV = ctx.get_modelview_projection_window_matrix();
+	DPV_valid = true;
+}
+
+/// return the node wrapped by a profiled_node or the node itself
+template <typename S>
+static implicit_base<S>* skip_profiled_node(implicit_base<S>* cp)
+{
+	base* bp = cp->get_base();
+	if (bp->get_type_name() != "profiled_node")
+		return cp;
+	group* g = bp->get_interface<group>();
+	return g && g->get_nr_children() == 1 ? g->get_child(0)->template get_interface<implicit_base<S> >() : cp;
+}
+
+/// adapt a live node to the statistics of a double precision copy
+static bool adapt_to_copy(implicit_base<double>* fp, const implicit_base<double>& copy)
+{
+	return fp->adapt_to_statistics(copy);
+}
+
+/// adapt a live node to the statistics of a single precision copy
+static bool adapt_to_copy(implicit_base<double>* fp, const implicit_base<float>& copy)
+{
+	return fp->adapt_to_single_statistics(copy);
+}
+
+/// carry over the adapted evaluation strategies from the copies in the subtree of cp to the live nodes
+template <typename S>
+bool scene::adapt_live_nodes(implicit_type* fp, implicit_base<S>* cp)
+{
+	cp = skip_profiled_node(cp);
+	base* bp = fp->get_base();
+	bool adapted = adapt_to_copy(fp, *cp);
+	if (adapted)
+		dirty_nodes.insert(bp);
+	base* cbp = cp->get_base();
+	group* g = bp->get_interface<group>();
+	group* cg = cbp->get_interface<group>();
+	if (!g || !cg || g->get_nr_children() != cg->get_nr_children())
+		return adapted;
+	for (unsigned int j=0; j<g->get_nr_children(); ++j)
+		adapted = adapt_live_nodes(g->get_child(j)->get_interface<implicit_type>(),
+			cg->get_child(j)->template get_interface<implicit_base<S> >()) || adapted;
+	return adapted;
+}
+
+/// carry over the evaluation strategies adapted to the statistics of the last extraction to the live nodes
+void scene::after_surface_extraction()
+{
+	// the statistics have been gathered by the copies of the pinned snapshot, which other readers can
+	// evaluate concurrently and are therefore left unchanged. The adapted strategies are carried over to
+	// the live nodes, which only correspond to the pinned copies if no newer version has been published,
+	// and reach the evaluation through copies published with the same version, as the function is
+	// unchanged. If edits are pending, their publication carries them along.
+	bool adapted = false;
+	if (pinned_snapshot) {
+		if (func_base_ptr && pinned_snapshot->version == scene_version) {
+			implicit_type* fp = func_base_ptr->get_interface<implicit_type>();
+			if (pinned_snapshot->single_function)
+				adapted = adapt_live_nodes(fp, pinned_snapshot->single_function);
+			else if (pinned_snapshot->function)
+				adapted = adapt_live_nodes(fp, pinned_snapshot->function);
+		}
+		if (profile_evaluation)
+			report_profile();
+	}
+	else if (func_base_ptr) {
+		implicit_type* fp = func_base_ptr->get_interface<implicit_type>();
+		adapted = adapt_live_nodes(fp, fp);
+	}
+	if (adapted && !scene_update_pending && !description_update_pending)
+		publish_snapshot(false);
+	last_extracted_snapshot = pinned_snapshot;
+	animated_node_names.clear();
+	only_animated_changes = true;
+}
+
+/* Layout of binary scene files (.isb), all numbers in native byte order:
+   header:       char magic[4] = "ISB1", uint32 version, uint64 nr_nodes, uint64 data_offset
+   node records: in pre-order, each
+                 uint32 nr_children, symbol_length, name_length, defs_length, nr_arrays,
+                 followed by symbol, name and defs characters and nr_arrays array records of
+                 uint32 name_length, element_size, uint64 count, offset and the name characters
+   data section: starts at data_offset and holds the packed arrays at their offsets, each
+                 aligned to 16 bytes such that they can be copied from the mapping directly */
+static const char isb_magic[4] = { 'I', 'S', 'B', '1' };
+static const unsigned isb_version = 1;
+static const size_t isb_header_size = 24;
+
+template <typename V>
+static void append_binary(std::string& buffer, V value)
+{
+	buffer.append(reinterpret_cast<const char*>(&value), sizeof(V));
+}
+
+template <typename V>
+static bool read_binary(const char*& ptr, const char* end, V& value)
+{
+	if (end - ptr < (std::ptrdiff_t)sizeof(V))
+		return false;
+	memcpy(&value, ptr, sizeof(V));
+	ptr += sizeof(V);
+	return true;
+}
+
+static bool read_binary_string(const char*& ptr, const char* end, size_t length, std::string& value)
+{
+	if ((size_t)(end - ptr) < length)
+		return false;
+	value.assign(ptr, length);
+	ptr += length;
+	return true;
+}
+
+/// split a property definition string at semicolons outside of quoted strings
+static void split_assignments(const std::string& defs, std::vector<std::string>& assignments)
+{
+	bool in_string = false;
+	size_t start = 0;
+	for (size_t i = 0; i <= defs.size(); ++i) {
+		if (i < defs.size() && defs[i] == '"')
+			in_string = !in_string;
+		if (i == defs.size() || (defs[i] == ';' && !in_string)) {
+			if (i > start)
+				assignments.push_back(defs.substr(start, i - start));
+			start = i + 1;
+		}
+	}
+}
+
+/// check whether a property is reflected by one of the packed arrays
+static bool is_covered_by_packed_arrays(const std::string& property, const std::vector<packed_array>& arrays)
+{
+	for (unsigned int j=0; j<arrays.size(); ++j) {
+		if (property == arrays[j].count_property)
+			return true;
+		std::vector<token> prefixes;
+		cgv::utils::split_to_tokens(arrays[j].element_property_prefixes, prefixes, ";", false);
+		for (unsigned int k=0; k<prefixes.size(); ++k) {
+			size_t l = prefixes[k].get_length();
+			int idx;
+			if (property.size() > l && property.compare(0, l, prefixes[k].begin, l) == 0 && cgv::utils::is_integer(property.substr(l), idx))
+				return true;
+		}
+	}
+	return false;
+}
+
+int scene::get_factory_index(base* bp) const
+{
+	if (factory_index_by_type.empty()) {
+		for (unsigned int j=0; j<factories.size(); ++j) {
+			std::string type_name = factories[j]->create_function()->get_type_name();
+			// the first factory registered for a type is used for writing
+			if (factory_index_by_type.find(type_name) == factory_index_by_type.end())
+				factory_index_by_type[type_name] = (int)j;
+		}
+	}
+	std::map<std::string, int>::const_iterator it = factory_index_by_type.find(bp->get_type_name());
+	return it == factory_index_by_type.end() ? -1 : it->second;
+}
+
+/// return the first symbol of a factory
+static std::string get_factory_symbol(const abst_scene_factory* factory)
+{
+	return factory->names.substr(0, factory->names.find_first_of(";,"));
+}
+
+/// check whether the name of a node has been generated by its factory
+static bool is_generated_name(base* bp)
+{
+	const std::string& name = bp->get_named()->get_name();
+	std::string prefix = bp->get_type_name() + "_";
+	int idx;
+	return name.size() > prefix.size() && name.compare(0, prefix.size(), prefix) == 0 && cgv::utils::is_integer(name.substr(prefix.size()), idx);
+}
+
+std::string scene::generate_description_recursive(implicit_type* fp, unsigned int depth) const
+{
+	base* bp = fp->get_base();
+	int fi = get_factory_index(bp);
+	if (fi == -1)
+		return "";
+	std::string desc = get_factory_symbol(factories[fi]);
+	std::string defs = get_changed_values(fp, factories[fi]);
+	if (!defs.empty())
+		desc += "[" + defs + "]";
+	if (!is_generated_name(bp))
+		desc += "<" + bp->get_named()->get_name() + ">";
+	group* g = bp->get_interface<group>();
+	if (g && g->get_nr_children() > 0) {
+		desc += "(\n";
+		for (unsigned int j=0; j<g->get_nr_children(); ++j) {
+			desc += std::string(2*(depth+1), ' ');
+			desc += generate_description_recursive(g->get_child(j)->get_interface<implicit_type>(), depth+1);
+			desc += j+1 < g->get_nr_children() ? ",\n" : "\n";
+		}
+		desc += std::string(2*depth, ' ') + ")";
+	}
+	return desc;
+}
+
+std::string scene::generate_description() const
+{
+	if (!func_base_ptr)
+		return "";
+	return generate_description_recursive(func_base_ptr->get_interface<implicit_type>(), 0) + "\n";
+}
+
+bool scene::write_binary_description(const std::string& file_name) const
+{
+	if (!func_base_ptr)
+		return false;
+	std::string records;
+	std::vector<packed_array> data_arrays;
+	std::vector<size_t> data_offsets;
+	size_t data_size = 0;
+	size_t nr_nodes = 0;
+	// iterative pre-order traversal of the scene nodes
+	std::vector<base*> stack(1, func_base_ptr.operator->());
+	while (!stack.empty()) {
+		base* bp = stack.back();
+		stack.pop_back();
+		implicit_type* fp = bp->get_interface<implicit_type>();
+		int fi = get_factory_index(bp);
+		if (fi == -1) {
+			std::cerr << "no factory found for " << bp->get_type_name() << std::endl;
+			return false;
+		}
+		std::vector<packed_array> arrays;
+		fp->get_packed_arrays(arrays);
+		// properties reflected by the packed arrays are not stored as text
+		std::vector<std::string> assignments;
+		split_assignments(get_changed_values(fp, factories[fi]), assignments);
+		std::string defs;
+		for (unsigned int j=0; j<assignments.size(); ++j) {
+			if (is_covered_by_packed_arrays(assignments[j].substr(0, assignments[j].find('=')), arrays))
+				continue;
+			if (!defs.empty())
+				defs += ";";
+			defs += assignments[j];
+		}
+		std::string symbol = get_factory_symbol(factories[fi]);
+		std::string name = is_generated_name(bp) ? std::string() : bp->get_named()->get_name();
+		group* g = bp->get_interface<group>();
+		unsigned nr_children = g ? g->get_nr_children() : 0;
+		append_binary(records, nr_children);
+		append_binary(records, (unsigned)symbol.size());
+		append_binary(records, (unsigned)name.size());
+		append_binary(records, (unsigned)defs.size());
+		append_binary(records, (unsigned)arrays.size());
+		records += symbol;
+		records += name;
+		records += defs;
+		for (unsigned int j=0; j<arrays.size(); ++j) {
+			append_binary(records, (unsigned)arrays[j].name.size());
+			append_binary(records, (unsigned)arrays[j].element_size);
+			append_binary(records, (unsigned long long)arrays[j].count);
+			append_binary(records, (unsigned long long)data_size);
+			records += arrays[j].name;
+			data_arrays.push_back(arrays[j]);
+			data_offsets.push_back(data_size);
+			data_size += (arrays[j].element_size*arrays[j].count + 15) & ~size_t(15);
+		}
+		++nr_nodes;
+		for (unsigned int j=nr_children; j>0; --j)
+			stack.push_back(g->get_child(j-1).operator->());
+	}
+	std::string header;
+	header.append(isb_magic, 4);
+	append_binary(header, isb_version);
+	append_binary(header, (unsigned long long)nr_nodes);
+	size_t data_offset = (isb_header_size + records.size() + 15) & ~size_t(15);
+	append_binary(header, (unsigned long long)data_offset);
+
+	std::ofstream os(file_name.c_str(), std::ios::binary);
+	if (os.fail())
+		return false;
+	os.write(header.data(), header.size());
+	os.write(records.data(), records.size());
+	std::string padding(16, '\0');
+	os.write(padding.data(), data_offset - isb_header_size - records.size());
+	for (unsigned int j=0; j<data_arrays.size(); ++j) {
+		size_t nr_bytes = data_arrays[j].element_size*data_arrays[j].count;
+		if (nr_bytes > 0)
+			os.write(reinterpret_cast<const char*>(data_arrays[j].data), nr_bytes);
+		os.write(padding.data(), ((nr_bytes + 15) & ~size_t(15)) - nr_bytes);
+	}
+	return !os.fail();
+}
+
+base_ptr scene::read_binary_node(const char*& ptr, const char* end, const char* data, size_t data_size)
+{
+	unsigned nr_children, symbol_length, name_length, defs_length, nr_arrays;
+	std::string symbol, name, defs;
+	if (!read_binary(ptr, end, nr_children) || !read_binary(ptr, end, symbol_length) ||
+		!read_binary(ptr, end, name_length) || !read_binary(ptr, end, defs_length) ||
+		!read_binary(ptr, end, nr_arrays) || !read_binary_string(ptr, end, symbol_length, symbol) ||
+		!read_binary_string(ptr, end, name_length, name) || !read_binary_string(ptr, end, defs_length, defs))
+		return base_ptr();
+	unsigned int offset = 0;
+	int fi = -1;
+	for (unsigned int j=0; j<factories.size() && fi == -1; ++j)
+		if (get_factory_symbol(factories[j]) == symbol)
+			fi = (int)j;
+	if (fi == -1) {
+		std::cerr << "unknown symbol " << symbol << " in binary scene" << std::endl;
+		return base_ptr();
+	}
+	base_ptr bp = factories[fi]->create_function();
+	implicit_type* fp = bp->get_interface<implicit_type>();
+	fp->set_update_handler(this);
+	if (!defs.empty())
+		bp->multi_set(defs);
+	if (!name.empty())
+		bp->get_named()->set_name(name);
+	for (unsigned int j=0; j<nr_arrays; ++j) {
+		unsigned array_name_length, element_size;
+		unsigned long long count, array_offset;
+		std::string array_name;
+		if (!read_binary(ptr, end, array_name_length) || !read_binary(ptr, end, element_size) ||
+			!read_binary(ptr, end, count) || !read_binary(ptr, end, array_offset) ||
+			!read_binary_string(ptr, end, array_name_length, array_name))
+			return base_ptr();
+		// the count is compared by division, as count*element_size can overflow for corrupt files
+		if (element_size == 0 || array_offset > data_size || count > (data_size - array_offset) / element_size) {
+			std::cerr << "array " << array_name << " exceeds binary scene" << std::endl;
+			return base_ptr();
+		}
+		if (!fp->set_packed_array(array_name, data + array_offset, element_size, (size_t)count))
+			std::cerr << "could not set array " << array_name << " of " << symbol << std::endl;
+	}
+	group* g = bp->get_interface<group>();
+	for (unsigned int j=0; j<nr_children; ++j) {
+		base_ptr child = read_binary_node(ptr, end, data, data_size);
+		if (!child)
+			return base_ptr();
+		if (g)
+			g->append_child(child);
+	}
+	if (g && !defs.empty())
+		g->multi_set(defs);
+	return bp;
+}
+
+bool scene::read_binary_description(const std::string& file_name)
+{
+	mapped_file mf;
+	if (!mf.open(file_name)) {
+		std::cerr << "could not map " << file_name << std::endl;
+		return false;
+	}
+	const char* ptr = mf.get_data();
+	const char* end = ptr + mf.get_size();
+	unsigned version;
+	unsigned long long nr_nodes, data_offset;
+	if (mf.get_size() < isb_header_size || memcmp(ptr, isb_magic, 4) != 0) {
+		std::cerr << file_name << " is not a binary scene" << std::endl;
+		return false;
+	}
+	ptr += 4;
+	read_binary(ptr, end, version);
+	read_binary(ptr, end, nr_nodes);
+	read_binary(ptr, end, data_offset);
+	if (version != isb_version || data_offset > mf.get_size()) {
+		std::cerr << file_name << " has unsupported version or is truncated" << std::endl;
+		return false;
+	}
+	disable_update = true;
+	scene_update_pending = false;
+	description_update_pending = false;
+	for (unsigned int j=0; j<factories.size(); ++j)
+		factories[j]->init_counter();
+	base_ptr root = read_binary_node(ptr, mf.get_data() + data_offset, mf.get_data() + data_offset, mf.get_size() - data_offset);
+	if (!root) {
+		disable_update = false;
+		return false;
+	}
+	if (func_base_ptr) {
+		remove_all_children();
+		func_base_ptr.clear();
+	}
+	changed_values_cache.clear();
+	clear_snapshot_copies();
+	func_base_ptr = root;
+	func_base_ptr->get_interface<implicit_type>()->prepare_evaluation();
+	post_recreate_gui();
+	post_redraw();
+	append_child(func_base_ptr);
+	if (get_context()) {
+		get_context()->make_current();
+		get_context()->configure_new_child(func_base_ptr);
+	}
+	if (extraction_driver)
+		extraction_driver->set_extracted_function(this);
+	// the text description is generated from the nodes and not parsed
+	replace_description(generate_description());
+	publish_snapshot();
+	disable_update = false;
+	return true;
+}
+
+bool scene::load_description(const std::string& file_name)
+{
+	if (cgv::utils::to_lower(cgv::utils::file::get_extension(file_name)) == "isb")
+		return read_binary_description(file_name);
+	std::string text;
+	if (!cgv::utils::file::read(file_name, text, true))
+		return false;
+	if (editor)
+		editor->set_text(text);
+	description = text;
+	parse_description();
+	return true;
+}
+
+bool scene::convert_description(const std::string& input_file_name, const std::string& output_file_name)
+{
+	if (!load_description(input_file_name))
+		return false;
+	if (cgv::utils::to_lower(cgv::utils::file::get_extension(output_file_name)) == "isb")
+		return write_binary_description(output_file_name);
+	std::ofstream os(output_file_name.c_str());
+	os << generate_description();
+	return !os.fail();
+}
+
+void scene::save_binary_interactive()
+{
+	std::string fn = file_save_dialog("choose binary scene file", "Binary Scenes (isb):*.isb|All Files:*.*");
+	if (!fn.empty() && !write_binary_description(fn))
+		std::cerr << "could not write " << fn << std::endl;
+}
+
+void scene::load_binary_interactive()
+{
+	std::string fn = file_open_dialog("choose binary scene file", "Binary Scenes (isb):*.isb|All Files:*.*");
+	if (!fn.empty())
+		read_binary_description(fn);
+}
+
+/// create a node of the factory's type in double precision
+static base_ptr create_copy(abst_scene_factory* factory, implicit_base<double>*)
+{
+	return factory->create_function();
+}
+
+/// create a node of the factory's type in single precision
+static base_ptr create_copy(abst_scene_factory* factory, implicit_base<float>*)
+{
+	return factory->create_single_precision_function();
+}
+
+/// let a double precision copy share the evaluation data of its live node
+static void share_evaluation_data(implicit_base<double>* copy, const implicit_base<double>& source)
+{
+	copy->share_evaluation_data(source);
+}
+
+/// let a single precision copy share the evaluation data of its live node
+static void share_evaluation_data(implicit_base<float>* copy, const implicit_base<double>& source)
+{
+	copy->share_double_evaluation_data(source);
+}
+
+/// return the dirty nodes together with their ancestors
+std::set<const base*> scene::get_dirty_paths() const
+{
+	std::set<const base*> dirty_paths;
+	for (std::set<const base*>::const_iterator it = dirty_nodes.begin(); it != dirty_nodes.end(); ++it) {
+		// ancestors already inserted have been inserted with their own ancestors
+		const base* bp = *it;
+		while (dirty_paths.insert(bp).second) {
+			std::map<const base*, const base*>::const_iterator pit = live_parents.find(bp);
+			if (pit == live_parents.end())
+				break;
+			bp = pit->second;
+		}
+	}
+	return dirty_paths;
+}
+
+/// prepare the evaluation of the live nodes on dirty paths bottom up
+void scene::prepare_dirty_nodes(implicit_type* fp, const std::set<const base*>& dirty_paths)
+{
+	base* bp = fp->get_base();
+	if (dirty_paths.find(bp) == dirty_paths.end())
+		return;
+	group* g = bp->get_interface<group>();
+	if (g)
+		for (unsigned int j=0; j<g->get_nr_children(); ++j)
+			prepare_dirty_nodes(g->get_child(j)->get_interface<implicit_type>(), dirty_paths);
+	fp->prepare_node_evaluation();
+}
+
+/// drop all kept copies, such that the next snapshot copies all nodes
+void scene::clear_snapshot_copies()
+{
+	snapshot_copies.clear();
+	single_snapshot_copies.clear();
+	live_parents.clear();
+	dirty_nodes.clear();
+}
+
+/// copy a node with its subtree into nodes of precision T, where unchanged nodes are taken from copies
+template <typename T>
+base_ptr scene::clone_node(implicit_type* fp, node_copy_map* copies, const std::set<const base*>& dirty_paths, bool profile, int profile_parent)
+{
+	base* bp = fp->get_base();
+	if (copies && dirty_paths.find(bp) == dirty_paths.end()) {
+		node_copy_map::const_iterator it = copies->find(bp);
+		if (it != copies->end())
+			return it->second.copy;
+	}
+	int fi = get_factory_index(bp);
+	if (fi == -1)
+		return base_ptr();
+	base_ptr cp = create_copy(factories[fi], (implicit_base<T>*)0);
+	implicit_base<T>* cfp = cp->get_interface<implicit_base<T> >();
+	int profile_index = -1;
+	if (profile) {
+		profile_index = (int)profiler.register_node(bp->get_named()->get_name(), bp->get_type_name(), profile_parent);
+		profiled_live_nodes.push_back(bp);
+	}
+	// children are attached first, as groups reflect properties per child
+	group* g = bp->get_interface<group>();
+	group* cg = cp->get_interface<group>();
+	if (g && cg) {
+		for (unsigned int j=0; j<g->get_nr_children(); ++j) {
+			base_ptr child = clone_node<T>(g->get_child(j)->get_interface<implicit_type>(), copies, dirty_paths, profile, profile_index);
+			if (!child)
+				return base_ptr();
+			cg->append_child(child);
+			live_parents[g->get_child(j).operator->()] = bp;
+		}
+	}
+	// parameters are copied like in the binary format: packed arrays in bulk and the rest as text.
+	// Packed arrays hold double precision elements, such that single precision copies get all
+	// parameters as text.
+	std::vector<packed_array> arrays;
+	if (sizeof(T) == sizeof(double))
+		fp->get_packed_arrays(arrays);
+	std::vector<std::string> assignments;
+	split_assignments(get_changed_values(fp, factories[fi]), assignments);
+	std::string defs;
+	for (unsigned int j=0; j<assignments.size(); ++j) {
+		if (is_covered_by_packed_arrays(assignments[j].substr(0, assignments[j].find('=')), arrays))
+			continue;
+		if (!defs.empty())
+			defs += ";";
+		defs += assignments[j];
+	}
+	if (!defs.empty())
+		cp->multi_set(defs);
+	cp->get_named()->set_name(bp->get_named()->get_name());
+	for (unsigned int j=0; j<arrays.size(); ++j)
+		cfp->set_packed_array(arrays[j].name, arrays[j].data, arrays[j].element_size, arrays[j].count);
+	share_evaluation_data(cfp, *fp);
+	// the children are prepared already and can be shared with readers of earlier snapshots, such
+	// that only the copy itself is prepared
+	cfp->prepare_node_evaluation();
+	if (copies) {
+		node_copy& nc = (*copies)[bp];
+		nc.live = bp;
+		nc.copy = cp;
+	}
+	if (profile_index == -1)
+		return cp;
+	base_ptr wrapper(new profiled_node<T>(&profiler, (unsigned)profile_index));
+	wrapper->get_interface<group>()->append_child(cp);
+	return wrapper;
+}
+
+/// copy the changed live nodes into a new snapshot and publish it
+void scene::publish_snapshot(bool new_version)
+{
+	if (new_version && !applying_animation)
+		only_animated_changes = false;
+	std::shared_ptr<evaluation_snapshot> snapshot(new evaluation_snapshot());
+	snapshot->function = 0;
+	snapshot->single_function = 0;
+	if (profile_evaluation) {
+		profiler.clear();
+		profiled_live_nodes.clear();
+	}
+	// the double precision copy also serves the sphere tracer and is profiled only if it is the one
+	// that scene::evaluate uses. Profiled copies are made anew each time, such that all nodes are
+	// registered with the profiler.
+	bool profile_double = profile_evaluation && !single_precision;
+	if (profile_double || !func_base_ptr)
+		snapshot_copies.clear();
+	if (profile_evaluation || !single_precision || !func_base_ptr)
+		single_snapshot_copies.clear();
+	if (func_base_ptr) {
+		std::set<const base*> dirty_paths = get_dirty_paths();
+		implicit_type* fp = func_base_ptr->get_interface<implicit_type>();
+		snapshot->root = clone_node<double>(fp, profile_double ? 0 : &snapshot_copies, dirty_paths, profile_double);
+		if (snapshot->root)
+			snapshot->function = snapshot->root->get_interface<implicit_type>();
+		if (single_precision)
+			snapshot->single_root = clone_node<float>(fp, profile_evaluation ? 0 : &single_snapshot_copies, dirty_paths, profile_evaluation);
+		if (snapshot->single_root)
+			snapshot->single_function = snapshot->single_root->get_interface<implicit_base<float> >();
+	}
+	dirty_nodes.clear();
+	// the version is written before the pointer, such that readers of the new snapshot see a
+	// version that is at least its own
+	snapshot->version = new_version ? scene_version + 1 : scene_version.load();
+	scene_version = snapshot->version;
+	std::atomic_store(&published_snapshot, evaluation_snapshot_ptr(snapshot));
+}
+
+/// return the latest published snapshot
+scene::evaluation_snapshot_ptr scene::acquire_snapshot() const
+{
+	return std::atomic_load(&published_snapshot);
+}
+
+/// return the version of the latest published snapshot
+unsigned long long scene::get_scene_version() const
+{
+	return scene_version;
+}
+
+/// check whether a newer snapshot has been published since s
+bool scene::is_stale(const evaluation_snapshot& s) const
+{
+	return s.version != scene_version;
+}
+
+/// pin the latest snapshot for the evaluations of an extraction or volume export
+void scene::begin_evaluation()
+{
+	// the function is evaluated now, such that pending changes need no further extraction
+	execute_pending_updates(false);
+	pinned_snapshot = acquire_snapshot();
+	// if only animated parameters changed since the last extraction, its samples can be kept where the
+	// animated nodes cannot influence the function
+	extraction_difference.reset();
+	single_extraction_difference.reset();
+	if (!only_animated_changes || !last_extracted_snapshot || !pinned_snapshot)
+		return;
+	if (pinned_snapshot->single_function) {
+		if (last_extracted_snapshot->single_function)
+			single_extraction_difference.reset(new frame_difference<float>(
+				last_extracted_snapshot->single_function, pinned_snapshot->single_function, animated_node_names));
+	}
+	else if (pinned_snapshot->function && last_extracted_snapshot->function)
+		extraction_difference.reset(new frame_difference<double>(
+			last_extracted_snapshot->function, pinned_snapshot->function, animated_node_names));
+}
+
+/// release the pinned snapshot
+void scene::end_evaluation()
+{
+	extraction_difference.reset();
+	single_extraction_difference.reset();
+	pinned_snapshot.reset();
+}
+
+/// return whether the pinned snapshot can differ inside block from the snapshot of the last extraction
+bool scene::may_differ_from_last_extraction(const cgv::media::axis_aligned_box<double, 3>& block) const
+{
+	if (extraction_difference)
+		return extraction_difference->may_differ(block);
+	if (single_extraction_difference)
+		return single_extraction_difference->may_differ(block);
+	return true;
+}
+
+/// return the time range of the keyframes
+bool scene::get_animation_range(double& start, double& end) const
+{
+	return animation.get_time_range(start, end);
+}
+
+/// collect the nodes with the given name in the subtree of fp
+static void find_named_nodes(implicit_base<double>* fp, const std::string& name, std::vector<base*>& nodes)
+{
+	base* bp = fp->get_base();
+	const named* n = bp->get_named();
+	if (n && n->get_name() == name)
+		nodes.push_back(bp);
+	group* g = bp->get_interface<group>();
+	if (g)
+		for (unsigned int j=0; j<g->get_nr_children(); ++j)
+			find_named_nodes(g->get_child(j)->get_interface<implicit_base<double> >(), name, nodes);
+}
+
+/// apply the keyframed parameters at time t to the nodes and publish a snapshot of them
+void scene::set_animation_time(double t)
+{
+	animation_time = t;
+	update_member(&animation_time);
+	if (!func_base_ptr)
+		return;
+	// parameters are set through reflection like from the gui, such that the nodes report their changes,
+	// and only the nodes whose parameters actually change are recorded
+	applying_animation = true;
+	for (size_t ti = 0; ti < animation.get_nr_tracks(); ++ti) {
+		const scene_animation::track& track = animation.get_track(ti);
+		double value = track.evaluate(t);
+		std::vector<base*> nodes;
+		find_named_nodes(func_base_ptr->get_interface<implicit_type>(), track.node_name, nodes);
+		for (unsigned int ni=0; ni<nodes.size(); ++ni)
+			if (nodes[ni]->get<double>(track.property) != value) {
+				nodes[ni]->set<double>(track.property, value);
+				animated_node_names.insert(track.node_name);
+			}
+	}
+	execute_pending_updates(false);
+	applying_animation = false;
+}
+
+/// set a keyframe of key_property of the node named key_node_name to its current value at the current time
+void scene::set_key_interactive()
+{
+	std::vector<base*> nodes;
+	if (func_base_ptr)
+		find_named_nodes(func_base_ptr->get_interface<implicit_type>(), key_node_name, nodes);
+	if (nodes.empty()) {
+		std::cerr << "no node named " << key_node_name << std::endl;
+		return;
+	}
+	animation.set_key(key_node_name, key_property, animation_time, nodes.front()->get<double>(key_property));
+	post_recreate_gui();
+}
+
+/// ask for a file name and read keyframes from it
+void scene::load_keys_interactive()
+{
+	std::string fn = file_open_dialog("choose keyframe file", "Keyframes (isk):*.isk|All Files:*.*");
+	if (fn.empty())
+		return;
+	if (!animation.read(fn))
+		std::cerr << "could not read keyframes from " << fn << std::endl;
+	post_recreate_gui();
+}
+
+/// ask for a file name and write the keyframes to it
+void scene::save_keys_interactive()
+{
+	std::string fn = file_save_dialog("choose keyframe file", "Keyframes (isk):*.isk|All Files:*.*");
+	if (!fn.empty() && !animation.write(fn))
+		std::cerr << "could not write " << fn << std::endl;
+}
+
+/// remove all keyframes
+void scene::clear_keys()
+{
+	animation.clear();
+	post_recreate_gui();
+}
+
+/// format a time given in nanoseconds in milliseconds
+static std::string format_ms(unsigned long long t)
+{
+	std::ostringstream os;
+	os.setf(std::ios::fixed);
+	os.precision(2);
+	os << 1e-6 * t << "ms";
+	return os.str();
+}
+
+/// show the measurements of the last extraction next to the nodes and write them to json
+void scene::report_profile()
+{
+	std::vector<evaluation_profiler::node_profile> nodes = profiler.collect();
+	profiler.reset_counters();
+	if (nodes.size() != profiled_live_nodes.size())
+		return;
+	bool views_missing = false;
+	for (unsigned int i=0; i<nodes.size(); ++i) {
+		const evaluation_profiler::counters& c = nodes[i].totals;
+		implicit_type* fp = profiled_live_nodes[i]->get_interface<implicit_type>();
+		views_missing = views_missing || fp->ref_profile_info().empty();
+		fp->ref_profile_info() =
+			to_string(c.nr_evaluations) + "+" + to_string(c.nr_gradient_evaluations) + "g calls, " +
+			format_ms(c.inclusive_time) + " incl, " + format_ms(c.exclusive_time) + " excl";
+		// the view of a node is created by its parent group
+		if (nodes[i].parent == -1)
+			update_member(&fp->ref_profile_info());
+		else
+			profiled_live_nodes[nodes[i].parent]->get_interface<implicit_type>()->update_member(&fp->ref_profile_info());
+	}
+	if (views_missing)
+		post_recreate_gui();
+	if (!profile_json_file_name.empty()) {
+		std::ofstream os(profile_json_file_name.c_str());
+		if (os.fail())
+			std::cerr << "could not write profile to " << profile_json_file_name << std::endl;
+		else
+			evaluation_profiler::write_json(os, nodes);
+	}
+}
+
+/// remove the measurements from all live nodes
+void scene::clear_profile()
+{
+	for (unsigned int i=0; i<profiled_live_nodes.size(); ++i)
+		profiled_live_nodes[i]->get_interface<implicit_type>()->ref_profile_info().clear();
+	profiled_live_nodes.clear();
+	profiler.clear();
+}
+
+/// rebuild the snapshot when profiling or the precision is switched
+void scene::on_set(void* member_ptr)
+{
+	if (member_ptr == &profile_evaluation || member_ptr == &single_precision) {
+		if (!profile_evaluation || member_ptr == &single_precision)
+			clear_profile();
+		publish_snapshot();
+		request_extraction();
+		post_recreate_gui();
+	}
+	if (member_ptr == &animation_time) {
+		set_animation_time(animation_time);
+		request_extraction();
+	}
+	update_member(member_ptr);
 }
 
 /// overload to return the type name of this object
@@ -564,9 +1913,18 @@ std::string scene::get_type_name() const
 	return "scene"; 
 }
 
-/// cast evaluation to func_base_ptr
+/// cast evaluation to the pinned snapshot or func_base_ptr, where a single precision copy is
+/// evaluated at the point converted once
 double scene::evaluate(const pnt_type& p) const
 {
+	if (pinned_snapshot) {
+		if (pinned_snapshot->single_function)
+			return pinned_snapshot->single_function->evaluate(
+				implicit_base<float>::pnt_type(float(p.x()), float(p.y()), float(p.z())));
+		return pinned_snapshot->function ? pinned_snapshot->function->evaluate(
+			implicit_base<double>::pnt_type(p.x(), p.y(), p.z())
+		) : 0;
+	}
 	if (func_base_ptr)
 		return func_base_ptr->get_interface<implicit_type>()->evaluate(
 			implicit_base<double>::pnt_type(p.x(), p.y(), p.z())
@@ -574,9 +1932,44 @@ double scene::evaluate(const pnt_type& p) const
 	return 0;
 }
 
-/// cast gradient evaluation to func_base_ptr
+/// cast evaluation with the band [lo,hi] to the pinned snapshot or func_base_ptr
+double scene::evaluate_bounded(const pnt_type& p, double lo, double hi) const
+{
+	if (pinned_snapshot) {
+		if (pinned_snapshot->single_function) {
+			// the band is rounded outwards, such that single precision bounds lie beyond the band in double
+			float lo_f = float(lo), hi_f = float(hi);
+			if (lo_f > lo)
+				lo_f = std::nextafter(lo_f, -std::numeric_limits<float>::infinity());
+			if (hi_f < hi)
+				hi_f = std::nextafter(hi_f, std::numeric_limits<float>::infinity());
+			return pinned_snapshot->single_function->evaluate_bounded(
+				implicit_base<float>::pnt_type(float(p.x()), float(p.y()), float(p.z())), lo_f, hi_f);
+		}
+		return pinned_snapshot->function ? pinned_snapshot->function->evaluate_bounded(
+			implicit_base<double>::pnt_type(p.x(), p.y(), p.z()), lo, hi
+		) : 0;
+	}
+	if (func_base_ptr)
+		return func_base_ptr->get_interface<implicit_type>()->evaluate_bounded(
+			implicit_base<double>::pnt_type(p.x(), p.y(), p.z()), lo, hi
+		);
+	return 0;
+}
+
+/// cast gradient evaluation to the pinned snapshot or func_base_ptr
 scene::vec_type scene::evaluate_gradient(const pnt_type& p) const
 {
+	if (pinned_snapshot) {
+		if (pinned_snapshot->single_function) {
+			implicit_base<float>::vec_type g = pinned_snapshot->single_function->evaluate_gradient(
+				implicit_base<float>::pnt_type(float(p.x()), float(p.y()), float(p.z())));
+			return vec_type(g(0), g(1), g(2));
+		}
+		return pinned_snapshot->function ? pinned_snapshot->function->evaluate_gradient(
+			implicit_base<double>::pnt_type(p.x(), p.y(), p.z())
+		).to_vec() : vec_type(0, 0, 0);
+	}
 	if (func_base_ptr)
 	{
 		vec_type g = func_base_ptr->get_interface<implicit_type>()->evaluate_gradient(
@@ -591,6 +1984,58 @@ scene::vec_type scene::evaluate_gradient(const pnt_type& p) const
 void scene::create_gui()
 {
 	add_decorator("scene", "heading");
+	if (begin_tree_node("Sphere Tracing", tracer.max_nr_steps)) {
+		align("\a");
+		add_member_control(this, "width", preview_width, "value_slider", "min=16;max=4096;log=true;ticks=true");
+		add_member_control(this, "height", preview_height, "value_slider", "min=16;max=4096;log=true;ticks=true");
+		add_member_control(this, "max_nr_steps", tracer.max_nr_steps, "value_slider", "min=16;max=4096;log=true;ticks=true");
+		add_member_control(this, "epsilon", tracer.epsilon, "value_slider", "min=0.000001;max=0.01;log=true;ticks=true");
+		add_member_control(this, "nr_threads", tracer.nr_threads, "value_slider", "min=0;max=64;ticks=true");
+		connect_copy(add_button("save to ppm")->click, rebind(this, &scene::save_sphere_traced_preview));
+		end_tree_node(tracer.max_nr_steps);
+		align("\b");
+	}
+	if (begin_tree_node("Binary Scene", factories)) {
+		align("\a");
+		connect_copy(add_button("load isb")->click, rebind(this, &scene::load_binary_interactive));
+		connect_copy(add_button("save isb")->click, rebind(this, &scene::save_binary_interactive));
+		end_tree_node(factories);
+		align("\b");
+	}
+	if (begin_tree_node("Profiler", profile_evaluation)) {
+		align("\a");
+		add_member_control(this, "profile", profile_evaluation, "check");
+		add_member_control(this, "json_file", profile_json_file_name);
+		if (func_base_ptr && !func_base_ptr->get_interface<implicit_type>()->ref_profile_info().empty())
+			add_view("root", func_base_ptr->get_interface<implicit_type>()->ref_profile_info());
+		end_tree_node(profile_evaluation);
+		align("\b");
+	}
+	if (begin_tree_node("Animation", animation_time)) {
+		align("\a");
+		double start = 0, end = 1;
+		if (!animation.get_time_range(start, end) || end <= start)
+			end = start + 1;
+		add_member_control(this, "time", animation_time, "value_slider",
+			"min=" + to_string(start) + ";max=" + to_string(end) + ";ticks=true");
+		add_member_control(this, "node", key_node_name);
+		add_member_control(this, "property", key_property);
+		connect_copy(add_button("set key")->click, rebind(this, &scene::set_key_interactive));
+		connect_copy(add_button("load keys")->click, rebind(this, &scene::load_keys_interactive));
+		connect_copy(add_button("save keys")->click, rebind(this, &scene::save_keys_interactive));
+		connect_copy(add_button("clear keys")->click, rebind(this, &scene::clear_keys));
+		end_tree_node(animation_time);
+		align("\b");
+	}
+	add_member_control(this, "single precision", single_precision, "check");
+	if (begin_tree_node("Update Scheduling", nr_update_requests)) {
+		align("\a");
+		add_view("requested", nr_update_requests);
+		add_view("executed", nr_executed_updates);
+		end_tree_node(nr_update_requests);
+		align("\b");
+	}
+	add_view("picked", pick_info);
 	if (func_base_ptr)
 		inline_object_gui(func_base_ptr);
 }
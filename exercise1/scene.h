@@ -1,16 +1,28 @@
 #pragma once
 
+#include <map>
+#include <set>
+#include <memory>
+#include <atomic>
 #include "implicit_base.h"
 #include <cgv/gui/text_editor.h>
-#include "gl_implicit_surface_drawable.h"
+#include <cgv/gui/event_handler.h>
+#include "surface_extraction_handler.h"
+#include "sphere_tracer.h"
+#include "evaluation_profiler.h"
+#include "scene_animation.h"
+#include "frame_difference.h"
 
 ///
 class scene :
 	public group,
-	public gl_implicit_surface_drawable::F,
+	public cgv::math::v3_func<double, double>,
+	public bounded_function,
 	public scene_update_handler,
+	public surface_extraction_handler,
 	public drawable,
 	public provider,
+	public event_handler,
 	public text_editor_callback_handler
 {
 private:
@@ -21,10 +33,106 @@ protected:
 	void show_help();
 	/// store registered scene factories in a vector
 	std::vector<abst_scene_factory*> factories;
+	/// node of the parse tree of a scene description
+	struct description_node
+	{
+		/// index of the factory whose symbol starts the node
+		int factory_index;
+		/// property definitions in square brackets
+		std::string defs;
+		/// node name in angle brackets
+		std::string name;
+		/// parsed children in parentheses
+		std::vector<description_node> children;
+		/// character range [begin,end) of the node in the description
+		unsigned int begin, end;
+		/// end of the factory symbol that starts at begin
+		unsigned int symbol_end;
+		/// range [defs_begin,defs_end) inside the square brackets or zero if there are none
+		unsigned int defs_begin, defs_end;
+		/// range [children_begin,children_end) inside the parentheses or zero if there are none
+		unsigned int children_begin, children_end;
+		description_node() : factory_index(-1), begin(0), end(0), symbol_end(0), defs_begin(0), defs_end(0), children_begin(0), children_end(0) {}
+	};
+	/// top level nodes of the parse tree of the current description, which serves as span
+	/// index for incremental parsing and syntax highlighting
+	std::vector<description_node> description_tree;
+	/// parse tree from which the current scene nodes have been built
+	std::vector<description_node> applied_description_tree;
+	/// adapt all spans to an edit that replaced old_length characters at pos by new_length characters
+	void shift_spans(std::vector<description_node>& nodes, unsigned int pos, unsigned int old_length, unsigned int new_length);
+	/// re-parse the smallest property block or child list enclosing the edited range [lo,hi)
+	/// and splice the result into the parse tree, or re-parse everything if there is none
+	void reparse_range(unsigned int lo, unsigned int hi);
+	/// recursive part of reparse_range that returns false if the edit is not enclosed by a
+	/// block of one of the nodes such that the caller needs to re-parse its own block
+	bool reparse_in_nodes(std::vector<description_node>& nodes, unsigned int lo, unsigned int hi);
+	/// copy the text of the editor and parse it from scratch
+	void resync_description();
+	/// collect the character ranges of factory symbols of nodes overlapping [lo,hi)
+	void collect_symbol_spans(const std::vector<description_node>& nodes, unsigned int lo, unsigned int hi, std::vector<std::pair<unsigned int, unsigned int> >& spans) const;
+	/// create the scene node of a parse tree node including its children and append it to
+	/// new_subtrees if it is the root of a new subtree
+	base_ptr create_node(const description_node& dn, std::vector<base_ptr>& new_subtrees, bool is_subtree_root);
+	/// update the scene node bp built from old_dn to the parse tree node dn. Nodes of matching type
+	/// and position are kept and only receive changed properties. Returns bp or its replacement
+	/// and appends the roots of created subtrees to new_subtrees. structure_changed is set if nodes
+	/// have been inserted or removed.
+	base_ptr update_node(base_ptr bp, const description_node& dn, const description_node* old_dn, std::vector<base_ptr>& new_subtrees, bool& structure_changed);
+	/// node of the trie over the symbols of all registered factories
+	struct symbol_trie_node
+	{
+		/// successor nodes indexed by the next symbol character
+		std::map<char, unsigned> successors;
+		/// index of the factory whose symbol ends at this node or -1
+		int factory_index;
+		symbol_trie_node() : factory_index(-1) {}
+	};
+	/// property declarations split into name and type, keyed by the declaration string
+	mutable std::map<std::string, std::vector<std::pair<std::string, std::string> > > declaration_cache;
+	/// default property values of each factory read once from a reference object
+	mutable std::map<abst_scene_factory*, std::map<std::string, std::string> > default_values_cache;
+	/// serialized changed values per node that are kept until the node reports a change
+	mutable std::map<const base*, std::string> changed_values_cache;
+	/// parse a property declaration string or return the cached result
+	const std::vector<std::pair<std::string, std::string> >& get_parsed_declarations(const std::string& prop_decs) const;
+	/// return the default property values of objects created by factory
+	const std::map<std::string, std::string>& get_default_values(abst_scene_factory* factory) const;
+	/// factory index per type name of the created objects, filled on first use
+	mutable std::map<std::string, int> factory_index_by_type;
+	/// return the index of the factory that creates objects of the type of bp or -1
+	int get_factory_index(base* bp) const;
+	/// recursive part of read_binary_description that reads one node record with its subtree
+	base_ptr read_binary_node(const char*& ptr, const char* end, const char* data, size_t data_size);
+	/// set the text of description and editor to a text that matches the current nodes
+	void replace_description(const std::string& d);
+	/// ask for a file name and write the scene in binary form
+	void save_binary_interactive();
+	/// ask for a file name and read a binary scene
+	void load_binary_interactive();
+	/// trie with the root at index zero that is extended in register_factory
+	std::vector<symbol_trie_node> symbol_trie;
+	/// find the factory with the longest symbol starting at location i in the description. Returns
+	/// the factory index and sets offset to the symbol length or returns -1 if no symbol matches.
+	int match_symbol(unsigned int i, unsigned int& offset) const;
 	/// store the name of the current scene description file
 	std::string file_name;
 	/// store a pointer to the text editor
 	cgv::gui::text_editor_ptr editor;
+	/// cpu renderer used for previews without contouring
+	sphere_tracer tracer;
+	/// image size of sphere traced previews
+	unsigned preview_width, preview_height;
+	/// render a preview with the camera of the current view and save it to a file chosen by the user
+	void save_sphere_traced_preview();
+	/// modelview projection window matrix of the last frame used to unproject mouse locations
+	cgv::dmat4 DPV;
+	/// whether DPV has been set in a frame already
+	bool DPV_valid;
+	/// leaf node selected by the last pick
+	base_ptr selected_node;
+	/// description of the last pick shown in the gui
+	std::string pick_info;
 	// pass on property interface to text editor
 	std::string get_property_declarations();
 	bool set_void(const std::string& property, const std::string& value_type, const void* value_ptr);
@@ -48,26 +156,222 @@ protected:
 public:
 	/// type of implicits
 	typedef implicit_base<double> implicit_type;
-	/// pointer to implicit surface drawable
-	gl_implicit_surface_drawable_ptr impl_draw_ptr;
+	/// immutable copy of the scene nodes that is evaluated by readers while the gui edits the
+	/// live nodes. Readers hold it by shared pointer, such that it stays valid until the last
+	/// reader drops it, and compare its version to get_scene_version() to detect staleness.
+	/// Copies of nodes that did not change are shared with the previous snapshot, such that
+	/// a publication only copies the changed nodes and their ancestors.
+	struct evaluation_snapshot
+	{
+		/// root of the copied node tree
+		base_ptr root;
+		/// implicit interface of root or 0 for an empty scene
+		implicit_type* function;
+		/// root of a single precision copy of the node tree, which is only built in single precision mode
+		base_ptr single_root;
+		/// implicit interface of single_root or 0, in which case scene::evaluate uses function
+		implicit_base<float>* single_function;
+		/// scene version the copy has been made from
+		unsigned long long version;
+	};
+	/// pointer type under which snapshots are shared
+	typedef std::shared_ptr<const evaluation_snapshot> evaluation_snapshot_ptr;
+	/// return the latest published snapshot. This is lock free and can be called from any thread.
+	evaluation_snapshot_ptr acquire_snapshot() const;
+	/// return the version of the latest published snapshot
+	unsigned long long get_scene_version() const;
+	/// check whether a newer snapshot has been published since s, such that jobs working on s can abort
+	bool is_stale(const evaluation_snapshot& s) const;
+	/// pin the latest snapshot for the evaluations of an extraction or volume export
+	void begin_evaluation();
+	/// release the pinned snapshot
+	void end_evaluation();
+protected:
+	/// version of the live scene nodes that is incremented with each published snapshot
+	std::atomic<unsigned long long> scene_version;
+	/// latest published snapshot, which is only accessed through std::atomic_load and std::atomic_store
+	evaluation_snapshot_ptr published_snapshot;
+	/// snapshot evaluated by scene::evaluate between begin_evaluation and end_evaluation
+	evaluation_snapshot_ptr pinned_snapshot;
+	/// copy of a live node in the latest snapshot, which later snapshots share until the node changes
+	struct node_copy
+	{
+		/// live node, which is kept alive such that no new node can reuse its address
+		base_ptr live;
+		/// copy in the precision of the map that holds it
+		base_ptr copy;
+	};
+	/// map from live nodes to their copies in the latest snapshot
+	typedef std::map<const base*, node_copy> node_copy_map;
+	/// copies of the latest snapshot in double and single precision, which are not kept for profiled copies
+	node_copy_map snapshot_copies, single_snapshot_copies;
+	/// parent of each live node, recorded when the parent is copied
+	std::map<const base*, const base*> live_parents;
+	/// live nodes whose parameters, name, children or evaluation strategy changed since the last publication
+	std::set<const base*> dirty_nodes;
+	/// return the dirty nodes together with their ancestors
+	std::set<const base*> get_dirty_paths() const;
+	/// prepare the evaluation of the live nodes on dirty paths in the subtree of fp bottom up
+	void prepare_dirty_nodes(implicit_type* fp, const std::set<const base*>& dirty_paths);
+	/// drop all kept copies, such that the next snapshot copies all nodes
+	void clear_snapshot_copies();
+	/// copy a node with its subtree into nodes of precision T, where the copies have no update
+	/// handler. If copies is given, nodes that are not on dirty_paths are taken from it and new
+	/// copies are stored in it. If profile is set, each copy is registered with the profiler under
+	/// the given parent index and wrapped into a profiled_node.
+	template <typename T>
+	base_ptr clone_node(implicit_type* fp, node_copy_map* copies, const std::set<const base*>& dirty_paths, bool profile, int profile_parent = -1);
+	/// carry over the evaluation strategies that the copies in the subtree of cp adapted to their statistics
+	/// to the corresponding live nodes in the subtree of fp, mark these dirty and return whether there were any
+	template <typename S>
+	bool adapt_live_nodes(implicit_type* fp, implicit_base<S>* cp);
+	/// whether snapshots are built with profiled_node wrappers
+	bool profile_evaluation;
+	/// whether scene::evaluate uses a single precision copy of the nodes
+	bool single_precision;
+	/// file to which the measurements are written as json after each extraction, if not empty
+	std::string profile_json_file_name;
+	/// collects the measurements of the profiled_node wrappers
+	evaluation_profiler profiler;
+	/// live node per profiler index, which receives the measurements of its copy
+	std::vector<base_ptr> profiled_live_nodes;
+	/// show the measurements of the last extraction next to the nodes and write them to json
+	void report_profile();
+	/// remove the measurements from all live nodes
+	void clear_profile();
+	/// copy the changed live nodes into a new snapshot and publish it with the next version. If new_version
+	/// is false, only evaluation strategies changed and the snapshot keeps the current version.
+	void publish_snapshot(bool new_version = true);
+	/// whether an update_scene or update_description request is waiting for the next frame
+	bool scene_update_pending, description_update_pending;
+	/// number of update requests received from the nodes
+	unsigned nr_update_requests;
+	/// number of description reconstructions executed for them, at most one per frame
+	unsigned nr_executed_updates;
+	/// merge all pending update requests into one description reconstruction, snapshot
+	/// publication and, if the function changed and request_rebuild is set, one extraction
+	void execute_pending_updates(bool request_rebuild = true);
+	/// keyframed node parameters
+	scene_animation animation;
+	/// time at which the keyframed parameters have been applied to the nodes
+	double animation_time;
+	/// node name and property of the keyframes set in the gui
+	std::string key_node_name, key_property;
+	/// whether set_animation_time is setting node parameters
+	bool applying_animation;
+	/// names of the nodes whose parameters set_animation_time changed since the last extraction
+	std::set<std::string> animated_node_names;
+	/// whether all changes of the nodes since the last extraction have been made by set_animation_time
+	bool only_animated_changes;
+	/// snapshot evaluated by the last extraction
+	evaluation_snapshot_ptr last_extracted_snapshot;
+	/// bounds of the difference between the function of the last extraction and the pinned snapshot in the
+	/// precision used by scene::evaluate, which are built by begin_evaluation if the changes are only animated
+	std::unique_ptr<frame_difference<double> > extraction_difference;
+	std::unique_ptr<frame_difference<float> > single_extraction_difference;
+	/// set a keyframe of key_property of the node named key_node_name to its current value at the current time
+	void set_key_interactive();
+	/// ask for a file name and read keyframes from it
+	void load_keys_interactive();
+	/// ask for a file name and write the keyframes to it
+	void save_keys_interactive();
+	/// remove all keyframes
+	void clear_keys();
+public:
+	/// return the keyframed parameters, which are applied to the nodes by set_animation_time
+	scene_animation& ref_animation() { return animation; }
+	/// return the time range of the keyframes or false if there are none
+	bool get_animation_range(double& start, double& end) const;
+	/// apply the keyframed parameters at time t to the nodes and publish a snapshot of them without
+	/// requesting an extraction. Extractions that follow only sample the blocks of the scene again
+	/// in which the changed nodes can influence the function.
+	void set_animation_time(double t);
+	/// return whether the pinned snapshot can differ inside block from the snapshot of the last extraction
+	bool may_differ_from_last_extraction(const cgv::media::axis_aligned_box<double, 3>& block) const;
+	/// object that extracts and shows the surface of the scene, which is attached by the plugin and
+	/// missing in headless use
+	base_ptr extraction_driver_base_ptr;
+	/// interface of the extraction driver or null if none is attached
+	surface_extraction_driver* extraction_driver;
+	/// box in which the surface is extracted without extraction driver
+	implicit_type::box_type headless_domain;
+	/// attach the object that extracts and shows the surface, which must implement surface_extraction_driver,
+	/// and register it, where a previously attached driver is unregistered
+	void set_extraction_driver(base_ptr driver);
+	/// request an extraction from the extraction driver if one is attached
+	void request_extraction();
+	/// return the box in which the surface is extracted by the extraction driver or the headless domain without driver
+	const implicit_type::box_type& get_domain() const;
 	/// pointer to current function
 	base_ptr func_base_ptr;
 	/// current scene description
 	std::string description;
 
-	std::string get_changed_values(implicit_type* fp, implicit_type* fp_ref) const;
+	/// return the property assignments of fp that differ from the defaults of the given factory
+	std::string get_changed_values(implicit_type* fp, abst_scene_factory* factory) const;
 	void reconstruct_description();
 	std::string reconstruct_description_recursive(unsigned int& i, implicit_type* func_ptr, group* g);
 	/// check if factory's symbol[s] match location i in description
 	bool symbol_matches_description(unsigned int i, abst_scene_factory* factory, unsigned int& offset) const;
-	/// recursive part of the scene description parsing
-	base_ptr parse_description_recursive(unsigned int& i, group* g);
-	/// parse a scene description and construct a function pointer
+	/// recursive part of the scene description parsing that appends the nodes of a comma separated list
+	void parse_description_recursive(unsigned int& i, std::vector<description_node>& nodes) const;
+	/// generate a complete text description of the current scene nodes
+	std::string generate_description() const;
+	/// recursive part of generate_description
+	std::string generate_description_recursive(implicit_type* fp, unsigned int depth) const;
+	/// write the current scene nodes to a binary scene file (.isb), where knot points, edges
+	/// and other packed arrays are stored in binary form
+	bool write_binary_description(const std::string& file_name) const;
+	/// map a binary scene file, build the scene nodes directly from it and regenerate the text description
+	bool read_binary_description(const std::string& file_name);
+	/// read a text (.isd) or binary (.isb) scene file, where the format follows from the extension,
+	/// and update the scene nodes to it. This does not need a gui or a render context.
+	bool load_description(const std::string& file_name);
+	/// convert between .isd and .isb files, where the format follows from the extensions
+	bool convert_description(const std::string& input_file_name, const std::string& output_file_name);
+	/// parse a scene description and update the scene nodes to it
 	void parse_description();
-	/// callback for functions that update the scene based on gui interaction
+	/// sphere trace the scene inside the extraction box and save color, depth and normal images
+	/// to file_name, file_name without extension + "_depth.pfm" and + "_normal.ppm"
+	bool render_sphere_traced(const sphere_tracer::camera& cam, unsigned width, unsigned height, const std::string& file_name);
+	/// result of a ray query against the scene
+	struct ray_hit
+	{
+		/// ray parameter of the hit
+		double t;
+		/// hit location
+		implicit_type::pnt_type p;
+		/// normalized gradient at the hit location
+		implicit_type::vec_type n;
+		/// leaf node that determines the surface at the hit location
+		implicit_type* leaf;
+	};
+	/// intersect a ray with the implicit surface inside the extraction box by sphere tracing
+	/// the scene tree. This does not depend on an extracted mesh.
+	bool intersect_ray(const implicit_type::pnt_type& origin, const implicit_type::vec_type& dir, ray_hit& hit) const;
+	/// select the leaf hit by the ray and return whether a leaf was hit
+	bool pick(const implicit_type::pnt_type& origin, const implicit_type::vec_type& dir);
+	/// pick with ctrl + left mouse button
+	bool handle(event& e);
+	/// describe the mouse interaction
+	void stream_help(std::ostream& os);
+	/// execute the update requests merged since the last frame
+	void init_frame(context& ctx);
+	/// rebuild the snapshot when profiling or the precision is switched and apply the keyframes when the time changes
+	void on_set(void* member_ptr);
+	/// store the matrix needed to unproject mouse locations
+	void draw(context& ctx);
+	/// callback for functions that update the scene based on gui interaction. The update is
+	/// deferred to the next frame, such that an edit storm results in a single update.
 	void update_scene();
-	/// callback for functions that update the scene description without the implicit function
+	/// callback for functions that update the scene description without the implicit function,
+	/// which is deferred in the same way
 	void update_description();
+	/// drop the serialized values of a node whose properties changed
+	void node_changed(cgv::base::base* node_ptr);
+	/// carry over the evaluation strategies adapted to the statistics of the last extraction to the live
+	/// nodes and keep its snapshot for the comparison with the next one
+	void after_surface_extraction();
 	/// registration of scene factories;
 	void register_factory(abst_scene_factory* _scene_factory);
 	/// construct scene from a description string
@@ -78,11 +382,16 @@ public:
 	std::string get_type_name() const;
 	///
 	void create_gui();
-	/// cast evaluation to func_base_ptr
+	/// cast evaluation to the pinned snapshot or func_base_ptr
 	double evaluate(const pnt_type& p) const;
-	/// cast gradient evaluation to func_base_ptr
+	/// cast evaluation with the band [lo,hi] to the pinned snapshot or func_base_ptr
+	double evaluate_bounded(const pnt_type& p, double lo, double hi) const;
+	/// cast gradient evaluation to the pinned snapshot or func_base_ptr
 	vec_type evaluate_gradient(const pnt_type& p) const;
 };
 
 /// ref counted pointer to a scene
 typedef cgv::data::ref_ptr<scene> scene_ptr;
+
+/// return the scene with which all factories are registered
+extern scene_ptr ref_scene();
@@ -0,0 +1,103 @@
+#include "scene_animation.h"
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <limits>
+
+/// return the interpolated value at time t
+double scene_animation::track::evaluate(double t) const
+{
+	if (keyframes.empty())
+		return 0;
+	if (t <= keyframes.front().time)
+		return keyframes.front().value;
+	if (t >= keyframes.back().time)
+		return keyframes.back().value;
+	// first keyframe after t, which has a predecessor at or before t
+	size_t i = std::upper_bound(keyframes.begin(), keyframes.end(), t,
+		[](double time, const keyframe& k) { return time < k.time; }) - keyframes.begin();
+	const keyframe& k0 = keyframes[i - 1];
+	const keyframe& k1 = keyframes[i];
+	double lambda = (t - k0.time) / (k1.time - k0.time);
+	return (1 - lambda)*k0.value + lambda*k1.value;
+}
+
+/// insert a keyframe into the track of the property
+void scene_animation::set_key(const std::string& node_name, const std::string& property, double time, double value)
+{
+	size_t ti = 0;
+	while (ti < tracks.size() && (tracks[ti].node_name != node_name || tracks[ti].property != property))
+		++ti;
+	if (ti == tracks.size()) {
+		tracks.push_back(track());
+		tracks.back().node_name = node_name;
+		tracks.back().property = property;
+	}
+	std::vector<keyframe>& keyframes = tracks[ti].keyframes;
+	std::vector<keyframe>::iterator it = std::lower_bound(keyframes.begin(), keyframes.end(), time,
+		[](const keyframe& k, double time) { return k.time < time; });
+	if (it != keyframes.end() && it->time == time)
+		it->value = value;
+	else {
+		keyframe k = { time, value };
+		keyframes.insert(it, k);
+	}
+}
+
+/// remove all tracks
+void scene_animation::clear()
+{
+	tracks.clear();
+}
+
+/// return the time range of all keyframes
+bool scene_animation::get_time_range(double& start, double& end) const
+{
+	start = std::numeric_limits<double>::infinity();
+	end = -start;
+	for (size_t ti = 0; ti < tracks.size(); ++ti)
+		if (!tracks[ti].keyframes.empty()) {
+			start = std::min(start, tracks[ti].keyframes.front().time);
+			end = std::max(end, tracks[ti].keyframes.back().time);
+		}
+	return start <= end;
+}
+
+/// replace the tracks by the keyframes of a text file
+bool scene_animation::read(const std::string& file_name)
+{
+	std::ifstream is(file_name.c_str());
+	if (is.fail())
+		return false;
+	std::vector<track> old_tracks;
+	old_tracks.swap(tracks);
+	std::string line;
+	while (std::getline(is, line)) {
+		std::istringstream ls(line);
+		std::string node_name, property;
+		double time, value;
+		if (!(ls >> node_name) || node_name[0] == '#')
+			continue;
+		if (!(ls >> property >> time >> value)) {
+			tracks.swap(old_tracks);
+			return false;
+		}
+		set_key(node_name, property, time, value);
+	}
+	return true;
+}
+
+/// write all keyframes to a text file
+bool scene_animation::write(const std::string& file_name) const
+{
+	std::ofstream os(file_name.c_str());
+	if (os.fail())
+		return false;
+	os.precision(std::numeric_limits<double>::max_digits10);
+	os << "# node property time value" << std::endl;
+	for (size_t ti = 0; ti < tracks.size(); ++ti)
+		for (size_t ki = 0; ki < tracks[ti].keyframes.size(); ++ki)
+			os << tracks[ti].node_name << " " << tracks[ti].property << " "
+			   << tracks[ti].keyframes[ki].time << " " << tracks[ti].keyframes[ki].value << std::endl;
+	return !os.fail();
+}
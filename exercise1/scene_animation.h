@@ -0,0 +1,53 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+/** keyframed parameters of scene nodes. Each track animates one reflected numeric property,
+    such as dx of a translation, a of a rotation or r of a sphere, of all nodes with a given
+    name by linear interpolation between its keyframes, where the value is held constant
+    before the first and after the last keyframe. Tracks are stored in text files with one
+    keyframe per line of the form "node property time value", where lines starting with #
+    are comments. */
+class scene_animation
+{
+public:
+	/// value of a property at a point in time
+	struct keyframe
+	{
+		double time;
+		double value;
+	};
+	/// keyframes of one property of the nodes with a given name
+	struct track
+	{
+		/// name of the animated nodes
+		std::string node_name;
+		/// name of the animated property
+		std::string property;
+		/// keyframes sorted by time
+		std::vector<keyframe> keyframes;
+		/// return the interpolated value at time t
+		double evaluate(double t) const;
+	};
+protected:
+	/// tracks in the order of their creation
+	std::vector<track> tracks;
+public:
+	/// insert a keyframe into the track of the property, which replaces a keyframe at the same time
+	void set_key(const std::string& node_name, const std::string& property, double time, double value);
+	/// remove all tracks
+	void clear();
+	/// return whether there are no keyframes
+	bool empty() const { return tracks.empty(); }
+	/// return the number of tracks
+	size_t get_nr_tracks() const { return tracks.size(); }
+	/// return a track
+	const track& get_track(size_t ti) const { return tracks[ti]; }
+	/// return the time range of all keyframes or false if there are none
+	bool get_time_range(double& start, double& end) const;
+	/// replace the tracks by the keyframes of a text file
+	bool read(const std::string& file_name);
+	/// write all keyframes to a text file
+	bool write(const std::string& file_name) const;
+};
@@ -1,18 +1,52 @@
 #include "skeleton.h"
-#include <cgv_gl/gl/gl.h>
+#include <functional>
 
 
 // append an edge to the sketelon
 template <typename T>
 void skeleton<T>::append_edge(const edge_type& edge)
 {
-	edge_idx = (unsigned)edges.size();
+	append_edges(&edge, 1);
+}
 
-	edges.push_back(edge);
+/// set the maximum of the edge index control to the last edge
+template <typename T>
+void skeleton<T>::update_edge_index_control()
+{
 	if (provider::find_control(edge_idx))
-		provider::find_control(edge_idx)->set("max", edge_idx);
+		provider::find_control(edge_idx)->set("max", (int)edges.size() - 1);
+}
+
+template <typename T>
+void skeleton<T>::edges_appended_callback(size_t first)
+{
+	for (size_t ei = first; ei < edges.size(); ++ei)
+		append_edge_callback(ei);
+}
+
+/// replace all edges with callbacks and gui updates triggered once
+template <typename T>
+void skeleton<T>::set_edges(const edge_type* begin, size_t n)
+{
+	edges.assign(begin, begin + n);
+	edge_idx = 0;
+	update_edge_index_control();
+	edges_replaced_callback();
+	if (!edges.empty())
+		on_set(&edge_idx);
+}
 
-	append_edge_callback(edge_idx);
+/// append edges with callbacks and gui updates triggered once
+template <typename T>
+void skeleton<T>::append_edges(const edge_type* begin, size_t n)
+{
+	if (n == 0)
+		return;
+	size_t first = edges.size();
+	edges.insert(edges.end(), begin, begin + n);
+	edge_idx = unsigned(edges.size() - 1);
+	update_edge_index_control();
+	edges_appended_callback(first);
 	on_set(&edge_idx);
 }
 
@@ -38,10 +72,12 @@ bool skeleton<T>::self_reflect(cgv::reflect::reflection_handler& rh)
 
 	// ensure dynamic allocation of edges
 	if (rh.is_creative()) {
-		while (edges.size() < (size_t)m)
-			append_edge(edge_type(0, 1));
-		while (edges.size() > (size_t)m)
-			edges.pop_back();
+		if (edges.size() < (size_t)m) {
+			std::vector<edge_type> new_edges(m - edges.size(), edge_type(0, 1));
+			append_edges(&new_edges.front(), new_edges.size());
+		}
+		else if (edges.size() > (size_t)m)
+			edges.resize(m);
 	}
 
 	// check whether to termine self reflection
@@ -77,16 +113,18 @@ void skeleton<T>::on_set(void* member_ptr) {
 		edges[edge_idx].second = edge.second;
 		edge_changed_callback(edge_idx);
 	}
-	for (size_t i = 0; i < edges.size(); ++i) {
-		if (member_ptr == &edges[i].first) {
-			if (i == edge_idx) {
+	// locate reflected edge indices by their address instead of comparing against all edges
+	if (!edges.empty()) {
+		const char* mp = static_cast<const char*>(member_ptr);
+		const char* eb = reinterpret_cast<const char*>(&edges.front());
+		std::less<const char*> less;
+		if (!less(mp, eb) && less(mp, eb + edges.size()*sizeof(edge_type))) {
+			size_t i = size_t(mp - eb) / sizeof(edge_type);
+			if (member_ptr == &edges[i].first && i == edge_idx) {
 				edge.first = edges[i].first;
 				provider::update_member(&edge.first);
 			}
-			edge_changed_callback(i);
-		}
-		if (member_ptr == &edges[i].second) {
-			if (i == edge_idx) {
+			if (member_ptr == &edges[i].second && i == edge_idx) {
 				edge.second = edges[i].second;
 				provider::update_member(&edge.second);
 			}
@@ -102,32 +140,69 @@ void skeleton<T>::on_set(void* member_ptr) {
 	}
 	knot_vector<T>::on_set(member_ptr);
 }
+
+/// return the function with which skeletons draw their edges
+skeleton_edge_renderer& ref_skeleton_edge_renderer()
+{
+	static skeleton_edge_renderer renderer = 0;
+	return renderer;
+}
+
 /// its a drawable
 template <typename T>
 void skeleton<T>::draw(context& ctx)
 {
 	if (!show_edges)
 		return;
-	// Fixme: legacy OpenGL. Not good.
-	glLineWidth((float)edge_width);
-	glDisable(GL_LIGHTING);
-	glColor3d(0.25,0.25,0.25);
-	glBegin(GL_LINES);
-		for (size_t i=0; i<edges.size(); i++) {
-			if (((size_t)edges[i].first) >= (knot_vector<T>::points).size() ||
-			    ((size_t)edges[i].second) >= (knot_vector<T>::points).size())
-				continue;
-			glVertex3dv((knot_vector<T>::points)[edges[i].first]);
-			glVertex3dv((knot_vector<T>::points)[edges[i].second]);
-		}
-	glEnd();
-	glEnable(GL_LIGHTING);
-	glLineWidth(1);
+	if (!ref_skeleton_edge_renderer())
+		return;
+	std::vector<cgv::math::fvec<double, 3> > end_points;
+	end_points.reserve(2 * edges.size());
+	for (size_t i=0; i<edges.size(); i++) {
+		if (((size_t)edges[i].first) >= (knot_vector<T>::points).size() ||
+		    ((size_t)edges[i].second) >= (knot_vector<T>::points).size())
+			continue;
+		const pnt_type& p0 = (knot_vector<T>::points)[edges[i].first];
+		const pnt_type& p1 = (knot_vector<T>::points)[edges[i].second];
+		end_points.push_back(cgv::math::fvec<double, 3>(p0(0), p0(1), p0(2)));
+		end_points.push_back(cgv::math::fvec<double, 3>(p1(0), p1(1), p1(2)));
+	}
+	ref_skeleton_edge_renderer()(ctx, end_points, edge_width);
+}
+
+/// expose the edges as packed array "edges" in addition to the points
+template <typename T>
+void skeleton<T>::get_packed_arrays(std::vector<packed_array>& arrays) const
+{
+	knot_vector<T>::get_packed_arrays(arrays);
+	packed_array pa;
+	pa.name = "edges";
+	pa.data = edges.empty() ? 0 : &edges.front();
+	pa.element_size = sizeof(edge_type);
+	pa.count = edges.size();
+	pa.count_property = "m";
+	pa.element_property_prefixes = "i;j";
+	arrays.push_back(pa);
+}
+
+/// replace all edges with a single allocation
+template <typename T>
+bool skeleton<T>::set_packed_array(const std::string& name, const void* data, size_t element_size, size_t count)
+{
+	if (name != "edges")
+		return knot_vector<T>::set_packed_array(name, data, element_size, count);
+	if (element_size != sizeof(edge_type))
+		return false;
+	set_edges(reinterpret_cast<const edge_type*>(data), count);
+	implicit_base<T>::increase_version();
+	return true;
 }
 
 template <typename T>
-void skeleton<T>::append_callback(size_t pi)
+void skeleton<T>::points_appended_callback(size_t first)
 {
+	knot_vector<T>::points_appended_callback(first);
+	size_t pi = (knot_vector<T>::points).size() - 1;
 	if (provider::find_control(edge.first)) {
 		provider::find_control(edge.first)->set("max", pi);
 		provider::find_control(edge.second)->set("max", pi);
@@ -156,3 +231,4 @@ void skeleton<T>::create_gui()
 }
 
 template class skeleton<double>;
+template class skeleton<float>;
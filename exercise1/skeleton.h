@@ -2,6 +2,13 @@
 
 #include "knot_vector.h"
 
+/// function that draws line segments given by consecutive pairs of end points with the given width in the 3D view
+typedef void (*skeleton_edge_renderer)(cgv::render::context& ctx, const std::vector<cgv::math::fvec<double, 3> >& end_points, float width);
+
+/// return the function with which skeletons draw their edges, which the plugin sets to its GL implementation
+/// and which is null in headless builds, where edges are not drawn
+extern skeleton_edge_renderer& ref_skeleton_edge_renderer();
+
 template <typename T>
 class skeleton : public knot_vector<T>
 {
@@ -15,6 +22,8 @@ public:
 protected:
 	/// append an edge to the sketelon
 	void append_edge(const edge_type& edge);
+	/// set the maximum of the edge index control to the last edge
+	void update_edge_index_control();
 	/// list of all edges in the skeleton
 	std::vector<edge_type> edges;
 	/// index of edge that can currently be edited in user interface (selectable via slider control)
@@ -26,12 +35,17 @@ private:
 
 protected:
 	// virtual functions: can be overwritten by derived classes to process the data
-	/// triggers when an edge is appended. Called by append_edge
+	/// triggers when an edge is appended. Called by edges_appended_callback
 	virtual void append_edge_callback(size_t ei) {}
+	/// triggers once after the edges starting at index first have been appended. Called by
+	/// append_edges. The default implementation calls append_edge_callback for each new edge.
+	virtual void edges_appended_callback(size_t first);
 	/// triggers when an edge connectivity (i.e. one of its two indices) changed. Called by on_set
 	virtual void edge_changed_callback(size_t ei) {}
 	/// triggers when the edge selected in the gui for editing changed. Called by on_set
 	virtual void edge_index_selection_callback() {}
+	/// triggers when all edges have been replaced at once. Called by set_edges
+	virtual void edges_replaced_callback() {}
 	/// render the skeleton edges in the 3D view
 	bool show_edges;
 	/// line width for rendering the skeleton edges
@@ -42,14 +56,25 @@ public:
 	skeleton();
 	/// overload to return the type name of this object
 	std::string get_type_name() const { return "skeleton"; }
+	/// return the number of edges
+	size_t get_nr_edges() const { return edges.size(); }
+	/// replace all edges by the n edges starting at begin with a single allocation, where
+	/// callbacks, gui updates and the scene update are triggered once instead of per edge
+	void set_edges(const edge_type* begin, size_t n);
+	/// append the n edges starting at begin with callbacks and gui updates triggered once
+	void append_edges(const edge_type* begin, size_t n);
 	/// reflect members to expose them to serialization
 	bool self_reflect(cgv::reflect::reflection_handler& rh);
 	/// implementation of updates needed after members changed
 	void on_set(void* member_ptr);
+	/// expose the edges as packed array "edges" in addition to the points
+	void get_packed_arrays(std::vector<packed_array>& arrays) const;
+	/// replace all edges with a single allocation
+	bool set_packed_array(const std::string& name, const void* data, size_t element_size, size_t count);
 	/// its a drawable
 	void draw(cgv::render::context& ctx);
-	/// overload append point callback to configure gui of current edge
-	void append_callback(size_t pi);
+	/// overload to configure the gui of the current edge once for all appended points
+	void points_appended_callback(size_t first);
 	/// extend knot vector gui with support for appending and editing edges
 	void create_gui();
 };
@@ -0,0 +1,191 @@
+#include "sphere_tracer.h"
+#include "parallel.h"
+#include <cmath>
+#include <limits>
+#include <fstream>
+
+sphere_tracer::camera::camera() : eye(0, 0, 5), focus(0, 0, 0), view_up(0, 1, 0), y_view_angle(45)
+{
+}
+
+/// write colors to a binary ppm file
+bool sphere_tracer::image::write_color_ppm(const std::string& file_name) const
+{
+	std::ofstream os(file_name.c_str(), std::ios::binary);
+	if (os.fail())
+		return false;
+	os << "P6\n" << width << " " << height << "\n255\n";
+	os.write((const char*)colors.data(), colors.size());
+	return !os.fail();
+}
+
+/// write normals mapped from [-1,1] to [0,255] to a binary ppm file
+bool sphere_tracer::image::write_normal_ppm(const std::string& file_name) const
+{
+	std::ofstream os(file_name.c_str(), std::ios::binary);
+	if (os.fail())
+		return false;
+	os << "P6\n" << width << " " << height << "\n255\n";
+	std::vector<unsigned char> data(3 * normals.size());
+	for (size_t i = 0; i < normals.size(); ++i)
+		for (unsigned c = 0; c < 3; ++c)
+			data[3 * i + c] = (unsigned char)(int)(127.5f * (normals[i][c] + 1.0f));
+	os.write((const char*)data.data(), data.size());
+	return !os.fail();
+}
+
+/// write depths to a little endian pfm file
+bool sphere_tracer::image::write_depth_pfm(const std::string& file_name) const
+{
+	std::ofstream os(file_name.c_str(), std::ios::binary);
+	if (os.fail())
+		return false;
+	os << "Pf\n" << width << " " << height << "\n-1.0\n";
+	// pfm stores rows from bottom to top
+	for (unsigned y = height; y > 0; --y)
+		os.write((const char*)&depths[(y - 1) * width], width * sizeof(float));
+	return !os.fail();
+}
+
+/// construct with default parameters
+sphere_tracer::sphere_tracer() : background_color(1.0f, 1.0f, 1.0f, 1.0f)
+{
+	max_nr_steps = 256;
+	epsilon = 1e-4;
+	tile_size = 16;
+	nr_threads = 0;
+}
+
+/// trace a ray through the domain and return whether the surface was hit
+bool sphere_tracer::trace(const implicit_type& func, const box_type& domain, double L,
+	const pnt_type& origin, const vec_type& dir, hit_info& hit) const
+{
+	// clip ray against domain with the slab test
+	double t0 = 0, t1 = std::numeric_limits<double>::infinity();
+	for (unsigned i = 0; i < 3; ++i) {
+		double inv_d = 1.0 / dir(i);
+		double ta = (domain.get_min_pnt()(i) - origin(i)) * inv_d;
+		double tb = (domain.get_max_pnt()(i) - origin(i)) * inv_d;
+		if (ta > tb)
+			std::swap(ta, tb);
+		t0 = std::max(t0, ta);
+		t1 = std::min(t1, tb);
+	}
+	if (!(t0 <= t1))
+		return false;
+
+	// without a finite bound fall back to uniform steps and detect sign changes
+	bool has_bound = L > 0 && L < std::numeric_limits<double>::infinity();
+	double uniform_step = (t1 - t0) / max_nr_steps;
+
+	// values only need to be exact between the surface and the value at which a step leaves the domain,
+	// and bounded values beyond keep their sign and underestimate the distance, such that steps stay safe
+	auto step_band = [&](double t) { return has_bound ? std::max(epsilon, L * (t1 - t)) : epsilon; };
+	double t = t0;
+	double f = func.evaluate_bounded(origin + t*dir, 0, step_band(t));
+	unsigned nr_steps = 1;
+	// ray starts inside the surface where it enters the domain
+	bool found = f <= 0;
+	while (!found && nr_steps < max_nr_steps) {
+		if (f < epsilon) {
+			found = true;
+			break;
+		}
+		double step = has_bound ? f / L : uniform_step;
+		if (step < epsilon)
+			step = epsilon;
+		double t_prev = t;
+		t += step;
+		if (t > t1)
+			return false;
+		f = func.evaluate_bounded(origin + t*dir, 0, step_band(t));
+		++nr_steps;
+		if (f < 0) {
+			// step jumped over the surface, so locate it by bisection, which only needs the sign
+			double t_lo = t_prev, t_hi = t;
+			for (unsigned k = 0; k < 32 && t_hi - t_lo > epsilon; ++k) {
+				double t_mid = 0.5 * (t_lo + t_hi);
+				if (func.evaluate_bounded(origin + t_mid*dir, 0, 0) < 0)
+					t_hi = t_mid;
+				else
+					t_lo = t_mid;
+				++nr_steps;
+			}
+			t = t_hi;
+			found = true;
+		}
+	}
+	if (!found)
+		return false;
+	hit.t = t;
+	hit.p = origin + t*dir;
+	hit.n = func.evaluate_gradient(hit.p);
+	hit.n.normalize();
+	hit.nr_steps = nr_steps;
+	return true;
+}
+
+/// render func inside domain from the given camera into an image of the given size
+bool sphere_tracer::render(const implicit_type& func, const box_type& domain, const camera& cam,
+	unsigned width, unsigned height, image& img, const std::function<bool()>& is_stale) const
+{
+	img.width = width;
+	img.height = height;
+	img.colors.resize(3 * width * height);
+	img.depths.resize(width * height);
+	img.normals.resize(width * height);
+
+	// the bound is computed once per image as it requires a traversal of the scene tree
+	double L = func.lipschitz_bound(domain);
+
+	// construct orthonormal camera frame
+	vec_type z = cam.focus - cam.eye;
+	z.normalize();
+	vec_type x = cross(z, cam.view_up);
+	x.normalize();
+	vec_type y = cross(x, z);
+	double tan_half = tan(0.5 * cam.y_view_angle * 0.01745329252);
+	double aspect = double(width) / height;
+
+	unsigned nr_tiles_x = (width + tile_size - 1) / tile_size;
+	unsigned nr_tiles_y = (height + tile_size - 1) / tile_size;
+	std::atomic<bool> aborted(false);
+	parallel_for(nr_tiles_x * nr_tiles_y, [&](size_t tile) {
+		// remaining tiles are skipped once the function has been replaced by a newer version
+		if (aborted || (is_stale && is_stale())) {
+			aborted = true;
+			return;
+		}
+		unsigned x0 = unsigned(tile % nr_tiles_x) * tile_size;
+		unsigned y0 = unsigned(tile / nr_tiles_x) * tile_size;
+		unsigned x1 = std::min(x0 + tile_size, width);
+		unsigned y1 = std::min(y0 + tile_size, height);
+		for (unsigned py = y0; py < y1; ++py) {
+			for (unsigned px = x0; px < x1; ++px) {
+				double u = (2 * (px + 0.5) / width - 1) * tan_half * aspect;
+				double v = (1 - 2 * (py + 0.5) / height) * tan_half;
+				vec_type dir = z + u*x + v*y;
+				dir.normalize();
+				unsigned pi = py * width + px;
+				hit_info hit;
+				clr_type c = background_color;
+				if (trace(func, domain, L, cam.eye, dir, hit)) {
+					// head light with ambient term
+					float intensity = float(0.2 + 0.8 * std::abs(dot(hit.n, dir)));
+					c = func.evaluate_color(hit.p);
+					for (unsigned k = 0; k < 3; ++k)
+						c[k] *= intensity;
+					img.depths[pi] = float(hit.t);
+					img.normals[pi] = cgv::vec3(float(hit.n(0)), float(hit.n(1)), float(hit.n(2)));
+				}
+				else {
+					img.depths[pi] = std::numeric_limits<float>::infinity();
+					img.normals[pi] = cgv::vec3(0, 0, 0);
+				}
+				for (unsigned k = 0; k < 3; ++k)
+					img.colors[3 * pi + k] = (unsigned char)(int)(255 * std::min(std::max(c[k], 0.0f), 1.0f));
+			}
+		}
+	}, nr_threads);
+	return !aborted;
+}
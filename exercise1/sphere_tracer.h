@@ -0,0 +1,83 @@
+#pragma once
+
+#include "implicit_base.h"
+#include <functional>
+
+/** CPU renderer that sphere traces an implicit function inside an axis aligned domain.
+    The image is split into tiles that are rendered in parallel. Step sizes follow from
+    the Lipschitz bound of the function over the domain, such that the cost depends on
+    the number of steps per ray and not on a contouring resolution. */
+class sphere_tracer
+{
+public:
+	/// type of traced implicit functions
+	typedef implicit_base<double> implicit_type;
+	typedef implicit_type::pnt_type pnt_type;
+	typedef implicit_type::vec_type vec_type;
+	typedef implicit_type::box_type box_type;
+	typedef implicit_type::clr_type clr_type;
+
+	/// pinhole camera used to generate primary rays
+	struct camera
+	{
+		pnt_type eye;
+		pnt_type focus;
+		vec_type view_up;
+		/// vertical opening angle in degrees
+		double y_view_angle;
+		camera();
+	};
+	/// result of tracing a single ray
+	struct hit_info
+	{
+		/// ray parameter of the hit
+		double t;
+		/// hit location
+		pnt_type p;
+		/// normalized gradient at the hit location
+		vec_type n;
+		/// number of steps needed to find the hit
+		unsigned nr_steps;
+	};
+	/// rendered image with color, depth and normal per pixel
+	struct image
+	{
+		unsigned width;
+		unsigned height;
+		/// rgb colors in scanline order starting at the top row
+		std::vector<unsigned char> colors;
+		/// distance along the viewing ray, infinity for background pixels
+		std::vector<float> depths;
+		/// normalized surface normals, zero for background pixels
+		std::vector<cgv::vec3> normals;
+		/// write colors to a binary ppm file
+		bool write_color_ppm(const std::string& file_name) const;
+		/// write normals mapped from [-1,1] to [0,255] to a binary ppm file
+		bool write_normal_ppm(const std::string& file_name) const;
+		/// write depths to a little endian pfm file
+		bool write_depth_pfm(const std::string& file_name) const;
+	};
+
+	/// maximum number of steps along a ray
+	unsigned max_nr_steps;
+	/// function values with magnitude below epsilon count as hits
+	double epsilon;
+	/// edge length of the square image tiles handed to the worker threads
+	unsigned tile_size;
+	/// number of worker threads, where zero selects the hardware concurrency
+	unsigned nr_threads;
+	/// color of pixels whose rays miss the surface
+	clr_type background_color;
+
+	/// construct with default parameters
+	sphere_tracer();
+	/// trace a ray through the domain and return whether the surface was hit. The
+	/// lipschitz_bound of the function over the domain needs to be passed in L.
+	bool trace(const implicit_type& func, const box_type& domain, double L,
+		const pnt_type& origin, const vec_type& dir, hit_info& hit) const;
+	/// render func inside domain from the given camera into an image of the given size. If
+	/// is_stale is given, it is polled once per tile and the rendering is aborted as soon as it
+	/// returns true. Returns false if the rendering has been aborted.
+	bool render(const implicit_type& func, const box_type& domain, const camera& cam,
+		unsigned width, unsigned height, image& img, const std::function<bool()>& is_stale = std::function<bool()>()) const;
+};
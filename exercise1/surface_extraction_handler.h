@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cgv/math/mfunc.h>
+#include <cgv/media/axis_aligned_box.h>
+
+/// interface of functions that can be evaluated exactly only inside a band of values. The returned value v is
+/// exact inside [lo,hi], while a v <= lo only bounds the exact value from above and a v >= hi bounds it from below,
+/// such that it lies on the same side as the exact value of all values outside of the band.
+struct bounded_function
+{
+	/// evaluate the function at p with the band [lo,hi]
+	virtual double evaluate_bounded(const cgv::math::v3_func<double, double>::pnt_type& p, double lo, double hi) const = 0;
+};
+
+/// interface of objects that want to be notified after each surface extraction
+struct surface_extraction_handler
+{
+	virtual void after_surface_extraction() = 0;
+	/// called before the function is sampled by an extraction, range adjustment or volume export
+	virtual void begin_evaluation() {}
+	/// called after the function has been sampled
+	virtual void end_evaluation() {}
+	/// return whether the function evaluated between begin_evaluation and end_evaluation can differ inside
+	/// block from the function of the last extraction, where false guarantees equal values. This is called
+	/// from several threads. The default assumes a change everywhere.
+	virtual bool may_differ_from_last_extraction(const cgv::media::axis_aligned_box<double, 3>& block) const { return true; }
+	/// return the time range of the keyframed parameters of the function or false if it is not animated
+	virtual bool get_animation_range(double& start, double& end) const { return false; }
+	/// set the keyframed parameters of the function to their values at time t without requesting an extraction
+	virtual void set_animation_time(double t) {}
+};
+
+/// interface of the object that extracts and shows the surface of a function, through which the scene
+/// drives the extraction without depending on how the surface is drawn
+struct surface_extraction_driver
+{
+	/// set the function whose surface is extracted
+	virtual void set_extracted_function(cgv::math::v3_func<double, double>* f) = 0;
+	/// set the handler that is notified after each surface extraction
+	virtual void set_extraction_handler(surface_extraction_handler* eh) = 0;
+	/// request a surface extraction after the function changed
+	virtual void request_rebuild() = 0;
+	/// return the box in which the surface is extracted
+	virtual const cgv::media::axis_aligned_box<double, 3>& get_domain() const = 0;
+};
@@ -0,0 +1,1113 @@
+#include "surface_extractor.h"
+#include "mesh_decimator.h"
+#include "parallel.h"
+#include <cgv/math/qem.h>
+#include <cgv/utils/file.h>
+#include <cgv/utils/scan.h>
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <unordered_map>
+
+using namespace cgv::math;
+
+/// corners of the 12 cell edges ordered from the lower to the upper corner, where bit 0, 1 and 2
+/// of a corner index give its x, y and z offset
+static const unsigned char edge_corners[12][2] = {
+	{ 0,1 }, { 2,3 }, { 4,5 }, { 6,7 },
+	{ 0,2 }, { 1,3 }, { 4,6 }, { 5,7 },
+	{ 0,4 }, { 1,5 }, { 2,6 }, { 3,7 }
+};
+/// corners of the 6 cell faces in counter clockwise order seen from outside of the cell
+static const unsigned char face_corners[6][4] = {
+	{ 0,4,6,2 }, { 1,3,7,5 }, { 0,1,5,4 }, { 2,6,7,3 }, { 0,2,3,1 }, { 4,5,7,6 }
+};
+/// edge from corner q to corner q+1 of each face
+static const unsigned char face_edges[6][4] = {
+	{ 8,6,10,4 }, { 5,11,7,9 }, { 0,9,2,8 }, { 10,3,11,1 }, { 4,1,5,0 }, { 2,7,3,6 }
+};
+/// number of active cells processed by one task of the vertex placement
+static const size_t cell_block_size = 4096;
+/// singular values of the quadric below this fraction of the largest one are ignored
+static const double qem_singular_value_threshold = 0.1;
+/// number of vertices or faces formatted by one task when writing obj files
+static const size_t obj_chunk_size = 16384;
+/// number of vertices or faces staged in memory before they are written to binary files
+static const size_t binary_chunk_size = 65536;
+
+/// return the milliseconds passed since start
+static double elapsed_ms(const std::chrono::steady_clock::time_point& start)
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+/// construct with zero values
+extraction_statistics::extraction_statistics()
+	: sampling_ms(0), classification_ms(0), vertex_ms(0), decimation_ms(0), normal_ms(0), upload_ms(0), total_ms(0),
+	  nr_evaluations(0), nr_refined_samples(0), nr_reused_samples(0), nr_gradient_evaluations(0), nr_cells(0), nr_active_cells(0), nr_collapses(0), peak_memory(0), packed_bytes(0)
+{
+}
+
+/// write all values as a json object
+void extraction_statistics::write_json(std::ostream& os) const
+{
+	os << "{ \"sampling_ms\": " << sampling_ms
+	   << ", \"classification_ms\": " << classification_ms
+	   << ", \"vertex_ms\": " << vertex_ms
+	   << ", \"decimation_ms\": " << decimation_ms
+	   << ", \"normal_ms\": " << normal_ms
+	   << ", \"upload_ms\": " << upload_ms
+	   << ", \"total_ms\": " << total_ms
+	   << ", \"evaluations\": " << nr_evaluations
+	   << ", \"refined_samples\": " << nr_refined_samples
+	   << ", \"reused_samples\": " << nr_reused_samples
+	   << ", \"gradient_evaluations\": " << nr_gradient_evaluations
+	   << ", \"cells\": " << nr_cells
+	   << ", \"active_cells\": " << nr_active_cells
+	   << ", \"collapses\": " << nr_collapses
+	   << ", \"peak_memory\": " << peak_memory
+	   << ", \"packed_bytes\": " << packed_bytes << " }";
+}
+
+/// remove all faces
+void extracted_mesh::clear()
+{
+	positions.clear();
+	normals.clear();
+	corner_vertices.clear();
+	face_sizes.clear();
+}
+
+/// return the number of triangles after fan triangulation of all faces
+size_t extracted_mesh::get_nr_triangles() const
+{
+	size_t n = 0;
+	for (size_t fi = 0; fi < face_sizes.size(); ++fi)
+		n += face_sizes[fi] - 2;
+	return n;
+}
+
+/// append a number in the shortest representation that reads back to the same value
+template <typename T>
+static void append_number(std::string& s, T value)
+{
+	char buffer[32];
+	std::to_chars_result result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+	s.append(buffer, result.ptr);
+}
+
+/// append a vector as space separated numbers preceded by a keyword, where the components are
+/// rounded to the single precision that obj readers load
+static void append_vector(std::string& s, const char* keyword, const extracted_mesh::vec_type& v)
+{
+	s += keyword;
+	for (unsigned c = 0; c < 3; ++c) {
+		s += ' ';
+		append_number(s, float(v(c)));
+	}
+	s += '\n';
+}
+
+/// write the mesh to an obj file, where faces share vertices with their normals
+bool extracted_mesh::write_obj(std::ostream& os, unsigned nr_threads) const
+{
+	size_t nr_vertex_chunks = (positions.size() + obj_chunk_size - 1) / obj_chunk_size;
+	size_t nr_normal_chunks = (normals.size() + obj_chunk_size - 1) / obj_chunk_size;
+	size_t nr_face_chunks = (face_sizes.size() + obj_chunk_size - 1) / obj_chunk_size;
+	size_t nr_chunks = nr_vertex_chunks + nr_normal_chunks + nr_face_chunks;
+	// index of the first corner of each face chunk
+	std::vector<size_t> chunk_corners(nr_face_chunks);
+	for (size_t fi = 0, ci = 0; fi < face_sizes.size(); ci += face_sizes[fi++])
+		if (fi % obj_chunk_size == 0)
+			chunk_corners[fi / obj_chunk_size] = ci;
+
+	// format groups of chunks in parallel and write them in order, such that only one group is held in memory
+	size_t group_size = 4 * get_nr_worker_threads(nr_threads);
+	std::vector<std::string> texts(group_size);
+	for (size_t first = 0; first < nr_chunks; first += group_size) {
+		size_t n = std::min(group_size, nr_chunks - first);
+		parallel_for(n, [&](size_t i) {
+			std::string& s = texts[i];
+			s.clear();
+			size_t chunk = first + i;
+			if (chunk < nr_vertex_chunks) {
+				size_t end = std::min(positions.size(), (chunk + 1)*obj_chunk_size);
+				for (size_t vi = chunk*obj_chunk_size; vi < end; ++vi)
+					append_vector(s, "v", positions[vi]);
+				return;
+			}
+			chunk -= nr_vertex_chunks;
+			if (chunk < nr_normal_chunks) {
+				size_t end = std::min(normals.size(), (chunk + 1)*obj_chunk_size);
+				for (size_t vi = chunk*obj_chunk_size; vi < end; ++vi)
+					append_vector(s, "vn", normals[vi]);
+				return;
+			}
+			chunk -= nr_normal_chunks;
+			size_t end = std::min(face_sizes.size(), (chunk + 1)*obj_chunk_size);
+			for (size_t fi = chunk*obj_chunk_size, ci = chunk_corners[chunk]; fi < end; ++fi) {
+				s += 'f';
+				for (unsigned j = 0; j < face_sizes[fi]; ++j, ++ci) {
+					s += ' ';
+					append_number(s, corner_vertices[ci] + 1);
+					s += "//";
+					append_number(s, corner_vertices[ci] + 1);
+				}
+				s += '\n';
+			}
+		}, nr_threads);
+		for (size_t i = 0; i < n; ++i)
+			os.write(texts[i].data(), texts[i].size());
+	}
+	return !os.fail();
+}
+
+/// write the mesh to a binary ply file in the byte order of the machine with double precision positions and normals
+bool extracted_mesh::write_ply(std::ostream& os) const
+{
+	const unsigned one = 1;
+	bool little_endian = *(const unsigned char*)&one == 1;
+	bool has_normals = !positions.empty() && normals.size() == positions.size();
+	os << "ply\nformat " << (little_endian ? "binary_little_endian" : "binary_big_endian") << " 1.0\n"
+	   << "element vertex " << positions.size() << "\n"
+	   << "property double x\nproperty double y\nproperty double z\n";
+	if (has_normals)
+		os << "property double nx\nproperty double ny\nproperty double nz\n";
+	os << "element face " << face_sizes.size() << "\n"
+	   << "property list uchar uint vertex_indices\nend_header\n";
+
+	// positions are written directly from the mesh and interleaved with normals through a staging buffer
+	std::vector<char> buffer;
+	if (!has_normals && !positions.empty())
+		os.write((const char*)&positions.front(), positions.size()*sizeof(pnt_type));
+	else {
+		for (size_t first = 0; first < positions.size(); first += binary_chunk_size) {
+			size_t end = std::min(positions.size(), first + binary_chunk_size);
+			buffer.resize((end - first)*(sizeof(pnt_type) + sizeof(vec_type)));
+			char* ptr = &buffer.front();
+			for (size_t vi = first; vi < end; ++vi) {
+				std::memcpy(ptr, &positions[vi], sizeof(pnt_type));
+				std::memcpy(ptr + sizeof(pnt_type), &normals[vi], sizeof(vec_type));
+				ptr += sizeof(pnt_type) + sizeof(vec_type);
+			}
+			os.write(&buffer.front(), buffer.size());
+		}
+	}
+	for (size_t first = 0, ci = 0; first < face_sizes.size(); first += binary_chunk_size) {
+		size_t end = std::min(face_sizes.size(), first + binary_chunk_size);
+		buffer.clear();
+		for (size_t fi = first; fi < end; ci += face_sizes[fi++]) {
+			buffer.push_back(char(face_sizes[fi]));
+			const char* indices = (const char*)&corner_vertices[ci];
+			buffer.insert(buffer.end(), indices, indices + face_sizes[fi]*sizeof(unsigned));
+		}
+		os.write(&buffer.front(), buffer.size());
+	}
+	return !os.fail();
+}
+
+/// append a 32 bit value in little endian byte order
+static char* append_little_endian(char* ptr, unsigned long value)
+{
+	for (unsigned b = 0; b < 4; ++b)
+		*ptr++ = char((value >> (8 * b)) & 255);
+	return ptr;
+}
+
+/// append a float in little endian byte order
+static char* append_little_endian(char* ptr, float value)
+{
+	uint32_t bits;
+	std::memcpy(&bits, &value, sizeof(bits));
+	return append_little_endian(ptr, (unsigned long)bits);
+}
+
+/// write the fan triangulated mesh to a binary stl file with face normals
+bool extracted_mesh::write_stl(std::ostream& os) const
+{
+	// 80 byte header followed by the triangle count and 50 bytes per triangle
+	char header[84] = "binary stl of an extracted implicit surface";
+	append_little_endian(header + 80, (unsigned long)get_nr_triangles());
+	os.write(header, sizeof(header));
+	std::vector<char> buffer;
+	for (size_t first = 0, ci = 0; first < face_sizes.size(); first += binary_chunk_size) {
+		size_t end = std::min(face_sizes.size(), first + binary_chunk_size);
+		buffer.clear();
+		for (size_t fi = first; fi < end; ci += face_sizes[fi++])
+			for (unsigned j = 2; j < face_sizes[fi]; ++j) {
+				const pnt_type* p[3] = { &positions[corner_vertices[ci]],
+					&positions[corner_vertices[ci + j - 1]], &positions[corner_vertices[ci + j]] };
+				vec_type n = normalize(cross(*p[1] - *p[0], *p[2] - *p[0]));
+				char record[50] = { 0 };
+				char* ptr = record;
+				for (unsigned c = 0; c < 3; ++c)
+					ptr = append_little_endian(ptr, float(n(c)));
+				for (unsigned k = 0; k < 3; ++k)
+					for (unsigned c = 0; c < 3; ++c)
+						ptr = append_little_endian(ptr, float((*p[k])(c)));
+				buffer.insert(buffer.end(), record, record + sizeof(record));
+			}
+		if (!buffer.empty())
+			os.write(&buffer.front(), buffer.size());
+	}
+	return !os.fail();
+}
+
+/// write the mesh to a file in the format given by its extension, which is obj, ply or stl
+bool extracted_mesh::write(const std::string& file_name, unsigned nr_threads) const
+{
+	std::string extension = cgv::utils::to_lower(cgv::utils::file::get_extension(file_name));
+	if (extension != "obj" && extension != "ply" && extension != "stl")
+		return false;
+	std::ofstream os(file_name.c_str(), extension == "obj" ? std::ios::out : std::ios::out | std::ios::binary);
+	if (os.fail())
+		return false;
+	if (extension == "ply")
+		return write_ply(os);
+	if (extension == "stl")
+		return write_stl(os);
+	return write_obj(os, nr_threads);
+}
+
+/// construct with default parameters
+surface_extractor::surface_extractor()
+	: res(64), contouring(MARCHING_CUBES), normals(GRADIENT_NORMALS), normal_threshold(0.2),
+	  consistency_threshold(0.01), max_nr_iters(10), epsilon(1e-5), grid_epsilon(0.01),
+	  nr_smoothing_iters(0), triangulate(true), decimate(false), target_nr_triangles(0), max_decimation_error(0.1),
+	  grid_encoding(sample_grid::DOUBLE_SAMPLES), sparse_grid(false), narrow_band_width(4), bounded_sampling(true), nr_threads(0),
+	  isovalue(0), shell_bytes(0)
+{
+}
+
+/// return the number of bytes held by the arrays of a mesh
+static size_t get_mesh_bytes(const extracted_mesh& mesh)
+{
+	return mesh.positions.capacity()*sizeof(extracted_mesh::pnt_type) + mesh.normals.capacity()*sizeof(extracted_mesh::vec_type) +
+		(mesh.corner_vertices.capacity() + mesh.face_sizes.capacity())*sizeof(unsigned);
+}
+
+/// update the peak memory with the bytes held in the buffers, the mesh and extra temporary buffers
+void surface_extractor::track_memory(extraction_statistics& stats, const extracted_mesh& mesh, size_t extra_bytes) const
+{
+	unsigned long long bytes = extra_bytes + shell_bytes +
+		grid.get_memory_usage() + active_cells.capacity()*sizeof(size_t) + active_cell_masks.capacity() + get_mesh_bytes(mesh);
+	if (bytes > stats.peak_memory)
+		stats.peak_memory = bytes;
+}
+
+/// location of a grid node
+surface_extractor::pnt_type surface_extractor::node_location(unsigned i, unsigned j, unsigned k) const
+{
+	return pnt_type(origin(0) + i*spacing(0), origin(1) + j*spacing(1), origin(2) + k*spacing(2));
+}
+
+/// evaluate func at p
+double surface_extractor::evaluate(const F& func, const pnt_type& p)
+{
+	return func.evaluate(p.to_vec());
+}
+
+/// evaluate func at p with the band [lo,hi] if bf is its bounded interface and exactly if bf is 0
+double surface_extractor::evaluate(const F& func, const bounded_function* bf, const pnt_type& p, double lo, double hi)
+{
+	return bf ? bf->evaluate_bounded(p.to_vec(), lo, hi) : func.evaluate(p.to_vec());
+}
+
+/// return the interface of func for evaluations with the band of the current grid or 0 if func is sampled exactly
+const bounded_function* surface_extractor::get_bounded_function(const F& func, double& lo, double& hi) const
+{
+	// the band has to contain the isovalues strictly, as bounds on its border could otherwise lie on an isovalue
+	if (!bounded_sampling || grid.isovalues.empty() || !(grid.band_width > 0))
+		return 0;
+	lo = *std::min_element(grid.isovalues.begin(), grid.isovalues.end()) - grid.band_width;
+	hi = *std::max_element(grid.isovalues.begin(), grid.isovalues.end()) + grid.band_width;
+	return dynamic_cast<const bounded_function*>(&func);
+}
+
+/// evaluate the gradient of func at p
+surface_extractor::vec_type surface_extractor::evaluate_gradient(const F& func, const pnt_type& p)
+{
+	vec<double> g = func.evaluate_gradient(p.to_vec());
+	return vec_type(g(0), g(1), g(2));
+}
+
+/// extract the surface of func inside box into mesh and record timings and counters in stats
+void surface_extractor::extract(const F& func, const box_type& box, extracted_mesh& mesh, extraction_statistics& stats)
+{
+	stats = extraction_statistics();
+	mesh.clear();
+	if (res < 2)
+		return;
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	origin = box.get_min_pnt();
+	spacing = box.get_extent() / double(res - 1);
+	grid.isovalues.assign(1, 0.0);
+	sample(func, stats);
+	isovalue = 0;
+	shell_bytes = 0;
+	contour(func, mesh, stats);
+	stats.total_ms = elapsed_ms(start);
+}
+
+/// extract the level sets of func at the isovalues into one mesh each from a single sampling pass
+void surface_extractor::extract_shells(const F& func, const box_type& box, const std::vector<double>& isovalues,
+	std::vector<extracted_mesh>& meshes, extraction_statistics& stats, bool reuse_samples)
+{
+	stats = extraction_statistics();
+	meshes.resize(isovalues.size());
+	for (size_t si = 0; si < meshes.size(); ++si)
+		meshes[si].clear();
+	if (res < 2)
+		return;
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	if (!reuse_samples || !can_reuse_samples(box, isovalues)) {
+		origin = box.get_min_pnt();
+		spacing = box.get_extent() / double(res - 1);
+		grid.isovalues = isovalues;
+		sample(func, stats);
+	}
+	contour_shells(func, isovalues, meshes, stats);
+	stats.total_ms = elapsed_ms(start);
+}
+
+/// extract the level sets of func at the isovalues after func changed in parts
+void surface_extractor::update_shells(const F& func, const box_type& box, const std::vector<double>& isovalues,
+	const change_predicate& may_change, std::vector<extracted_mesh>& meshes, extraction_statistics& stats)
+{
+	stats = extraction_statistics();
+	meshes.resize(isovalues.size());
+	for (size_t si = 0; si < meshes.size(); ++si)
+		meshes[si].clear();
+	if (res < 2)
+		return;
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	if (can_reuse_samples(box, isovalues))
+		resample(func, may_change, stats);
+	else {
+		origin = box.get_min_pnt();
+		spacing = box.get_extent() / double(res - 1);
+		grid.isovalues = isovalues;
+		sample(func, stats);
+	}
+	contour_shells(func, isovalues, meshes, stats);
+	stats.total_ms = elapsed_ms(start);
+}
+
+/// return whether the samples of the last extraction can be contoured at the isovalues inside box
+bool surface_extractor::can_reuse_samples(const box_type& box, const std::vector<double>& isovalues) const
+{
+	if (grid.empty() || grid.get_res() != res || grid.encoding != grid_encoding || grid.sparse != sparse_grid)
+		return false;
+	vec_type box_spacing = box.get_extent() / double(res - 1);
+	for (unsigned c = 0; c < 3; ++c)
+		if (origin(c) != box.get_min_pnt()(c) || spacing(c) != box_spacing(c))
+			return false;
+	if (grid.band_width != narrow_band_width*std::max(spacing(0), std::max(spacing(1), spacing(2))))
+		return false;
+	for (size_t si = 0; si < isovalues.size(); ++si)
+		if (!grid.is_exact_for(isovalues[si]))
+			return false;
+	return true;
+}
+
+/// contour the sampled grid at the level set of the current isovalue
+void surface_extractor::contour(const F& func, extracted_mesh& mesh, extraction_statistics& stats)
+{
+	track_memory(stats, mesh);
+	classify(stats);
+	track_memory(stats, mesh);
+	switch (contouring) {
+	case DUAL_CONTOURING: place_vertices_dual_contouring(func, mesh, stats); break;
+	case SURFACE_NETS: place_vertices_surface_nets(mesh, stats); break;
+	default: place_vertices_marching_cubes(mesh, stats); break;
+	}
+	track_memory(stats, mesh);
+	if (decimate) {
+		decimate_mesh(mesh, stats);
+		track_memory(stats, mesh);
+	}
+	compute_normals(func, mesh, stats);
+	track_memory(stats, mesh);
+}
+
+/// contour the sampled grid at each of the isovalues into one mesh
+void surface_extractor::contour_shells(const F& func, const std::vector<double>& isovalues, std::vector<extracted_mesh>& meshes, extraction_statistics& stats)
+{
+	// the phases are parallel over the cells of one shell, such that the shells are contoured one after the other
+	shell_bytes = 0;
+	for (size_t si = 0; si < isovalues.size(); ++si) {
+		isovalue = isovalues[si];
+		contour(func, meshes[si], stats);
+		shell_bytes += get_mesh_bytes(meshes[si]);
+	}
+}
+
+/// write the samples of the last extraction to a vox file with one byte per sample and a .hd header file
+bool surface_extractor::write_volume(const std::string& file_name, double map_to_zero_value, double map_to_one_value) const
+{
+	if (grid.empty() || map_to_zero_value == map_to_one_value)
+		return false;
+	std::string hd_file_name = file_name.substr(0, file_name.find_last_of('.')) + ".hd";
+	std::ofstream hd(hd_file_name.c_str());
+	if (hd.fail())
+		return false;
+	vec_type extent = spacing*double(res - 1);
+	hd << "Size:      " << res << ", " << res << ", " << res << std::endl;
+	hd << "Spacing:   " << extent(0) << ", " << extent(1) << ", " << extent(2) << std::endl;
+	hd << "Range:     " << map_to_zero_value << ", " << map_to_one_value << std::endl;
+	if (hd.fail())
+		return false;
+
+	// the samples are decoded slice by slice and mapped with clamping as by the volume node
+	double scale = 255 / (map_to_one_value - map_to_zero_value);
+	std::vector<double> slice(size_t(res)*res);
+	std::vector<unsigned char> data(slice.size());
+	std::ofstream os(file_name.c_str(), std::ios::binary);
+	for (unsigned k = 0; k < res && !os.fail(); ++k) {
+		grid.get_slice(k, &slice.front());
+		for (size_t i = 0; i < slice.size(); ++i) {
+			double v = scale*(slice[i] - map_to_zero_value);
+			data[i] = v <= 0 ? 0 : (v >= 255 ? 255 : (unsigned char)(int)(v + 0.5));
+		}
+		os.write((const char*)&data.front(), data.size());
+	}
+	return !os.fail();
+}
+
+/// phase 1: evaluate the function at all grid nodes
+void surface_extractor::sample(const F& func, extraction_statistics& stats)
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	grid.encoding = grid_encoding;
+	grid.sparse = sparse_grid;
+	grid.band_width = narrow_band_width*std::max(spacing(0), std::max(spacing(1), spacing(2)));
+	grid.nr_threads = nr_threads;
+	// samples beyond the band are taken as bounds, of which the grid takes those next to a crossing again
+	double lo = 0, hi = 0;
+	const bounded_function* bf = get_bounded_function(func, lo, hi);
+	grid.build(res, [&](unsigned j, unsigned k, double* row) {
+		for (unsigned i = 0; i < res; ++i)
+			row[i] = evaluate(func, bf, node_location(i, j, k), lo, hi);
+	}, bf ? sample_grid::node_sampler([&](unsigned i, unsigned j, unsigned k) {
+		return evaluate(func, node_location(i, j, k));
+	}) : sample_grid::node_sampler());
+	stats.nr_evaluations += size_t(res)*res*res + grid.get_nr_refined_samples();
+	stats.nr_refined_samples += grid.get_nr_refined_samples();
+	// the grid holds a window of dense slices while it is encoded
+	if (grid.get_peak_memory_usage() > stats.peak_memory)
+		stats.peak_memory = grid.get_peak_memory_usage();
+	stats.sampling_ms = elapsed_ms(start);
+}
+
+/// phase 1 after a partial change of the function: evaluate it only in the bricks that can have changed
+void surface_extractor::resample(const F& func, const change_predicate& may_change, extraction_statistics& stats)
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	unsigned nb = (res + 7) / 8;
+	size_t nr_bricks = size_t(nb)*nb*nb;
+	std::vector<char> changed(nr_bricks);
+	parallel_for(nr_bricks, [&](size_t b) {
+		unsigned bi = unsigned(b % nb), bj = unsigned(b / nb % nb), bk = unsigned(b / nb / nb);
+		box_type block(node_location(8 * bi, 8 * bj, 8 * bk),
+			node_location(std::min(res - 1, 8 * bi + 7), std::min(res - 1, 8 * bj + 7), std::min(res - 1, 8 * bk + 7)));
+		changed[b] = may_change(block) ? 1 : 0;
+	}, nr_threads);
+	size_t nr_changed_bricks = std::count(changed.begin(), changed.end(), 1);
+	if (nr_changed_bricks == nr_bricks) {
+		sample(func, stats);
+		return;
+	}
+	if (nr_changed_bricks > 0) {
+		// encoded grids keep exact values only next to the crossings of the sampled function and sparse grids
+		// keep a single value in bricks without crossings. A sample of an unchanged brick can come to lie next
+		// to a new crossing only if one of its neighbors is in a changed brick, such that these samples are
+		// evaluated again as well.
+		bool evaluate_neighbors = grid.encoding != sample_grid::DOUBLE_SAMPLES || grid.sparse;
+		auto is_next_to_change = [&](unsigned i, unsigned j, unsigned k) {
+			unsigned lo[3] = { i > 0 ? i - 1 : 0, j > 0 ? j - 1 : 0, k > 0 ? k - 1 : 0 };
+			unsigned hi[3] = { std::min(res - 1, i + 1), std::min(res - 1, j + 1), std::min(res - 1, k + 1) };
+			for (unsigned bk = lo[2] / 8; bk <= hi[2] / 8; ++bk)
+				for (unsigned bj = lo[1] / 8; bj <= hi[1] / 8; ++bj)
+					for (unsigned bi = lo[0] / 8; bi <= hi[0] / 8; ++bi)
+						if (changed[(size_t(bk)*nb + bj)*nb + bi])
+							return true;
+			return false;
+		};
+		// the grid is encoded anew from the decoded samples of the last extraction and the new evaluations
+		sample_grid previous;
+		std::swap(previous, grid);
+		grid.encoding = previous.encoding;
+		grid.sparse = previous.sparse;
+		grid.band_width = previous.band_width;
+		grid.isovalues = previous.isovalues;
+		grid.nr_threads = nr_threads;
+		// the samples kept from the last extraction were taken with the same band
+		double lo = 0, hi = 0;
+		const bounded_function* bf = get_bounded_function(func, lo, hi);
+		std::atomic<unsigned long long> nr_row_evaluations(0);
+		grid.build(res, [&](unsigned j, unsigned k, double* row) {
+			const char* brick_row = &changed[(size_t(k / 8)*nb + j / 8)*nb];
+			if (std::find(brick_row, brick_row + nb, 0) != brick_row + nb)
+				previous.get_row(j, k, row);
+			unsigned n = 0;
+			for (unsigned i = 0; i < res; ++i)
+				if (brick_row[i / 8] || (evaluate_neighbors && (i % 8 == 0 || i % 8 == 7 || j % 8 == 0 || j % 8 == 7 ||
+					k % 8 == 0 || k % 8 == 7) && is_next_to_change(i, j, k))) {
+					row[i] = evaluate(func, bf, node_location(i, j, k), lo, hi);
+					++n;
+				}
+			nr_row_evaluations += n;
+		}, bf ? sample_grid::node_sampler([&](unsigned i, unsigned j, unsigned k) {
+			return evaluate(func, node_location(i, j, k));
+		}) : sample_grid::node_sampler());
+		stats.nr_evaluations += nr_row_evaluations + grid.get_nr_refined_samples();
+		stats.nr_refined_samples += grid.get_nr_refined_samples();
+		stats.nr_reused_samples += (unsigned long long)res*res*res - nr_row_evaluations;
+		// both grids are held while the new one is sampled and encoded
+		stats.peak_memory = std::max(stats.peak_memory, (unsigned long long)(grid.get_peak_memory_usage() + previous.get_memory_usage()));
+	}
+	else {
+		stats.nr_reused_samples += (unsigned long long)res*res*res;
+		stats.peak_memory = std::max(stats.peak_memory, (unsigned long long)grid.get_memory_usage());
+	}
+	stats.sampling_ms = elapsed_ms(start);
+}
+
+/// phase 2: compute the corner sign masks and collect the active cells
+void surface_extractor::classify(extraction_statistics& stats)
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	unsigned n = res - 1;
+	// active cells are collected per slice and concatenated such that they stay sorted
+	std::vector<std::vector<size_t> > slice_active_cells(n);
+	std::vector<std::vector<unsigned char> > slice_active_cell_masks(n);
+	parallel_for(n, [&](size_t k) {
+		std::vector<size_t>& slice_cells = slice_active_cells[k];
+		std::vector<unsigned char>& slice_masks = slice_active_cell_masks[k];
+		// samples not stored densely are decoded for the two slices of nodes around the slice of cells
+		std::vector<double> decoded;
+		const double* slices[2] = { grid.get_dense_slice(unsigned(k)), grid.get_dense_slice(unsigned(k) + 1) };
+		if (!slices[0]) {
+			decoded.resize(2 * size_t(res)*res);
+			grid.get_slice(unsigned(k), &decoded[0]);
+			grid.get_slice(unsigned(k) + 1, &decoded[size_t(res)*res]);
+			slices[0] = &decoded[0];
+			slices[1] = &decoded[size_t(res)*res];
+		}
+		for (unsigned j = 0; j < n; ++j)
+			for (unsigned i = 0; i < n; ++i) {
+				unsigned char mask = 0;
+				for (unsigned c = 0; c < 8; ++c)
+					if (slices[c >> 2][size_t(j + ((c >> 1) & 1))*res + i + (c & 1)] < isovalue)
+						mask |= (unsigned char)(1 << c);
+				if (mask != 0 && mask != 255) {
+					slice_cells.push_back(cell_index(i, j, unsigned(k)));
+					slice_masks.push_back(mask);
+				}
+			}
+	}, nr_threads);
+	active_cells.clear();
+	active_cell_masks.clear();
+	for (unsigned k = 0; k < n; ++k) {
+		active_cells.insert(active_cells.end(), slice_active_cells[k].begin(), slice_active_cells[k].end());
+		active_cell_masks.insert(active_cell_masks.end(), slice_active_cell_masks[k].begin(), slice_active_cell_masks[k].end());
+	}
+	stats.nr_cells += (unsigned long long)n*n*n;
+	stats.nr_active_cells += active_cells.size();
+	stats.classification_ms += elapsed_ms(start);
+}
+
+/// faces of one block of active cells, whose corners refer to block local vertices. Vertices are
+/// identified by keys that are unique over all blocks, such that vertices shared between blocks
+/// are welded when the blocks are merged.
+struct block_mesh
+{
+	typedef extracted_mesh::pnt_type pnt_type;
+	/// key and position per local vertex
+	std::vector<unsigned long long> keys;
+	std::vector<pnt_type> points;
+	/// local vertex index per key
+	std::unordered_map<unsigned long long, unsigned> local_indices;
+	/// local vertex index per face corner and number of corners per face
+	std::vector<unsigned> corner_vertices, face_sizes;
+	/// return the local index of the vertex with the given key, which is added at p if it is new
+	unsigned add_vertex(unsigned long long key, const pnt_type& p)
+	{
+		std::pair<std::unordered_map<unsigned long long, unsigned>::iterator, bool> ins =
+			local_indices.insert(std::make_pair(key, unsigned(keys.size())));
+		if (ins.second) {
+			keys.push_back(key);
+			points.push_back(p);
+		}
+		return ins.first->second;
+	}
+	/// append a polygon either as polygon or as triangle fan, where repeated corners of vertices
+	/// snapped to the same grid node are removed and polygons with less than three corners dropped
+	void add_polygon(const unsigned* corners, unsigned n, bool triangulate)
+	{
+		unsigned unique_corners[12], m = 0;
+		for (unsigned ci = 0; ci < n; ++ci)
+			if (m == 0 || corners[ci] != unique_corners[m - 1])
+				unique_corners[m++] = corners[ci];
+		while (m > 1 && unique_corners[m - 1] == unique_corners[0])
+			--m;
+		if (m < 3)
+			return;
+		if (!triangulate || m == 3) {
+			corner_vertices.insert(corner_vertices.end(), unique_corners, unique_corners + m);
+			face_sizes.push_back(m);
+			return;
+		}
+		for (unsigned ci = 1; ci + 1 < m; ++ci) {
+			corner_vertices.push_back(unique_corners[0]);
+			corner_vertices.push_back(unique_corners[ci]);
+			corner_vertices.push_back(unique_corners[ci + 1]);
+			face_sizes.push_back(3);
+		}
+	}
+	/// return the number of bytes held by the block
+	size_t get_bytes() const
+	{
+		return keys.capacity()*sizeof(unsigned long long) + points.capacity()*sizeof(pnt_type) +
+			local_indices.size()*(sizeof(unsigned long long) + 2*sizeof(unsigned)) +
+			(corner_vertices.capacity() + face_sizes.capacity())*sizeof(unsigned);
+	}
+};
+
+/// return the bytes held by the block meshes
+static size_t get_block_mesh_bytes(const std::vector<block_mesh>& block_meshes)
+{
+	size_t bytes = 0;
+	for (size_t bi = 0; bi < block_meshes.size(); ++bi)
+		bytes += block_meshes[bi].get_bytes();
+	return bytes;
+}
+
+/// merge the block meshes into mesh in block order, where vertices with the same key are welded
+static void merge_block_meshes(std::vector<block_mesh>& block_meshes, extracted_mesh& mesh)
+{
+	size_t nr_vertices = 0, nr_corners = 0, nr_faces = 0;
+	for (size_t bi = 0; bi < block_meshes.size(); ++bi) {
+		nr_vertices += block_meshes[bi].keys.size();
+		nr_corners += block_meshes[bi].corner_vertices.size();
+		nr_faces += block_meshes[bi].face_sizes.size();
+	}
+	std::unordered_map<unsigned long long, unsigned> global_indices;
+	global_indices.reserve(nr_vertices);
+	mesh.positions.reserve(nr_vertices);
+	mesh.corner_vertices.reserve(nr_corners);
+	mesh.face_sizes.reserve(nr_faces);
+	std::vector<unsigned> global_index_of_local;
+	for (size_t bi = 0; bi < block_meshes.size(); ++bi) {
+		block_mesh& bm = block_meshes[bi];
+		global_index_of_local.resize(bm.keys.size());
+		for (size_t li = 0; li < bm.keys.size(); ++li) {
+			std::pair<std::unordered_map<unsigned long long, unsigned>::iterator, bool> ins =
+				global_indices.insert(std::make_pair(bm.keys[li], unsigned(mesh.positions.size())));
+			if (ins.second)
+				mesh.positions.push_back(bm.points[li]);
+			global_index_of_local[li] = ins.first->second;
+		}
+		for (size_t ci = 0; ci < bm.corner_vertices.size(); ++ci)
+			mesh.corner_vertices.push_back(global_index_of_local[bm.corner_vertices[ci]]);
+		mesh.face_sizes.insert(mesh.face_sizes.end(), bm.face_sizes.begin(), bm.face_sizes.end());
+		bm = block_mesh();
+	}
+}
+
+/// phase 3 for marching cubes: trace the polygons of all active cells
+void surface_extractor::place_vertices_marching_cubes(extracted_mesh& mesh, extraction_statistics& stats)
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	unsigned n = res - 1;
+	size_t nr_blocks = (active_cells.size() + cell_block_size - 1) / cell_block_size;
+	std::vector<block_mesh> block_meshes(nr_blocks);
+	parallel_for(nr_blocks, [&](size_t bi) {
+		block_mesh& bm = block_meshes[bi];
+		size_t end = std::min(active_cells.size(), (bi + 1)*cell_block_size);
+		for (size_t ai = bi*cell_block_size; ai < end; ++ai) {
+			size_t ci = active_cells[ai];
+			unsigned i = unsigned(ci % n), j = unsigned((ci / n) % n), k = unsigned(ci / (size_t(n)*n));
+			unsigned mask = active_cell_masks[ai];
+			double v[8];
+			for (unsigned c = 0; c < 8; ++c)
+				v[c] = grid.get_value(i + (c & 1), j + ((c >> 1) & 1), k + (c >> 2)) - isovalue;
+			// vertices on the edges with sign change are keyed by the lower node and the edge axis
+			// and always interpolated from the lower to the upper corner, such that neighboring cells
+			// compute identical positions. Vertices snapped to a node are keyed by the node.
+			unsigned edge_vertices[12];
+			for (unsigned e = 0; e < 12; ++e) {
+				unsigned c0 = edge_corners[e][0], c1 = edge_corners[e][1];
+				if (((mask >> c0) & 1) == ((mask >> c1) & 1))
+					continue;
+				size_t n0 = node_index(i + (c0 & 1), j + ((c0 >> 1) & 1), k + (c0 >> 2));
+				size_t n1 = node_index(i + (c1 & 1), j + ((c1 >> 1) & 1), k + (c1 >> 2));
+				pnt_type p0 = node_location(i + (c0 & 1), j + ((c0 >> 1) & 1), k + (c0 >> 2));
+				pnt_type p1 = node_location(i + (c1 & 1), j + ((c1 >> 1) & 1), k + (c1 >> 2));
+				double t = v[c0] / (v[c0] - v[c1]);
+				if (t < grid_epsilon)
+					edge_vertices[e] = bm.add_vertex(4*(unsigned long long)n0 + 3, p0);
+				else if (t > 1 - grid_epsilon)
+					edge_vertices[e] = bm.add_vertex(4*(unsigned long long)n1 + 3, p1);
+				else
+					edge_vertices[e] = bm.add_vertex(4*(unsigned long long)n0 + e / 4, p0 + t*(p1 - p0));
+			}
+			// on each face segments lead from an edge entering the inside to the edge leaving it,
+			// where faces with four crossings connect the inside corners across the face center if
+			// the center is inside and separate them otherwise
+			int next_edge[12];
+			std::fill(next_edge, next_edge + 12, -1);
+			for (unsigned f = 0; f < 6; ++f) {
+				unsigned crossings[4], nr_crossings = 0;
+				bool entering[4];
+				for (unsigned q = 0; q < 4; ++q) {
+					bool in0 = ((mask >> face_corners[f][q]) & 1) != 0;
+					bool in1 = ((mask >> face_corners[f][(q + 1) % 4]) & 1) != 0;
+					if (in0 != in1) {
+						crossings[nr_crossings] = face_edges[f][q];
+						entering[nr_crossings++] = in1;
+					}
+				}
+				if (nr_crossings == 2) {
+					if (entering[0])
+						next_edge[crossings[0]] = crossings[1];
+					else
+						next_edge[crossings[1]] = crossings[0];
+				}
+				else if (nr_crossings == 4) {
+					// sum in ascending corner order such that both cells of the face agree
+					unsigned sorted_corners[4] = { face_corners[f][0], face_corners[f][1], face_corners[f][2], face_corners[f][3] };
+					std::sort(sorted_corners, sorted_corners + 4);
+					double center_value = v[sorted_corners[0]] + v[sorted_corners[1]] + v[sorted_corners[2]] + v[sorted_corners[3]];
+					unsigned offset = center_value < 0 ? 3 : 1;
+					for (unsigned m = 0; m < 4; ++m)
+						if (entering[m])
+							next_edge[crossings[m]] = crossings[(m + offset) % 4];
+				}
+			}
+			// chain the segments to closed polygons
+			bool visited[12] = { false };
+			unsigned corners[12];
+			for (unsigned e = 0; e < 12; ++e) {
+				if (next_edge[e] == -1 || visited[e])
+					continue;
+				unsigned nr_corners = 0;
+				for (int ei = int(e); !visited[ei]; ei = next_edge[ei]) {
+					visited[ei] = true;
+					corners[nr_corners++] = edge_vertices[ei];
+				}
+				bm.add_polygon(corners, nr_corners, triangulate);
+			}
+		}
+	}, nr_threads);
+	track_memory(stats, mesh, get_block_mesh_bytes(block_meshes));
+	merge_block_meshes(block_meshes, mesh);
+	stats.vertex_ms += elapsed_ms(start);
+}
+
+/// find the crossing on the edge from p0 with value v0 to p1 with value v1 by linear
+/// interpolation and regula falsi refinement
+surface_extractor::pnt_type surface_extractor::find_crossing(const F& func, const pnt_type& p0, double v0, const pnt_type& p1, double v1, unsigned long long& nr_evaluations) const
+{
+	pnt_type a = p0, b = p1;
+	double fa = v0, fb = v1;
+	pnt_type p = a + (fa / (fa - fb))*(b - a);
+	for (unsigned iter = 0; iter < max_nr_iters; ++iter) {
+		double f = evaluate(func, p) - isovalue;
+		++nr_evaluations;
+		if (std::abs(f) <= epsilon)
+			break;
+		if ((f < 0) == (fa < 0)) {
+			a = p;
+			fa = f;
+		}
+		else {
+			b = p;
+			fb = f;
+		}
+		p = a + (fa / (fa - fb))*(b - a);
+	}
+	return p;
+}
+
+/// phase 3 for dual contouring: place one vertex per active cell and connect them to quads
+void surface_extractor::place_vertices_dual_contouring(const F& func, extracted_mesh& mesh, extraction_statistics& stats)
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	unsigned n = res - 1;
+	size_t nr_blocks = (active_cells.size() + cell_block_size - 1) / cell_block_size;
+	double min_spacing = std::min(spacing(0), std::min(spacing(1), spacing(2)));
+	double max_error = consistency_threshold*min_spacing*min_spacing;
+	std::vector<unsigned long long> block_evaluations(nr_blocks, 0), block_gradient_evaluations(nr_blocks, 0);
+
+	// vertex k belongs to active cell k
+	std::vector<pnt_type> cell_vertices(active_cells.size());
+	parallel_for(nr_blocks, [&](size_t bi) {
+		size_t end = std::min(active_cells.size(), (bi + 1)*cell_block_size);
+		for (size_t ai = bi*cell_block_size; ai < end; ++ai) {
+			size_t ci = active_cells[ai];
+			unsigned i = unsigned(ci % n), j = unsigned((ci / n) % n), k = unsigned(ci / (size_t(n)*n));
+			unsigned mask = active_cell_masks[ai];
+			pnt_type mass_point(0, 0, 0);
+			unsigned nr_crossings = 0;
+			qem<double> Q;
+			for (unsigned e = 0; e < 12; ++e) {
+				unsigned c0 = edge_corners[e][0], c1 = edge_corners[e][1];
+				if (((mask >> c0) & 1) == ((mask >> c1) & 1))
+					continue;
+				unsigned i0 = i + (c0 & 1), j0 = j + ((c0 >> 1) & 1), k0 = k + (c0 >> 2);
+				unsigned i1 = i + (c1 & 1), j1 = j + ((c1 >> 1) & 1), k1 = k + (c1 >> 2);
+				pnt_type p = find_crossing(func, node_location(i0, j0, k0), grid.get_value(i0, j0, k0) - isovalue,
+					node_location(i1, j1, k1), grid.get_value(i1, j1, k1) - isovalue, block_evaluations[bi]);
+				vec_type g = evaluate_gradient(func, p);
+				++block_gradient_evaluations[bi];
+				mass_point += p;
+				if (g.normalize() > 0) {
+					qem<double> Qe(p.to_vec(), g.to_vec());
+					if (nr_crossings == 0)
+						Q = Qe;
+					else
+						Q += Qe;
+				}
+				++nr_crossings;
+			}
+			mass_point /= double(nr_crossings);
+			// use the quadric minimum only if it is consistent and inside of the cell
+			vec<double> x = Q.compute_minimum(mass_point.to_vec(), qem_singular_value_threshold);
+			pnt_type q(x(0), x(1), x(2));
+			pnt_type cell_min = node_location(i, j, k) + grid_epsilon*spacing;
+			pnt_type cell_max = node_location(i + 1, j + 1, k + 1) - grid_epsilon*spacing;
+			bool use_minimum = Q.evaluate(x) <= max_error;
+			for (unsigned c = 0; use_minimum && c < 3; ++c)
+				if (!(q(c) >= cell_min(c) && q(c) <= cell_max(c)))
+					use_minimum = false;
+			cell_vertices[ai] = use_minimum ? q : mass_point;
+		}
+	}, nr_threads);
+	for (size_t bi = 0; bi < nr_blocks; ++bi) {
+		stats.nr_evaluations += block_evaluations[bi];
+		stats.nr_gradient_evaluations += block_gradient_evaluations[bi];
+	}
+
+	connect_cell_vertices(cell_vertices, mesh, stats);
+	stats.vertex_ms += elapsed_ms(start);
+}
+
+/// return the index of an active cell in active_cells
+size_t surface_extractor::find_active_cell(size_t ci) const
+{
+	return std::lower_bound(active_cells.begin(), active_cells.end(), ci) - active_cells.begin();
+}
+
+/// return the mass point of the linearly interpolated edge crossings of the active cell with index ai
+surface_extractor::pnt_type surface_extractor::compute_mass_point(size_t ai) const
+{
+	unsigned n = res - 1;
+	size_t ci = active_cells[ai];
+	unsigned i = unsigned(ci % n), j = unsigned((ci / n) % n), k = unsigned(ci / (size_t(n)*n));
+	unsigned mask = active_cell_masks[ai];
+	pnt_type mass_point(0, 0, 0);
+	unsigned nr_crossings = 0;
+	for (unsigned e = 0; e < 12; ++e) {
+		unsigned c0 = edge_corners[e][0], c1 = edge_corners[e][1];
+		if (((mask >> c0) & 1) == ((mask >> c1) & 1))
+			continue;
+		unsigned i0 = i + (c0 & 1), j0 = j + ((c0 >> 1) & 1), k0 = k + (c0 >> 2);
+		unsigned i1 = i + (c1 & 1), j1 = j + ((c1 >> 1) & 1), k1 = k + (c1 >> 2);
+		double v0 = grid.get_value(i0, j0, k0) - isovalue, v1 = grid.get_value(i1, j1, k1) - isovalue;
+		pnt_type p0 = node_location(i0, j0, k0);
+		mass_point += p0 + (v0 / (v0 - v1))*(node_location(i1, j1, k1) - p0);
+		++nr_crossings;
+	}
+	return mass_point / double(nr_crossings);
+}
+
+/// phase 3 for surface nets: place one vertex per active cell at the mass point of its edge crossings,
+/// relax the vertices towards their neighbors and connect them to quads
+void surface_extractor::place_vertices_surface_nets(extracted_mesh& mesh, extraction_statistics& stats)
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	unsigned n = res - 1;
+	size_t nr_blocks = (active_cells.size() + cell_block_size - 1) / cell_block_size;
+	std::vector<pnt_type> cell_vertices(active_cells.size());
+	parallel_for(nr_blocks, [&](size_t bi) {
+		size_t end = std::min(active_cells.size(), (bi + 1)*cell_block_size);
+		for (size_t ai = bi*cell_block_size; ai < end; ++ai)
+			cell_vertices[ai] = compute_mass_point(ai);
+	}, nr_threads);
+
+	// each relaxation moves the vertices halfway to the average of the vertices in the active
+	// cells that share a face with a sign change, which are the neighbors in the mesh
+	std::vector<pnt_type> relaxed_vertices(nr_smoothing_iters > 0 ? cell_vertices.size() : 0);
+	for (unsigned iter = 0; iter < nr_smoothing_iters; ++iter) {
+		parallel_for(nr_blocks, [&](size_t bi) {
+			size_t end = std::min(active_cells.size(), (bi + 1)*cell_block_size);
+			for (size_t ai = bi*cell_block_size; ai < end; ++ai) {
+				size_t ci = active_cells[ai];
+				unsigned idx[3] = { unsigned(ci % n), unsigned((ci / n) % n), unsigned(ci / (size_t(n)*n)) };
+				unsigned mask = active_cell_masks[ai];
+				pnt_type sum(0, 0, 0);
+				unsigned nr_neighbors = 0;
+				for (unsigned f = 0; f < 6; ++f) {
+					unsigned a = f / 2, face_mask = 0;
+					if (f % 2 == 0 ? idx[a] == 0 : idx[a] + 1 == n)
+						continue;
+					for (unsigned q = 0; q < 4; ++q)
+						face_mask |= ((mask >> face_corners[f][q]) & 1) << q;
+					if (face_mask == 0 || face_mask == 15)
+						continue;
+					unsigned nidx[3] = { idx[0], idx[1], idx[2] };
+					nidx[a] = f % 2 == 0 ? nidx[a] - 1 : nidx[a] + 1;
+					sum += cell_vertices[find_active_cell(cell_index(nidx[0], nidx[1], nidx[2]))];
+					++nr_neighbors;
+				}
+				pnt_type p = cell_vertices[ai];
+				if (nr_neighbors > 0)
+					p = 0.5*(p + sum / double(nr_neighbors));
+				pnt_type cell_min = node_location(idx[0], idx[1], idx[2]);
+				relaxed_vertices[ai] = max(cell_min, min(cell_min + spacing, p));
+			}
+		}, nr_threads);
+		cell_vertices.swap(relaxed_vertices);
+	}
+	track_memory(stats, mesh, (cell_vertices.capacity() + relaxed_vertices.capacity())*sizeof(pnt_type));
+	connect_cell_vertices(cell_vertices, mesh, stats);
+	stats.vertex_ms += elapsed_ms(start);
+}
+
+/// connect the vertices of the four cells around each interior grid edge with a sign change to a
+/// quad, where cell_vertices holds one vertex per active cell
+void surface_extractor::connect_cell_vertices(const std::vector<pnt_type>& cell_vertices, extracted_mesh& mesh, extraction_statistics& stats)
+{
+	// each edge is owned by the active cell at its lower node and the quads are oriented such that
+	// they face the outside. Vertices are keyed by their active cell.
+	unsigned n = res - 1;
+	size_t nr_blocks = (active_cells.size() + cell_block_size - 1) / cell_block_size;
+	std::vector<block_mesh> block_meshes(nr_blocks);
+	parallel_for(nr_blocks, [&](size_t bi) {
+		block_mesh& bm = block_meshes[bi];
+		size_t end = std::min(active_cells.size(), (bi + 1)*cell_block_size);
+		for (size_t ai = bi*cell_block_size; ai < end; ++ai) {
+			size_t ci = active_cells[ai];
+			unsigned idx[3] = { unsigned(ci % n), unsigned((ci / n) % n), unsigned(ci / (size_t(n)*n)) };
+			unsigned mask = active_cell_masks[ai];
+			for (unsigned a = 0; a < 3; ++a) {
+				bool inside0 = (mask & 1) != 0;
+				bool inside1 = ((mask >> (1 << a)) & 1) != 0;
+				unsigned b = (a + 1) % 3, c = (a + 2) % 3;
+				if (inside0 == inside1 || idx[b] == 0 || idx[c] == 0)
+					continue;
+				// cells around the edge in counter clockwise order around axis a
+				static const unsigned offsets[4][2] = { { 1,1 }, { 0,1 }, { 0,0 }, { 1,0 } };
+				unsigned corners[4];
+				for (unsigned q = 0; q < 4; ++q) {
+					unsigned nidx[3] = { idx[0], idx[1], idx[2] };
+					nidx[b] -= offsets[q][0];
+					nidx[c] -= offsets[q][1];
+					size_t vi = find_active_cell(cell_index(nidx[0], nidx[1], nidx[2]));
+					corners[inside0 ? q : 3 - q] = bm.add_vertex(vi, cell_vertices[vi]);
+				}
+				bm.add_polygon(corners, 4, triangulate);
+			}
+		}
+	}, nr_threads);
+	track_memory(stats, mesh, get_block_mesh_bytes(block_meshes) + cell_vertices.capacity()*sizeof(pnt_type));
+	merge_block_meshes(block_meshes, mesh);
+}
+
+/// optional phase: simplify the mesh by edge collapses
+void surface_extractor::decimate_mesh(extracted_mesh& mesh, extraction_statistics& stats)
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	mesh_decimator decimator;
+	decimator.target_nr_triangles = target_nr_triangles;
+	decimator.max_error = max_decimation_error*std::min(spacing(0), std::min(spacing(1), spacing(2)));
+	decimator.nr_threads = nr_threads;
+	stats.nr_collapses += decimator.decimate(mesh);
+	stats.decimation_ms += elapsed_ms(start);
+}
+
+/// compute the normals of all faces with lengths proportional to the face areas
+static void compute_face_normals(const extracted_mesh& mesh, std::vector<extracted_mesh::vec_type>& face_normals)
+{
+	face_normals.resize(mesh.face_sizes.size());
+	const std::vector<unsigned>& C = mesh.corner_vertices;
+	size_t ci = 0;
+	for (size_t fi = 0; fi < mesh.face_sizes.size(); ++fi) {
+		unsigned m = mesh.face_sizes[fi];
+		extracted_mesh::vec_type nml(0, 0, 0);
+		for (unsigned j = 0; j < m; ++j)
+			nml += cross(mesh.positions[C[ci + j]], mesh.positions[C[ci + (j + 1) % m]]);
+		face_normals[fi] = 0.5*nml;
+		ci += m;
+	}
+}
+
+/// phase 4: compute normals of all vertices
+void surface_extractor::compute_normals(const F& func, extracted_mesh& mesh, extraction_statistics& stats)
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	size_t nr_vertices = mesh.positions.size();
+	std::vector<vec_type> vertex_normals;
+	if (normals == GRADIENT_NORMALS || normals == CORNER_GRADIENTS) {
+		vertex_normals.resize(nr_vertices);
+		parallel_for(nr_vertices, [&](size_t vi) {
+			vertex_normals[vi] = normalize(evaluate_gradient(func, mesh.positions[vi]));
+		}, nr_threads);
+		stats.nr_gradient_evaluations += nr_vertices;
+		if (normals == GRADIENT_NORMALS) {
+			mesh.normals.swap(vertex_normals);
+			stats.normal_ms += elapsed_ms(start);
+			return;
+		}
+	}
+	std::vector<vec_type> face_normals;
+	compute_face_normals(mesh, face_normals);
+	if (normals == CORNER_NORMALS) {
+		// accumulate the area weighted normals of the faces around each vertex
+		vertex_normals.assign(nr_vertices, vec_type(0, 0, 0));
+		for (size_t fi = 0, ci = 0; fi < mesh.face_sizes.size(); ++fi)
+			for (unsigned j = 0; j < mesh.face_sizes[fi]; ++j, ++ci)
+				vertex_normals[mesh.corner_vertices[ci]] += face_normals[fi];
+		for (size_t vi = 0; vi < nr_vertices; ++vi)
+			vertex_normals[vi].normalize();
+	}
+
+	// corners at which the vertex normal deviates too much from the face normal, and all corners
+	// for face normals, receive a vertex of their own with the face normal
+	std::vector<pnt_type> positions;
+	std::vector<vec_type> corner_normals;
+	std::vector<unsigned> new_index(nr_vertices, unsigned(-1));
+	positions.reserve(nr_vertices);
+	corner_normals.reserve(nr_vertices);
+	for (size_t fi = 0, ci = 0; fi < mesh.face_sizes.size(); ++fi) {
+		vec_type face_normal = normalize(face_normals[fi]);
+		for (unsigned j = 0; j < mesh.face_sizes[fi]; ++j, ++ci) {
+			unsigned vi = mesh.corner_vertices[ci];
+			if (!vertex_normals.empty() && dot(vertex_normals[vi], face_normal) >= normal_threshold) {
+				if (new_index[vi] == unsigned(-1)) {
+					new_index[vi] = unsigned(positions.size());
+					positions.push_back(mesh.positions[vi]);
+					corner_normals.push_back(vertex_normals[vi]);
+				}
+				mesh.corner_vertices[ci] = new_index[vi];
+			}
+			else {
+				mesh.corner_vertices[ci] = unsigned(positions.size());
+				positions.push_back(mesh.positions[vi]);
+				corner_normals.push_back(face_normal);
+			}
+		}
+	}
+	track_memory(stats, mesh, face_normals.capacity()*sizeof(vec_type) + vertex_normals.capacity()*sizeof(vec_type) +
+		new_index.capacity()*sizeof(unsigned) + positions.capacity()*sizeof(pnt_type) + corner_normals.capacity()*sizeof(vec_type));
+	mesh.positions.swap(positions);
+	mesh.normals.swap(corner_normals);
+	stats.normal_ms += elapsed_ms(start);
+}
@@ -0,0 +1,239 @@
+#pragma once
+
+#include <vector>
+#include <ostream>
+#include <string>
+#include <functional>
+#include <cgv/math/fvec.h>
+#include <cgv/math/mfunc.h>
+#include <cgv/media/axis_aligned_box.h>
+#include "sample_grid.h"
+#include "surface_extraction_handler.h"
+
+/// timings and counters of one surface extraction
+struct extraction_statistics
+{
+	/// milliseconds spent in the phases of the extraction
+	double sampling_ms, classification_ms, vertex_ms, decimation_ms, normal_ms, upload_ms;
+	/// milliseconds of the complete extraction without the upload, which happens when drawing
+	double total_ms;
+	/// number of function evaluations
+	unsigned long long nr_evaluations;
+	/// number of samples beyond the narrow band that are evaluated again exactly next to a crossing, which are
+	/// included in the number of evaluations
+	unsigned long long nr_refined_samples;
+	/// number of samples kept from the last extraction instead of evaluating the function
+	unsigned long long nr_reused_samples;
+	/// number of gradient evaluations
+	unsigned long long nr_gradient_evaluations;
+	/// number of cells visited during classification
+	unsigned long long nr_cells;
+	/// number of cells with sign changes at their corners
+	unsigned long long nr_active_cells;
+	/// number of edges collapsed by the decimation
+	unsigned long long nr_collapses;
+	/// maximum number of bytes held in the extraction buffers at the same time
+	unsigned long long peak_memory;
+	/// number of bytes of the packed vertex and index arrays, which are sent to the buffers of the shells
+	unsigned long long packed_bytes;
+	/// construct with zero values
+	extraction_statistics();
+	/// write all values as a json object
+	void write_json(std::ostream& os) const;
+};
+
+/// indexed polygon mesh resulting from a surface extraction, where faces share their vertices
+struct extracted_mesh
+{
+	typedef cgv::math::fvec<double, 3> pnt_type;
+	typedef cgv::math::fvec<double, 3> vec_type;
+	/// position per vertex
+	std::vector<pnt_type> positions;
+	/// normal per vertex
+	std::vector<vec_type> normals;
+	/// vertex index per face corner in face order
+	std::vector<unsigned> corner_vertices;
+	/// number of corners per face
+	std::vector<unsigned> face_sizes;
+	/// remove all faces
+	void clear();
+	/// return the number of triangles after fan triangulation of all faces
+	size_t get_nr_triangles() const;
+	/// write the mesh to an obj file, where faces share vertices with their normals. Chunks of the
+	/// file are formatted on nr_threads threads, where zero selects the hardware concurrency.
+	bool write_obj(std::ostream& os, unsigned nr_threads = 0) const;
+	/// write the mesh to a binary ply file in the byte order of the machine with double precision
+	/// positions and normals
+	bool write_ply(std::ostream& os) const;
+	/// write the fan triangulated mesh to a binary stl file with face normals
+	bool write_stl(std::ostream& os) const;
+	/// write the mesh to a file in the format given by its extension, which is obj, ply or stl
+	bool write(const std::string& file_name, unsigned nr_threads = 0) const;
+};
+
+/** extracts level sets of an implicit function inside a box in separate phases:
+    the function is sampled on a regular grid, cells are classified by the signs at their
+    corners, surface vertices are placed in the cells with sign changes, and normals are
+    computed. Vertices are shared by the faces of the resulting mesh, where marching cubes
+    identifies them by grid edge and the other methods by cell. Marching cubes traces the polygons of each cell across the cell faces, where
+    ambiguous faces are resolved by the sign of their center, such that neighboring cells
+    agree and the result is closed. Dual contouring places one vertex per cell at the
+    minimum of the quadric error of the tangent planes at the edge crossings and connects
+    the four vertices around each edge with a sign change to a quad. Surface nets connects
+    vertices in the same way, but places them cheaply at the mass point of the linearly
+    interpolated edge crossings without further evaluations, optionally followed by a
+    relaxation of each vertex towards its neighbors inside of its cell. Values below the
+    isovalue, which is zero unless several shells are extracted, are inside. */
+class surface_extractor
+{
+public:
+	typedef cgv::math::v3_func<double, double> F;
+	typedef cgv::math::fvec<double, 3> pnt_type;
+	typedef cgv::math::fvec<double, 3> vec_type;
+	typedef cgv::media::axis_aligned_box<double, 3> box_type;
+	/// contouring methods
+	enum contouring_method { MARCHING_CUBES, DUAL_CONTOURING, SURFACE_NETS };
+	/// normal computation methods in the order of the drawable's normal computation type
+	enum normal_method { GRADIENT_NORMALS, FACE_NORMALS, CORNER_NORMALS, CORNER_GRADIENTS };
+	/// function that returns whether the function can differ inside a block from the function sampled by the
+	/// last extraction, where false guarantees equal values. It is called from several threads.
+	typedef std::function<bool(const box_type& block)> change_predicate;
+
+	/// number of samples per axis
+	unsigned res;
+	/// contouring method
+	contouring_method contouring;
+	/// normal computation method
+	normal_method normals;
+	/// cosine of the maximum angle between a face normal and a smoothed corner normal, beyond
+	/// which the face normal is used
+	double normal_threshold;
+	/// dual contouring falls back to the mass point if the quadric error exceeds this threshold
+	/// relative to the squared cell size
+	double consistency_threshold;
+	/// maximum number of regula falsi iterations that refine edge crossings for dual contouring
+	unsigned max_nr_iters;
+	/// refinement of edge crossings stops once the function magnitude is below epsilon
+	double epsilon;
+	/// marching cubes vertices closer to a grid node than this fraction of the cell size are snapped
+	/// to the node, and dual contouring vertices keep this fraction of the cell size from the cell border
+	double grid_epsilon;
+	/// number of relaxation iterations of surface nets, where zero gives naive surface nets
+	unsigned nr_smoothing_iters;
+	/// whether polygons are split into triangles
+	bool triangulate;
+	/// whether the mesh is decimated by quadric error edge collapses before the normals are computed,
+	/// which always results in triangles
+	bool decimate;
+	/// number of triangles the decimation stops at, where zero only applies the error bound
+	unsigned target_nr_triangles;
+	/// maximum quadric error distance of decimated vertices relative to the cell size, where zero
+	/// only applies the target triangle count
+	double max_decimation_error;
+	/// encoding of the stored samples, where all encodings give the same contouring result
+	sample_grid::sample_encoding grid_encoding;
+	/// whether bricks of samples far from the surface are stored as a single value
+	bool sparse_grid;
+	/// half width of the band of values quantized by the integer encodings relative to the largest cell spacing
+	double narrow_band_width;
+	/// whether a function that implements bounded_function is sampled with the narrow band around the
+	/// isovalues, such that samples beyond it can be bounds and csg nodes skip children outside of it.
+	/// Samples next to a crossing are taken exactly, such that the contouring result does not change,
+	/// but samples farther from the isovalues than the narrow band only keep their side of all isovalues.
+	bool bounded_sampling;
+	/// number of threads, where zero selects the hardware concurrency
+	unsigned nr_threads;
+
+	/// construct with default parameters
+	surface_extractor();
+	/// extract the surface of func inside box into mesh and record timings and counters in stats
+	void extract(const F& func, const box_type& box, extracted_mesh& mesh, extraction_statistics& stats);
+	/// extract the level sets of func at the isovalues into one mesh each from a single sampling pass, where
+	/// stats accumulates the timings and counters of all shells. If reuse_samples is set, the samples of the
+	/// last extraction are contoured again if they have been taken inside the same box with the same grid
+	/// parameters and are exact for all isovalues. The caller is responsible for func being unchanged.
+	void extract_shells(const F& func, const box_type& box, const std::vector<double>& isovalues,
+		std::vector<extracted_mesh>& meshes, extraction_statistics& stats, bool reuse_samples = false);
+	/// extract the level sets of func at the isovalues like extract_shells after func changed in parts, as
+	/// between the frames of an animation. If the samples of the last extraction can be reused, only the
+	/// bricks of 8^3 samples for which may_change reports a possible change are evaluated again. Otherwise
+	/// all samples are taken anew.
+	void update_shells(const F& func, const box_type& box, const std::vector<double>& isovalues,
+		const change_predicate& may_change, std::vector<extracted_mesh>& meshes, extraction_statistics& stats);
+	/// write the samples of the last extraction to a vox file with one byte per sample and a .hd
+	/// header file of the same name. As by the volume node, map_to_zero_value is mapped to 0 and
+	/// map_to_one_value to 255, where values beyond are clamped, and the header records both values
+	/// in a "Range" line from which the volume node takes its mapping. Sparse grids give the value
+	/// closest to zero for all samples of a brick far from the surface, and with bounded_sampling the
+	/// samples beyond the narrow band are bounds only.
+	bool write_volume(const std::string& file_name, double map_to_zero_value = 1, double map_to_one_value = -1) const;
+
+protected:
+	/// grid origin and spacing of the current extraction
+	pnt_type origin;
+	vec_type spacing;
+	/// function values at the grid nodes
+	sample_grid grid;
+	/// isovalue of the level set contoured by the current phases
+	double isovalue;
+	/// bytes of the meshes of the shells extracted before the current one
+	size_t shell_bytes;
+	/// linear indices of the cells with sign changes
+	std::vector<size_t> active_cells;
+	/// corner sign mask per active cell, where bit c is set if corner c is inside
+	std::vector<unsigned char> active_cell_masks;
+	/// update the peak memory with the bytes held in the buffers, the mesh and extra temporary buffers
+	void track_memory(extraction_statistics& stats, const extracted_mesh& mesh, size_t extra_bytes = 0) const;
+
+	/// linear index of a grid node
+	size_t node_index(unsigned i, unsigned j, unsigned k) const { return (size_t(k)*res + j)*res + i; }
+	/// linear index of a cell
+	size_t cell_index(unsigned i, unsigned j, unsigned k) const { return (size_t(k)*(res - 1) + j)*(res - 1) + i; }
+	/// location of a grid node
+	pnt_type node_location(unsigned i, unsigned j, unsigned k) const;
+	/// evaluate func at p
+	static double evaluate(const F& func, const pnt_type& p);
+	/// return the interface of func for evaluations with the band [lo,hi] of the current grid or 0 if func is
+	/// sampled exactly
+	const bounded_function* get_bounded_function(const F& func, double& lo, double& hi) const;
+	/// evaluate func at p with the band [lo,hi] if bf is its bounded interface and exactly if bf is 0
+	static double evaluate(const F& func, const bounded_function* bf, const pnt_type& p, double lo, double hi);
+	/// evaluate the gradient of func at p
+	static vec_type evaluate_gradient(const F& func, const pnt_type& p);
+
+	/// return whether the samples of the last extraction can be contoured at the isovalues inside box
+	bool can_reuse_samples(const box_type& box, const std::vector<double>& isovalues) const;
+	/// contour the sampled grid at the level set of the current isovalue, i.e. phases 2 to 4
+	void contour(const F& func, extracted_mesh& mesh, extraction_statistics& stats);
+	/// contour the sampled grid at each of the isovalues into one mesh
+	void contour_shells(const F& func, const std::vector<double>& isovalues, std::vector<extracted_mesh>& meshes, extraction_statistics& stats);
+	/// phase 1: evaluate the function at all grid nodes
+	void sample(const F& func, extraction_statistics& stats);
+	/// phase 1 after a partial change of the function: evaluate it in the bricks for which may_change reports
+	/// a possible change and keep the samples of the last extraction in the others
+	void resample(const F& func, const change_predicate& may_change, extraction_statistics& stats);
+	/// phase 2: compute the corner sign masks and collect the active cells
+	void classify(extraction_statistics& stats);
+	/// phase 3 for marching cubes: trace the polygons of all active cells
+	void place_vertices_marching_cubes(extracted_mesh& mesh, extraction_statistics& stats);
+	/// phase 3 for dual contouring: place one vertex per active cell and connect them to quads
+	void place_vertices_dual_contouring(const F& func, extracted_mesh& mesh, extraction_statistics& stats);
+	/// phase 3 for surface nets: place one vertex per active cell at the mass point of its edge crossings,
+	/// relax the vertices towards their neighbors and connect them to quads
+	void place_vertices_surface_nets(extracted_mesh& mesh, extraction_statistics& stats);
+	/// return the index of an active cell in active_cells
+	size_t find_active_cell(size_t ci) const;
+	/// return the mass point of the linearly interpolated edge crossings of the active cell with index ai
+	pnt_type compute_mass_point(size_t ai) const;
+	/// connect the vertices of the four cells around each interior grid edge with a sign change to a
+	/// quad, where cell_vertices holds one vertex per active cell
+	void connect_cell_vertices(const std::vector<pnt_type>& cell_vertices, extracted_mesh& mesh, extraction_statistics& stats);
+	/// find the crossing on the edge from p0 with value v0 to p1 with value v1, both relative to the isovalue,
+	/// by linear interpolation and regula falsi refinement. The number of evaluations is added to nr_evaluations.
+	pnt_type find_crossing(const F& func, const pnt_type& p0, double v0, const pnt_type& p1, double v1, unsigned long long& nr_evaluations) const;
+	/// optional phase: simplify the mesh by edge collapses
+	void decimate_mesh(extracted_mesh& mesh, extraction_statistics& stats);
+	/// phase 4: compute normals of all vertices, where vertices are split at corners that need the
+	/// face normal instead of the vertex normal
+	void compute_normals(const F& func, extracted_mesh& mesh, extraction_statistics& stats);
+};
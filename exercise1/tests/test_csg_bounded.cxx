@@ -0,0 +1,228 @@
+/** tests of bounded evaluations of csg nodes on operators and distance spheres defined here, such that
+    they do not depend on the csg operators and primitives that are implemented as part of the exercise */
+#include "csg_node.h"
+#include "implicit_primitive.h"
+#include "surface_extractor.h"
+#include "sphere_tracer.h"
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <iostream>
+
+static unsigned nr_failures = 0;
+
+#define CHECK(condition) \
+	if (!(condition)) { \
+		std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " #condition << std::endl; \
+		++nr_failures; \
+	}
+
+/// signed distance to a sphere that counts its evaluations
+struct counted_sphere : public implicit_primitive<double>
+{
+	pnt_type center;
+	double radius;
+	mutable std::atomic<unsigned long long> nr_evaluations;
+	counted_sphere(const pnt_type& _center, double _radius) : center(_center), radius(_radius), nr_evaluations(0) {}
+	double evaluate(const pnt_type& p) const
+	{
+		++nr_evaluations;
+		return (p - center).length() - radius;
+	}
+	vec_type evaluate_gradient(const pnt_type& p) const
+	{
+		vec_type d = p - center;
+		double l = d.length();
+		return l > 0 ? d / l : vec_type(0, 0, 1);
+	}
+	double lipschitz_bound(const box_type& domain) const { return 1; }
+};
+
+/// operator that takes the maximum over its children multiplied with the given signs, which is the union
+/// for (-1,-1), the intersection for (1,1) and the difference for (1,-1)
+struct signed_max : public csg_node<double>
+{
+	double first_sign, other_sign;
+	signed_max(double _first_sign, double _other_sign) : first_sign(_first_sign), other_sign(_other_sign) {}
+	double evaluate(const pnt_type& p) const
+	{
+		unsigned int i;
+		double inf = std::numeric_limits<double>::infinity();
+		return first_sign*evaluate_max(p, i, first_sign, other_sign, -inf, inf);
+	}
+	bool get_child_signs(double& _first_sign, double& _other_sign) const
+	{
+		_first_sign = first_sign;
+		_other_sign = other_sign;
+		return true;
+	}
+	double lipschitz_bound(const box_type& domain) const { return 1; }
+	/// enable or disable short circuiting in this and all descendant operators
+	void set_short_circuit(bool enable)
+	{
+		short_circuit = enable;
+		for (unsigned i = 0; i < get_nr_children(); ++i)
+			if (signed_max* op = dynamic_cast<signed_max*>(get_implicit_child(i)))
+				op->set_short_circuit(enable);
+	}
+};
+
+/// function of the extractor that forwards to a node and supports bounded evaluations
+struct node_function : public cgv::math::v3_func<double, double>, public bounded_function
+{
+	const implicit_base<double>& node;
+	node_function(const implicit_base<double>& _node) : node(_node) {}
+	static implicit_base<double>::pnt_type to_pnt(const pnt_type& p) { return implicit_base<double>::pnt_type(p(0), p(1), p(2)); }
+	double evaluate(const pnt_type& p) const { return node.evaluate(to_pnt(p)); }
+	vec_type evaluate_gradient(const pnt_type& p) const
+	{
+		implicit_base<double>::vec_type g = node.evaluate_gradient(to_pnt(p));
+		return vec_type(g(0), g(1), g(2));
+	}
+	double evaluate_bounded(const pnt_type& p, double lo, double hi) const { return node.evaluate_bounded(to_pnt(p), lo, hi); }
+};
+
+/// a sphere with two spheres cut out of it, where the cut spheres are united and the result is intersected with a slab of two spheres
+struct test_scene
+{
+	std::vector<counted_sphere*> spheres;
+	signed_max* root;
+	/// reference that keeps the nodes alive
+	base_ptr root_ptr;
+	test_scene()
+	{
+		typedef implicit_base<double>::pnt_type pnt_type;
+		root_ptr = root = new signed_max(1, -1);
+		signed_max* cuts = new signed_max(-1, -1);
+		signed_max* slab = new signed_max(1, 1);
+		spheres.push_back(new counted_sphere(pnt_type(0, 0, 0), 0.8));
+		spheres.push_back(new counted_sphere(pnt_type(0.5, 0.2, 0), 0.3));
+		spheres.push_back(new counted_sphere(pnt_type(-0.4, -0.3, 0.2), 0.35));
+		spheres.push_back(new counted_sphere(pnt_type(0, 0, 1.5), 1.9));
+		spheres.push_back(new counted_sphere(pnt_type(0, 0, -1.5), 1.9));
+		slab->append_child(spheres[3]);
+		slab->append_child(spheres[4]);
+		root->append_child(slab);
+		root->append_child(spheres[0]);
+		cuts->append_child(spheres[1]);
+		cuts->append_child(spheres[2]);
+		root->append_child(cuts);
+	}
+	/// return the number of leaf evaluations since the last call
+	unsigned long long take_nr_evaluations()
+	{
+		unsigned long long n = 0;
+		for (counted_sphere* s : spheres)
+			n += s->nr_evaluations.exchange(0);
+		return n;
+	}
+};
+
+/// bounded values are exact inside the band and bound the exact value from the same side beyond it
+static void test_bounded_contract()
+{
+	test_scene s;
+	std::mt19937 rng(7);
+	std::uniform_real_distribution<double> coord(-1.2, 1.2), band(-0.3, 0.3);
+	unsigned nr_violations = 0;
+	for (unsigned n = 0; n < 20000; ++n) {
+		implicit_base<double>::pnt_type p(coord(rng), coord(rng), coord(rng));
+		double lo = band(rng), hi = lo + std::abs(band(rng));
+		double exact = s.root->evaluate(p), v = s.root->evaluate_bounded(p, lo, hi);
+		bool ok = v == exact || (v <= lo && exact <= v) || (v >= hi && exact >= v);
+		if (!ok)
+			++nr_violations;
+	}
+	CHECK(nr_violations == 0);
+}
+
+/// band limited sampling evaluates fewer children and gives the same meshes as exact sampling. The samples next
+/// to a crossing of these distances lie within 3^0.5 cells of the isovalues, such that they are only taken again
+/// with a narrower band.
+static void test_extraction_skips_children(sample_grid::sample_encoding encoding, bool sparse, double narrow_band_width)
+{
+	test_scene s;
+	node_function f(*s.root);
+	surface_extractor extractor;
+	extractor.res = 48;
+	extractor.grid_encoding = encoding;
+	extractor.sparse_grid = sparse;
+	extractor.nr_threads = 2;
+	extractor.narrow_band_width = narrow_band_width;
+	surface_extractor::box_type box(surface_extractor::pnt_type(-1.2, -1.2, -1.2), surface_extractor::pnt_type(1.2, 1.2, 1.2));
+	std::vector<double> isovalues(1, 0.0);
+	isovalues.push_back(0.05);
+	std::vector<extracted_mesh> exact_meshes, bounded_meshes;
+	extraction_statistics stats;
+
+	extractor.bounded_sampling = false;
+	extractor.extract_shells(f, box, isovalues, exact_meshes, stats);
+	s.take_nr_evaluations();
+	extractor.bounded_sampling = true;
+	extractor.extract_shells(f, box, isovalues, bounded_meshes, stats);
+	unsigned long long nr_bounded = s.take_nr_evaluations();
+	CHECK((stats.nr_refined_samples > 0) == (narrow_band_width < 1));
+	// without short circuiting, sampling with the band evaluates all children
+	s.root->set_short_circuit(false);
+	extractor.extract_shells(f, box, isovalues, exact_meshes, stats);
+	unsigned long long nr_exact = s.take_nr_evaluations();
+	CHECK(nr_bounded < nr_exact);
+
+	for (size_t si = 0; si < isovalues.size(); ++si) {
+		CHECK(!exact_meshes[si].positions.empty());
+		CHECK(exact_meshes[si].positions.size() == bounded_meshes[si].positions.size());
+		CHECK(exact_meshes[si].corner_vertices == bounded_meshes[si].corner_vertices);
+		bool same_positions = exact_meshes[si].positions.size() == bounded_meshes[si].positions.size();
+		for (size_t vi = 0; same_positions && vi < exact_meshes[si].positions.size(); ++vi)
+			same_positions = exact_meshes[si].positions[vi] == bounded_meshes[si].positions[vi];
+		CHECK(same_positions);
+	}
+}
+
+/// the tracer hits the same points with and without short circuiting, where the band skips children
+static void test_tracer_hits_unchanged()
+{
+	test_scene s;
+	sphere_tracer tracer;
+	sphere_tracer::box_type domain(sphere_tracer::pnt_type(-1.2, -1.2, -1.2), sphere_tracer::pnt_type(1.2, 1.2, 1.2));
+	std::vector<sphere_tracer::hit_info> hits;
+	std::vector<bool> hit_flags;
+	unsigned long long nr_evaluations[2];
+	for (unsigned pass = 0; pass < 2; ++pass) {
+		s.root->set_short_circuit(pass == 0);
+		s.take_nr_evaluations();
+		for (int y = -10; y <= 10; ++y)
+			for (int x = -10; x <= 10; ++x) {
+				sphere_tracer::hit_info hit;
+				bool is_hit = tracer.trace(*s.root, domain, 1, sphere_tracer::pnt_type(0.1*x, 0.1*y, 3), sphere_tracer::vec_type(0, 0, -1), hit);
+				if (pass == 0) {
+					hits.push_back(hit);
+					hit_flags.push_back(is_hit);
+					continue;
+				}
+				size_t ri = (y + 10) * 21 + x + 10;
+				CHECK(is_hit == hit_flags[ri]);
+				if (is_hit && hit_flags[ri])
+					CHECK(hit.t == hits[ri].t);
+			}
+		nr_evaluations[pass] = s.take_nr_evaluations();
+	}
+	CHECK(nr_evaluations[0] < nr_evaluations[1]);
+}
+
+int main()
+{
+	test_bounded_contract();
+	test_extraction_skips_children(sample_grid::DOUBLE_SAMPLES, false, 4);
+	test_extraction_skips_children(sample_grid::DOUBLE_SAMPLES, false, 0.5);
+	test_extraction_skips_children(sample_grid::INT8_SAMPLES, false, 0.5);
+	test_extraction_skips_children(sample_grid::FLOAT16_SAMPLES, true, 0.5);
+	test_tracer_hits_unchanged();
+	if (nr_failures > 0) {
+		std::cerr << nr_failures << " checks failed" << std::endl;
+		return 1;
+	}
+	std::cout << "all checks passed" << std::endl;
+	return 0;
+}
@@ -0,0 +1,101 @@
+/** tests of the sphere tracer on signed distance nodes defined here, such that they do not depend
+    on the primitives that are implemented as part of the exercise */
+#include "sphere_tracer.h"
+#include "implicit_primitive.h"
+#include <cmath>
+#include <limits>
+#include <iostream>
+
+static unsigned nr_failures = 0;
+
+#define CHECK(condition) \
+	if (!(condition)) { \
+		std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " #condition << std::endl; \
+		++nr_failures; \
+	}
+
+/// signed distance to a sphere of the given radius around the origin, which is 1-Lipschitz
+struct distance_sphere : public implicit_primitive<double>
+{
+	double radius;
+	/// whether lipschitz_bound reports the bound or no finite bound
+	bool has_bound;
+	distance_sphere(double _radius, bool _has_bound = true) : radius(_radius), has_bound(_has_bound) {}
+	double evaluate(const pnt_type& p) const { return std::sqrt(p(0)*p(0) + p(1)*p(1) + p(2)*p(2)) - radius; }
+	vec_type evaluate_gradient(const pnt_type& p) const
+	{
+		double l = std::sqrt(p(0)*p(0) + p(1)*p(1) + p(2)*p(2));
+		return l > 0 ? vec_type(p(0) / l, p(1) / l, p(2) / l) : vec_type(0, 0, 1);
+	}
+	double lipschitz_bound(const box_type& domain) const { return has_bound ? 1 : std::numeric_limits<double>::infinity(); }
+};
+
+/// rays towards the center hit the sphere at its radius with the outward normal
+static void test_trace_hits_sphere(bool has_bound)
+{
+	distance_sphere sphere(0.5, has_bound);
+	sphere_tracer tracer;
+	sphere_tracer::box_type domain(sphere_tracer::pnt_type(-1, -1, -1), sphere_tracer::pnt_type(1, 1, 1));
+	sphere_tracer::hit_info hit;
+	CHECK(tracer.trace(sphere, domain, sphere.lipschitz_bound(domain), sphere_tracer::pnt_type(0, 0, 3), sphere_tracer::vec_type(0, 0, -1), hit));
+	CHECK(std::abs(hit.t - 2.5) < 1e-3);
+	CHECK(std::abs(hit.n(2) - 1) < 1e-3);
+	// a ray that passes the sphere misses it
+	CHECK(!tracer.trace(sphere, domain, sphere.lipschitz_bound(domain), sphere_tracer::pnt_type(0.8, 0, 3), sphere_tracer::vec_type(0, 0, -1), hit));
+	// a ray that misses the domain does not evaluate the function at all
+	CHECK(!tracer.trace(sphere, domain, sphere.lipschitz_bound(domain), sphere_tracer::pnt_type(3, 3, 3), sphere_tracer::vec_type(0, 0, -1), hit));
+}
+
+/// steps of a finite bound approach the surface in fewer steps than uniform steps
+static void test_bound_reduces_steps()
+{
+	distance_sphere bounded(0.5, true), unbounded(0.5, false);
+	sphere_tracer tracer;
+	sphere_tracer::box_type domain(sphere_tracer::pnt_type(-1, -1, -1), sphere_tracer::pnt_type(1, 1, 1));
+	sphere_tracer::hit_info hit_bounded, hit_unbounded;
+	CHECK(tracer.trace(bounded, domain, 1, sphere_tracer::pnt_type(0.1, 0, 3), sphere_tracer::vec_type(0, 0, -1), hit_bounded));
+	CHECK(tracer.trace(unbounded, domain, std::numeric_limits<double>::infinity(), sphere_tracer::pnt_type(0.1, 0, 3), sphere_tracer::vec_type(0, 0, -1), hit_unbounded));
+	CHECK(std::abs(hit_bounded.t - hit_unbounded.t) < 1e-3);
+	CHECK(hit_bounded.nr_steps < hit_unbounded.nr_steps);
+}
+
+/// the rendered silhouette of the sphere covers the expected fraction of the image
+static void test_render_silhouette()
+{
+	distance_sphere sphere(0.5);
+	sphere_tracer tracer;
+	tracer.nr_threads = 2;
+	sphere_tracer::box_type domain(sphere_tracer::pnt_type(-1, -1, -1), sphere_tracer::pnt_type(1, 1, 1));
+	sphere_tracer::camera cam;
+	sphere_tracer::image img;
+	const unsigned size = 64;
+	CHECK(tracer.render(sphere, domain, cam, size, size, img));
+	CHECK(img.depths.size() == size*size);
+	unsigned nr_hits = 0;
+	for (size_t i = 0; i < img.depths.size(); ++i)
+		if (img.depths[i] < std::numeric_limits<float>::infinity())
+			++nr_hits;
+	// the silhouette seen from distance 5 has a radius of tan(asin(0.5/5)) relative to the distance
+	const double pi = 3.14159265358979;
+	double r = size / 2 * std::tan(std::asin(0.1)) / std::tan(22.5 * pi / 180);
+	double expected = pi * r * r;
+	CHECK(std::abs(nr_hits - expected) < 0.1 * expected);
+	// the center pixel sees the front of the sphere
+	CHECK(std::abs(img.depths[size / 2 * size + size / 2] - 4.5) < 0.01);
+	// rendering stops if the function becomes stale
+	CHECK(!tracer.render(sphere, domain, cam, size, size, img, []() { return true; }));
+}
+
+int main()
+{
+	test_trace_hits_sphere(true);
+	test_trace_hits_sphere(false);
+	test_bound_reduces_steps();
+	test_render_silhouette();
+	if (nr_failures > 0) {
+		std::cerr << nr_failures << " checks failed" << std::endl;
+		return 1;
+	}
+	std::cout << "all checks passed" << std::endl;
+	return 0;
+}
@@ -1,20 +1,61 @@
 #include "implicit_group.h"
 
+#include <cmath>
+#include <algorithm>
+
 #include <cgv/math/ftransform.h>
 #include <cgv/media/illum/surface_material.h>
 #include <cgv/render/shader_program.h>
-#include <cgv_gl/gl/gl.h>
 
 template <typename T>
 struct transformation : public implicit_group<T>
 {
 	typedef typename implicit_base<T>::vec_type vec_type;
 	typedef typename implicit_base<T>::pnt_type pnt_type;
+	typedef typename implicit_base<T>::box_type box_type;
 
 	bool show_axes;
 
 	transformation() : show_axes(false) { implicit_base<T>::gui_color = 0x88FF88; }
 
+	/// map a point to the coordinate system of the child
+	virtual pnt_type map_to_child(const pnt_type& p) const { return p; }
+	/// factor by which the transformation can stretch gradient lengths of the child
+	virtual T get_lipschitz_factor() const { return 1; }
+	/// the value is the value of the child at the mapped point, such that the band applies to the child
+	T evaluate_bounded(const pnt_type& p, T lo, T hi) const
+	{
+		if (group::get_nr_children() == 0)
+			return 1;
+		return implicit_group<T>::get_implicit_child(0)->evaluate_bounded(map_to_child(p), lo, hi);
+	}
+	/// descend into the child at the mapped location
+	implicit_base<T>* find_determining_leaf(const pnt_type& p)
+	{
+		if (group::get_nr_children() == 0)
+			return this;
+		return implicit_group<T>::get_implicit_child(0)->find_determining_leaf(map_to_child(p));
+	}
+	/// the child is evaluated at mapped points, whose affine map takes the domain into the bounding box of
+	/// the mapped domain corners
+	bool get_child_domain(const box_type& domain, box_type& child_domain) const
+	{
+		if (group::get_nr_children() == 0)
+			return false;
+		child_domain.invalidate();
+		for (int i = 0; i < 8; ++i)
+			child_domain.add_point(map_to_child(domain.get_corner(i)));
+		return true;
+	}
+	/// bound the child over the bounding box of the mapped domain corners
+	T lipschitz_bound(const box_type& domain) const
+	{
+		box_type child_domain;
+		if (!get_child_domain(domain, child_domain))
+			return 0;
+		return get_lipschitz_factor() * implicit_group<T>::get_implicit_child(0)->lipschitz_bound(child_domain);
+	}
+
 	void on_set(void* member_ptr)
 	{
 		if (member_ptr == &show_axes) {
@@ -105,7 +146,11 @@ struct rotation : public transformation<T>
 		vec_type a = dot(p,axis)*axis;
 		vec_type x = p-a;
 		vec_type y = cross(axis,x);
-		return a+cos(ang)*x+sin(ang)*y;
+		return a+T(cos(ang))*x+T(sin(ang))*y;
+	}
+	pnt_type map_to_child(const pnt_type& p) const
+	{
+		return rotate(p, angle*(-.1745329252e-1));
 	}
 	T evaluate(const pnt_type& p) const {
 		if (group::get_nr_children() == 0)
@@ -155,6 +200,10 @@ struct translation : public transformation<T>
 			rh.reflect_member("dz", delta(2)) &&
 			transformation<T>::self_reflect(rh);
 	}
+	pnt_type map_to_child(const pnt_type& p) const
+	{
+		return p-delta;
+	}
 	T evaluate(const pnt_type& p) const {
 		if (group::get_nr_children() == 0)
 			return 1;
@@ -213,6 +262,14 @@ struct scaling : public transformation<T>
 		}
 		transformation<T>::on_set(member_ptr);
 	}
+	pnt_type map_to_child(const pnt_type& p) const
+	{
+		return pnt_type(p(0)*inv_scale(0),p(1)*inv_scale(1),p(2)*inv_scale(2));
+	}
+	T get_lipschitz_factor() const
+	{
+		return std::max(std::abs(inv_scale(0)), std::max(std::abs(inv_scale(1)), std::abs(inv_scale(2))));
+	}
 	/// apply inverse transformation to the point before evaluation of child
 	T evaluate(const pnt_type& p) const {
 		if (group::get_nr_children() == 0)
@@ -273,17 +330,25 @@ struct uniform_scaling : public transformation<T>
 		}
 		transformation<T>::on_set(member_ptr);
 	}
+	pnt_type map_to_child(const pnt_type& p) const
+	{
+		return T(inv_scale)*p;
+	}
+	T get_lipschitz_factor() const
+	{
+		return std::abs(inv_scale);
+	}
 	/// apply inverse transformation to the point before evaluation of child
 	T evaluate(const pnt_type& p) const {
 		if (group::get_nr_children() == 0)
 			return 1;
-		return implicit_group<T>::get_implicit_child(0)->evaluate(inv_scale*p);
+		return implicit_group<T>::get_implicit_child(0)->evaluate(T(inv_scale)*p);
 	}
 	/// 
 	vec_type evaluate_gradient(const pnt_type& p) const {
 		if (group::get_nr_children() == 0)
 			return vec_type(0,0,0);
-		return inv_scale * (implicit_group<T>::get_implicit_child(0)->evaluate_gradient(inv_scale*p));
+		return T(inv_scale) * (implicit_group<T>::get_implicit_child(0)->evaluate_gradient(T(inv_scale)*p));
 	}
 	void create_gui()
 	{
@@ -321,6 +386,15 @@ struct shear : public transformation<T>
 			rh.reflect_member("h_yz", h_yz) &&
 			transformation<T>::self_reflect(rh);
 	}
+	pnt_type map_to_child(const pnt_type& p) const
+	{
+		return pnt_type(p(0)-h_xy*p(1)-h_xz*p(2),p(1)-h_yz*p(2), p(2));
+	}
+	/// frobenius norm of the inverse shear matrix bounds its spectral norm
+	T get_lipschitz_factor() const
+	{
+		return sqrt(3 + h_xy*h_xy + h_xz*h_xz + h_yz*h_yz);
+	}
 	/// apply inverse transformation to the point before evaluation of child
 	T evaluate(const pnt_type& p) const {
 		if (group::get_nr_children() == 0)
@@ -347,7 +421,7 @@ struct shear : public transformation<T>
 	void draw(context& ctx)
 	{
 		ctx.push_modelview_matrix();
-		GLdouble M[16] = {
+		double M[16] = {
 			1, h_xy, h_xz, 0,
 			0,    1, h_yz, 0,
 			0,    1,    1, 0,
@@ -0,0 +1,247 @@
+#include "triangle_bvh.h"
+#include <algorithm>
+#include <limits>
+#include <cmath>
+
+triangle_bvh::triangle_bvh() : max_leaf_size(4), beta(2)
+{
+}
+
+/// build from vertex positions and three vertex indices per triangle
+void triangle_bvh::build(const std::vector<pnt_type>& positions, const std::vector<unsigned>& triangle_vertex_indices)
+{
+	size_t n = triangle_vertex_indices.size() / 3;
+	corners.resize(3 * n);
+	triangle_indices.resize(n);
+	std::vector<pnt_type> centroids(n);
+	for (size_t ti = 0; ti < n; ++ti) {
+		for (unsigned c = 0; c < 3; ++c)
+			corners[3 * ti + c] = positions[triangle_vertex_indices[3 * ti + c]];
+		centroids[ti] = (1.0 / 3) * (corners[3 * ti] + corners[3 * ti + 1] + corners[3 * ti + 2]);
+		triangle_indices[ti] = ti;
+	}
+	nodes.clear();
+	if (n == 0)
+		return;
+	nodes.reserve(2 * n / max_leaf_size + 1);
+	nodes.push_back(node());
+	build_node(0, 0, unsigned(n), centroids);
+}
+
+/// recursively build the subtree of node ni over the triangle range [first,first+count)
+void triangle_bvh::build_node(unsigned ni, unsigned first, unsigned count, std::vector<pnt_type>& centroids)
+{
+	box_type box, centroid_box;
+	box.invalidate();
+	centroid_box.invalidate();
+	for (unsigned ti = first; ti < first + count; ++ti) {
+		for (unsigned c = 0; c < 3; ++c)
+			box.add_point(corners[3 * ti + c]);
+		centroid_box.add_point(centroids[ti]);
+	}
+	nodes[ni].box = box;
+	if (count <= max_leaf_size) {
+		nodes[ni].first = first;
+		nodes[ni].count = count;
+		compute_dipole(ni);
+		return;
+	}
+	// split at the median centroid along the axis of largest centroid extent
+	vec_type extent = centroid_box.get_extent();
+	unsigned axis = extent(1) > extent(0) ? 1 : 0;
+	if (extent(2) > extent(axis))
+		axis = 2;
+	std::vector<unsigned> order(count);
+	for (unsigned i = 0; i < count; ++i)
+		order[i] = first + i;
+	unsigned half = count / 2;
+	std::nth_element(order.begin(), order.begin() + half, order.end(),
+		[&centroids, axis](unsigned i, unsigned j) { return centroids[i](axis) < centroids[j](axis); });
+	// apply permutation to corners, centroids and triangle indices
+	std::vector<pnt_type> tmp_corners(3 * count), tmp_centroids(count);
+	std::vector<size_t> tmp_indices(count);
+	for (unsigned i = 0; i < count; ++i) {
+		for (unsigned c = 0; c < 3; ++c)
+			tmp_corners[3 * i + c] = corners[3 * order[i] + c];
+		tmp_centroids[i] = centroids[order[i]];
+		tmp_indices[i] = triangle_indices[order[i]];
+	}
+	std::copy(tmp_corners.begin(), tmp_corners.end(), corners.begin() + 3 * size_t(first));
+	std::copy(tmp_centroids.begin(), tmp_centroids.end(), centroids.begin() + first);
+	std::copy(tmp_indices.begin(), tmp_indices.end(), triangle_indices.begin() + first);
+
+	unsigned ci = unsigned(nodes.size());
+	nodes[ni].first = ci;
+	nodes[ni].count = 0;
+	nodes.push_back(node());
+	nodes.push_back(node());
+	build_node(ci, first, half, centroids);
+	build_node(ci + 1, first + half, count - half, centroids);
+	compute_dipole(ni);
+}
+
+/// compute dipole, center and radius of node ni from its triangles or children
+void triangle_bvh::compute_dipole(unsigned ni)
+{
+	node& nd = nodes[ni];
+	nd.area_normal = vec_type(0, 0, 0);
+	pnt_type weighted_center(0, 0, 0);
+	double area_sum = 0;
+	if (nd.count > 0) {
+		for (unsigned ti = nd.first; ti < nd.first + nd.count; ++ti) {
+			const pnt_type* c = &corners[3 * size_t(ti)];
+			vec_type an = 0.5 * cross(c[1] - c[0], c[2] - c[0]);
+			double area = an.length();
+			nd.area_normal += an;
+			weighted_center += (area / 3) * (c[0] + c[1] + c[2]);
+			area_sum += area;
+		}
+	}
+	else {
+		for (unsigned k = 0; k < 2; ++k) {
+			const node& child = nodes[nd.first + k];
+			nd.area_normal += child.area_normal;
+			weighted_center += child.area * child.center;
+			area_sum += child.area;
+		}
+	}
+	nd.area = area_sum;
+	nd.center = area_sum > 0 ? (1.0 / area_sum) * weighted_center : nd.box.get_center();
+	// the ball around center must contain the node's bounding box
+	nd.radius = 0;
+	for (int i = 0; i < 8; ++i)
+		nd.radius = std::max(nd.radius, (nd.box.get_corner(i) - nd.center).length());
+}
+
+/// return bounding box of all triangles
+triangle_bvh::box_type triangle_bvh::get_box() const
+{
+	if (nodes.empty()) {
+		box_type box;
+		box.invalidate();
+		return box;
+	}
+	return nodes[0].box;
+}
+
+/// closest point to p on triangle abc following Ericson, Real-Time Collision Detection
+triangle_bvh::pnt_type triangle_bvh::closest_point_on_triangle(const pnt_type& p, const pnt_type& a, const pnt_type& b, const pnt_type& c)
+{
+	vec_type ab = b - a, ac = c - a, ap = p - a;
+	double d1 = dot(ab, ap), d2 = dot(ac, ap);
+	if (d1 <= 0 && d2 <= 0)
+		return a;
+	vec_type bp = p - b;
+	double d3 = dot(ab, bp), d4 = dot(ac, bp);
+	if (d3 >= 0 && d4 <= d3)
+		return b;
+	double vc = d1*d4 - d3*d2;
+	if (vc <= 0 && d1 >= 0 && d3 <= 0)
+		return a + (d1 / (d1 - d3)) * ab;
+	vec_type cp = p - c;
+	double d5 = dot(ab, cp), d6 = dot(ac, cp);
+	if (d6 >= 0 && d5 <= d6)
+		return c;
+	double vb = d5*d2 - d1*d6;
+	if (vb <= 0 && d2 >= 0 && d6 <= 0)
+		return a + (d2 / (d2 - d6)) * ac;
+	double va = d3*d6 - d5*d4;
+	if (va <= 0 && (d4 - d3) >= 0 && (d5 - d6) >= 0)
+		return b + ((d4 - d3) / ((d4 - d3) + (d5 - d6))) * (c - b);
+	double denom = 1 / (va + vb + vc);
+	return a + (vb*denom) * ab + (vc*denom) * ac;
+}
+
+/// squared distance from p to box, zero inside
+static double sqr_distance_to_box(const triangle_bvh::pnt_type& p, const triangle_bvh::box_type& box)
+{
+	double d = 0;
+	for (unsigned c = 0; c < 3; ++c) {
+		double e = std::max(std::max(box.get_min_pnt()(c) - p(c), p(c) - box.get_max_pnt()(c)), 0.0);
+		d += e*e;
+	}
+	return d;
+}
+
+/// find closest point on the mesh, returns false for an empty mesh
+bool triangle_bvh::find_closest_point(const pnt_type& p, closest_point_info& info) const
+{
+	if (nodes.empty())
+		return false;
+	info.sqr_distance = std::numeric_limits<double>::infinity();
+	unsigned stack[64];
+	unsigned stack_size = 0;
+	stack[stack_size++] = 0;
+	while (stack_size > 0) {
+		const node& nd = nodes[stack[--stack_size]];
+		if (sqr_distance_to_box(p, nd.box) >= info.sqr_distance)
+			continue;
+		if (nd.count > 0) {
+			for (unsigned ti = nd.first; ti < nd.first + nd.count; ++ti) {
+				const pnt_type* c = &corners[3 * size_t(ti)];
+				pnt_type q = closest_point_on_triangle(p, c[0], c[1], c[2]);
+				double d = (q - p).sqr_length();
+				if (d < info.sqr_distance) {
+					info.sqr_distance = d;
+					info.p = q;
+					info.triangle_index = triangle_indices[ti];
+				}
+			}
+			continue;
+		}
+		// push farther child first such that the closer one is visited next
+		double d0 = sqr_distance_to_box(p, nodes[nd.first].box);
+		double d1 = sqr_distance_to_box(p, nodes[nd.first + 1].box);
+		if (d0 < d1) {
+			stack[stack_size++] = nd.first + 1;
+			stack[stack_size++] = nd.first;
+		}
+		else {
+			stack[stack_size++] = nd.first;
+			stack[stack_size++] = nd.first + 1;
+		}
+	}
+	return true;
+}
+
+/// signed solid angle of triangle abc seen from p after Van Oosterom and Strackee
+double triangle_bvh::solid_angle(const pnt_type& p, const pnt_type& a, const pnt_type& b, const pnt_type& c)
+{
+	vec_type va = a - p, vb = b - p, vc = c - p;
+	double la = va.length(), lb = vb.length(), lc = vc.length();
+	double numerator = dot(va, cross(vb, vc));
+	double denominator = la*lb*lc + dot(va, vb)*lc + dot(vb, vc)*la + dot(vc, va)*lb;
+	return 2 * atan2(numerator, denominator);
+}
+
+/// evaluate the generalized winding number, which is close to one inside of closed meshes
+double triangle_bvh::winding_number(const pnt_type& p) const
+{
+	if (nodes.empty())
+		return 0;
+	const double inv_4_pi = 0.25 / 3.14159265358979323846;
+	double w = 0;
+	unsigned stack[64];
+	unsigned stack_size = 0;
+	stack[stack_size++] = 0;
+	while (stack_size > 0) {
+		const node& nd = nodes[stack[--stack_size]];
+		vec_type d = nd.center - p;
+		double l = d.length();
+		if (l > beta * nd.radius) {
+			// far field dipole approximation of the solid angle
+			w += dot(d, nd.area_normal) / (l*l*l);
+			continue;
+		}
+		if (nd.count > 0) {
+			for (unsigned ti = nd.first; ti < nd.first + nd.count; ++ti) {
+				const pnt_type* c = &corners[3 * size_t(ti)];
+				w += solid_angle(p, c[0], c[1], c[2]);
+			}
+			continue;
+		}
+		stack[stack_size++] = nd.first;
+		stack[stack_size++] = nd.first + 1;
+	}
+	return w * inv_4_pi;
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <vector>
+#include <cgv/math/fvec.h>
+#include <cgv/media/axis_aligned_box.h>
+
+/** bounding volume hierarchy over the triangles of a mesh that answers closest point
+    queries and evaluates generalized winding numbers. For the latter each node stores the
+    dipole of its triangles, such that far away subtrees are approximated by a single term
+    as proposed in "Fast Winding Numbers for Soups and Clouds" by Barill et al. */
+class triangle_bvh
+{
+public:
+	typedef cgv::dvec3 pnt_type;
+	typedef cgv::dvec3 vec_type;
+	typedef cgv::media::axis_aligned_box<double, 3> box_type;
+
+	/// result of a closest point query
+	struct closest_point_info
+	{
+		/// closest point on the mesh
+		pnt_type p;
+		/// squared distance between query point and closest point
+		double sqr_distance;
+		/// index of the triangle containing the closest point in the original order
+		size_t triangle_index;
+	};
+
+protected:
+	/// node of the hierarchy with either two children or a range of triangles
+	struct node
+	{
+		/// bounding box of the node's triangles
+		box_type box;
+		/// index of first child for inner nodes, first triangle for leaves
+		unsigned first;
+		/// number of triangles for leaves, zero for inner nodes
+		unsigned count;
+		/// area weighted sum of triangle normals, i.e. the dipole moment
+		vec_type area_normal;
+		/// total area of the triangles
+		double area;
+		/// area weighted centroid of the triangles
+		pnt_type center;
+		/// radius of the ball around center that contains all triangles
+		double radius;
+	};
+	/// triangle corners in bvh order, three per triangle
+	std::vector<pnt_type> corners;
+	/// original index of the triangles in bvh order
+	std::vector<size_t> triangle_indices;
+	/// nodes with the root at index zero and siblings stored consecutively
+	std::vector<node> nodes;
+	/// maximum number of triangles in a leaf
+	unsigned max_leaf_size;
+
+	/// recursively build the subtree of node ni over the triangle range [first,first+count)
+	void build_node(unsigned ni, unsigned first, unsigned count, std::vector<pnt_type>& centroids);
+	/// compute dipole, center and radius of node ni from its triangles or children
+	void compute_dipole(unsigned ni);
+
+public:
+	/// ratio between distance and node radius beyond which the dipole approximation is used
+	double beta;
+	/// construct empty hierarchy
+	triangle_bvh();
+	/// build from vertex positions and three vertex indices per triangle
+	void build(const std::vector<pnt_type>& positions, const std::vector<unsigned>& triangle_vertex_indices);
+	/// return number of triangles
+	size_t get_nr_triangles() const { return triangle_indices.size(); }
+	/// return bounding box of all triangles
+	box_type get_box() const;
+	/// find closest point on the mesh, returns false for an empty mesh
+	bool find_closest_point(const pnt_type& p, closest_point_info& info) const;
+	/// evaluate the generalized winding number, which is close to one inside of closed meshes
+	double winding_number(const pnt_type& p) const;
+	/// closest point to p on triangle abc
+	static pnt_type closest_point_on_triangle(const pnt_type& p, const pnt_type& a, const pnt_type& b, const pnt_type& c);
+	/// signed solid angle of triangle abc seen from p
+	static double solid_angle(const pnt_type& p, const pnt_type& a, const pnt_type& b, const pnt_type& c);
+};
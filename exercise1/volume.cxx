@@ -0,0 +1,250 @@
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <algorithm>
+#include <memory>
+#include <cstring>
+#include <cstdint>
+#include <cgv/math/fvec.h>
+#include <cgv/utils/file.h>
+#include "implicit_primitive.h"
+#include "mapped_file.h"
+
+/** sampled function read from a vox file as written by the volume export, with the voxel
+    counts and the extent of the volume in a .hd header file of the same name. Voxels are
+    stored slice by slice with x varying fastest as 8 or 16 bit unsigned integers, which
+    are mapped back to function values by the inverse of the export mapping, or as 32 bit
+    floats holding the function values themselves. If the header gives the mapped values in a
+    "Range: zero, one" line, they replace map_to_zero_value and map_to_one_value. The volume is centered at the origin
+    and memory mapped, such that the operating system only pages in the voxels that are
+    evaluated. Values are interpolated trilinearly and outside of the volume the distance
+    to it is added to the value at the closest voxel. */
+template <typename T>
+struct volume : public implicit_primitive<T>
+{
+	typedef typename implicit_base<T>::vec_type vec_type;
+	typedef typename implicit_base<T>::pnt_type pnt_type;
+	typedef typename implicit_base<T>::box_type box_type;
+
+	/// vox file containing the voxels
+	std::string file_name;
+	/// function values that the export mapped to the smallest and the largest integer voxel value
+	double map_to_zero_value, map_to_one_value;
+	/// mapping of the vox file, which is shared with the copies in evaluation snapshots
+	std::shared_ptr<const mapped_file> voxels;
+	/// number of voxels per axis
+	unsigned size[3];
+	/// extent of the volume
+	vec_type extent;
+	/// number of bytes per voxel, which is 1, 2 or 4
+	unsigned bytes_per_voxel;
+	/// whether file_name has been set since the last load
+	bool reload_requested;
+	/// file name of the currently mapped volume
+	std::string loaded_file_name;
+
+	volume() : map_to_zero_value(1), map_to_one_value(-1), voxels(new mapped_file()), extent(2, 2, 2), bytes_per_voxel(1), reload_requested(false)
+	{
+		size[0] = size[1] = size[2] = 0;
+		implicit_base<T>::gui_color = 0xBBBB88;
+	}
+	std::string get_type_name() const { return "volume"; }
+
+	/// read voxel counts and extent from the lines "Size: nx, ny, nz" and "Spacing: ex, ey, ez" of a .hd file
+	/// and the values mapped to the smallest and largest integer voxel from an optional line "Range: zero, one"
+	static bool read_header(const std::string& fn, unsigned size[3], vec_type& extent, double range[2], bool& has_range)
+	{
+		std::ifstream is(fn.c_str());
+		if (is.fail())
+			return false;
+		bool has_size = false, has_extent = false;
+		has_range = false;
+		std::string line;
+		while (std::getline(is, line)) {
+			size_t colon = line.find(':');
+			if (colon == std::string::npos)
+				continue;
+			std::string key = line.substr(0, colon);
+			std::replace(line.begin(), line.end(), ',', ' ');
+			std::istringstream ls(line.substr(colon + 1));
+			if (key == "Size")
+				has_size = !(ls >> size[0] >> size[1] >> size[2]).fail();
+			else if (key == "Spacing")
+				has_extent = !(ls >> extent(0) >> extent(1) >> extent(2)).fail();
+			else if (key == "Range")
+				has_range = !(ls >> range[0] >> range[1]).fail() && range[0] != range[1];
+		}
+		return has_size && has_extent;
+	}
+	/// map file_name and read its header, where the voxel type follows from the file size
+	void load_volume()
+	{
+		loaded_file_name = file_name;
+		reload_requested = false;
+		std::shared_ptr<mapped_file> new_voxels(new mapped_file());
+		unsigned new_size[3] = { 0, 0, 0 };
+		vec_type new_extent = extent;
+		if (!file_name.empty()) {
+			std::string hd_file_name = cgv::utils::file::drop_extension(file_name) + ".hd";
+			size_t nr_voxels = 0;
+			double range[2];
+			bool has_range;
+			if (!read_header(hd_file_name, new_size, new_extent, range, has_range))
+				std::cerr << "volume: could not read header " << hd_file_name << std::endl;
+			else if (std::min(new_size[0], std::min(new_size[1], new_size[2])) < 2)
+				std::cerr << "volume: " << hd_file_name << " needs at least two voxels per axis" << std::endl;
+			else if (!new_voxels->open(file_name))
+				std::cerr << "volume: could not map " << file_name << std::endl;
+			else {
+				if (has_range) {
+					map_to_zero_value = range[0];
+					map_to_one_value = range[1];
+					provider::update_member(&map_to_zero_value);
+					provider::update_member(&map_to_one_value);
+				}
+				nr_voxels = size_t(new_size[0])*new_size[1]*new_size[2];
+				size_t bytes = new_voxels->get_size() / nr_voxels;
+				if (new_voxels->get_size() % nr_voxels != 0 || (bytes != 1 && bytes != 2 && bytes != 4)) {
+					std::cerr << "volume: size of " << file_name << " does not match 8, 16 or 32 bit voxels" << std::endl;
+					new_voxels->close();
+				}
+				else
+					bytes_per_voxel = unsigned(bytes);
+			}
+			if (!new_voxels->is_open())
+				new_size[0] = new_size[1] = new_size[2] = 0;
+		}
+		voxels = new_voxels;
+		std::copy(new_size, new_size + 3, size);
+		extent = new_extent;
+		for (unsigned c = 0; c < 3; ++c)
+			provider::update_member(&size[c]);
+	}
+	/// remap the volume when the file name has been set
+	void prepare_node_evaluation()
+	{
+		if (reload_requested || file_name != loaded_file_name)
+			load_volume();
+	}
+	/// mapping is deferred to prepare_node_evaluation, which the scene update triggers
+	void on_set(void* member_ptr)
+	{
+		if (member_ptr == &file_name)
+			reload_requested = true;
+		implicit_primitive<T>::on_set(member_ptr);
+	}
+	/// share the mapping with a node of either precision instead of mapping the file again
+	template <typename S>
+	void share_mapping(const implicit_base<S>& source)
+	{
+		const volume<S>* src = dynamic_cast<const volume<S>*>(&source);
+		if (!src || src->file_name != file_name || src->reload_requested)
+			return;
+		voxels = src->voxels;
+		std::copy(src->size, src->size + 3, size);
+		extent = vec_type(src->extent);
+		bytes_per_voxel = src->bytes_per_voxel;
+		map_to_zero_value = src->map_to_zero_value;
+		map_to_one_value = src->map_to_one_value;
+		loaded_file_name = src->loaded_file_name;
+		reload_requested = false;
+	}
+	/// share the mapping with the node this one has been copied from instead of mapping the file again
+	void share_evaluation_data(const implicit_base<T>& source)
+	{
+		share_mapping(source);
+	}
+	/// voxels do not depend on the precision, such that single precision copies share the mapping as well
+	void share_double_evaluation_data(const implicit_base<double>& source)
+	{
+		share_mapping(source);
+	}
+	bool self_reflect(cgv::reflect::reflection_handler& rh)
+	{
+		return
+			rh.reflect_member("file_name", file_name) &&
+			rh.reflect_member("map_to_zero_value", map_to_zero_value) &&
+			rh.reflect_member("map_to_one_value", map_to_one_value) &&
+			implicit_primitive<T>::self_reflect(rh);
+	}
+
+	/// function value of the voxel with the given indices
+	T get_voxel(size_t i, size_t j, size_t k) const
+	{
+		size_t offset = bytes_per_voxel*((k*size[1] + j)*size[0] + i);
+		const char* ptr = voxels->get_data() + offset;
+		switch (bytes_per_voxel) {
+		case 1:
+			return T(map_to_zero_value + (map_to_one_value - map_to_zero_value)*(unsigned char)*ptr / 255.0);
+		case 2: {
+			uint16_t v;
+			std::memcpy(&v, ptr, sizeof(v));
+			return T(map_to_zero_value + (map_to_one_value - map_to_zero_value)*v / 65535.0);
+		}
+		default: {
+			float v;
+			std::memcpy(&v, ptr, sizeof(v));
+			return T(v);
+		}
+		}
+	}
+	/// trilinear interpolation of the voxels, where points outside add their distance to the volume
+	T evaluate(const pnt_type& p) const
+	{
+		if (!voxels->is_open())
+			return 1;
+		size_t i[3];
+		T f[3], outside_sqr_distance = 0;
+		for (unsigned c = 0; c < 3; ++c) {
+			T x = (p(c) / T(extent(c)) + T(0.5))*(size[c] - 1);
+			T x_clamped = std::max(T(0), std::min(T(size[c] - 1), x));
+			T d = (x - x_clamped)*T(extent(c)) / (size[c] - 1);
+			outside_sqr_distance += d*d;
+			i[c] = std::min(size_t(x_clamped), size_t(size[c] - 2));
+			f[c] = x_clamped - i[c];
+		}
+		T v = 0;
+		for (unsigned corner = 0; corner < 8; ++corner) {
+			size_t di = corner & 1, dj = (corner >> 1) & 1, dk = corner >> 2;
+			T w = (di ? f[0] : 1 - f[0])*(dj ? f[1] : 1 - f[1])*(dk ? f[2] : 1 - f[2]);
+			if (w != 0)
+				v += w*get_voxel(i[0] + di, i[1] + dj, i[2] + dk);
+		}
+		return v + std::sqrt(outside_sqr_distance);
+	}
+	/// central differences with a step of one voxel
+	vec_type evaluate_gradient(const pnt_type& p) const
+	{
+		vec_type g(0, 0, 0);
+		if (!voxels->is_open())
+			return g;
+		for (unsigned c = 0; c < 3; ++c) {
+			T h = T(extent(c)) / (size[c] - 1);
+			pnt_type q = p;
+			q(c) = p(c) + h;
+			T v1 = evaluate(q);
+			q(c) = p(c) - h;
+			g(c) = (v1 - evaluate(q)) / (2 * h);
+		}
+		return g;
+	}
+	/// eight voxel lookups, which may page in parts of the file
+	double estimate_cost() const
+	{
+		return 2;
+	}
+
+	void create_gui()
+	{
+		implicit_primitive<T>::create_gui();
+		provider::add_member_control(this, "file_name", file_name);
+		provider::add_member_control(this, "map_to_zero_value", map_to_zero_value, "value_slider", "min=-10;max=10;ticks=true");
+		provider::add_member_control(this, "map_to_one_value", map_to_one_value, "value_slider", "min=-10;max=10;ticks=true");
+		provider::add_view("size_x", size[0]);
+		provider::add_view("size_y", size[1]);
+		provider::add_view("size_z", size[2]);
+	}
+};
+
+scene_factory_registration<volume<double> > sfr_volume("volume");